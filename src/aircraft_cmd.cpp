@@ -1373,6 +1373,7 @@ static void MaybeCrashAirplane(Aircraft *v)
 		st->goods[i].rating = 1;
 		st->goods[i].cargo.Truncate();
 	}
+	st->rating_cargoes = ALL_CARGOTYPES;
 
 	CrashAirplane(v);
 }
@@ -1803,30 +1804,18 @@ static bool AirportMove(Aircraft *v, const AirportFTAClass *apc)
 
 	v->previous_pos = v->pos; // save previous location
 
-	/* there is only one choice to move to */
-	if (current->next == nullptr) {
-		if (AirportSetBlocks(v, current, apc)) {
-			v->pos = current->next_position;
-			UpdateAircraftCache(v);
-		} // move to next position
-		return false;
+	/* choose the movement that matches our heading */
+	current = apc->GetTransition(v->pos, v->state);
+	if (current == nullptr) {
+		Debug(misc, 0, "[Ap] cannot move further on Airport! (pos {} state {}) for vehicle {}", v->pos, v->state, v->index);
+		NOT_REACHED();
 	}
 
-	/* there are more choices to choose from, choose the one that
-	 * matches our heading */
-	do {
-		if (v->state == current->heading || current->heading == TO_ALL) {
-			if (AirportSetBlocks(v, current, apc)) {
-				v->pos = current->next_position;
-				UpdateAircraftCache(v);
-			} // move to next position
-			return false;
-		}
-		current = current->next;
-	} while (current != nullptr);
-
-	Debug(misc, 0, "[Ap] cannot move further on Airport! (pos {} state {}) for vehicle {}", v->pos, v->state, v->index);
-	NOT_REACHED();
+	if (AirportSetBlocks(v, current, apc)) {
+		v->pos = current->next_position;
+		UpdateAircraftCache(v);
+	} // move to next position
+	return false;
 }
 
 /** returns true if the road ahead is busy, eg. you must wait before proceeding. */
@@ -1863,28 +1852,11 @@ static bool AirportHasBlock(Aircraft *v, const AirportFTA *current_pos, const Ai
  */
 static bool AirportSetBlocks(Aircraft *v, const AirportFTA *current_pos, const AirportFTAClass *apc)
 {
-	const AirportFTA *next = &apc->layout[current_pos->next_position];
-	const AirportFTA *reference = &apc->layout[v->pos];
+	assert(current_pos->position == v->pos);
 
 	/* if the next position is in another block, check it and wait until it is free */
-	if ((apc->layout[current_pos->position].block & next->block) != next->block) {
-		uint64 airport_flags = next->block;
-		/* search for all all elements in the list with the same state, and blocks != N
-		 * this means more blocks should be checked/set */
-		const AirportFTA *current = current_pos;
-		if (current == reference) current = current->next;
-		while (current != nullptr) {
-			if (current->heading == current_pos->heading && current->block != 0) {
-				airport_flags |= current->block;
-				break;
-			}
-			current = current->next;
-		}
-
-		/* if the block to be checked is in the next position, then exclude that from
-		 * checking, because it has been set by the airplane before */
-		if (current_pos->block == next->block) airport_flags ^= next->block;
-
+	uint64 airport_flags = current_pos->reserve_block;
+	if (airport_flags != 0) {
 		Station *st = Station::Get(v->targetairport);
 		if (st->airport.flags & airport_flags) {
 			v->cur_speed = 0;
@@ -1892,7 +1864,7 @@ static bool AirportSetBlocks(Aircraft *v, const AirportFTA *current_pos, const A
 			return false;
 		}
 
-		if (next->block != NOTHING_block) {
+		if (apc->layout[current_pos->next_position].block != NOTHING_block) {
 			SETBITS(st->airport.flags, airport_flags); // occupy next block
 		}
 	}
@@ -67,6 +67,7 @@ AIRPORT_GENERIC(dummy, nullptr, 0, AirportFTAClass::ALL, 0)
 
 static uint16 AirportGetNofElements(const AirportFTAbuildup *apFA);
 static AirportFTA *AirportBuildAutomata(uint nofelements, const AirportFTAbuildup *apFA);
+static const AirportFTA **AirportBuildTransitions(AirportFTA *layout, uint nofelements);
 
 
 /**
@@ -127,6 +128,7 @@ AirportFTAClass::AirportFTAClass(
 {
 	/* Build the state machine itself */
 	this->layout = AirportBuildAutomata(this->nofelements, apFA);
+	this->transitions = AirportBuildTransitions(this->layout, this->nofelements);
 }
 
 AirportFTAClass::~AirportFTAClass()
@@ -140,6 +142,7 @@ AirportFTAClass::~AirportFTAClass()
 		}
 	}
 	free(layout);
+	free(transitions);
 }
 
 /**
@@ -199,6 +202,89 @@ static AirportFTA *AirportBuildAutomata(uint nofelements, const AirportFTAbuildu
 	return FAutomata;
 }
 
+/**
+ * Get the blocks an aircraft has to check and occupy when it takes a movement.
+ * The movement has to start at the position of the aircraft.
+ * @param layout The FTA.
+ * @param current_pos The movement.
+ * @return The blocks.
+ */
+static uint64 AirportGetReserveBlock(const AirportFTA *layout, const AirportFTA *current_pos)
+{
+	const AirportFTA *next = &layout[current_pos->next_position];
+	const AirportFTA *reference = &layout[current_pos->position];
+
+	/* if the next position is in the same block, there is nothing to check */
+	if ((reference->block & next->block) == next->block) return 0;
+
+	uint64 airport_flags = next->block;
+	/* search for all all elements in the list with the same state, and blocks != N
+	 * this means more blocks should be checked/set */
+	const AirportFTA *current = current_pos;
+	if (current == reference) current = current->next;
+	while (current != nullptr) {
+		if (current->heading == current_pos->heading && current->block != 0) {
+			airport_flags |= current->block;
+			break;
+		}
+		current = current->next;
+	}
+
+	/* if the block to be checked is in the next position, then exclude that from
+	 * checking, because it has been set by the airplane before */
+	if (current_pos->block == next->block) airport_flags ^= next->block;
+
+	return airport_flags;
+}
+
+/**
+ * Get the movement an aircraft in a given state takes from a position.
+ * @param head The first movement from the position.
+ * @param state The state of the aircraft, or UINT_MAX for a state that matches no heading.
+ * @return The movement, or nullptr if there is none for the state.
+ */
+static const AirportFTA *AirportFindTransition(const AirportFTA *head, uint state)
+{
+	/* there is only one choice to move to */
+	if (head->next == nullptr) return head;
+
+	/* there are more choices to choose from, choose the one that
+	 * matches our heading */
+	for (const AirportFTA *current = head; current != nullptr; current = current->next) {
+		if (state == current->heading || current->heading == TO_ALL) return current;
+	}
+	return nullptr;
+}
+
+/**
+ * Compile the movements of an FTA into a table, so aircraft do not have to search them.
+ * @param layout The FTA; the blocks to reserve for its movements are filled in as well.
+ * @param nofelements The number of elements in the FTA.
+ * @return For every position and state the movement an aircraft takes. @see AirportFTAClass::GetTransition
+ */
+static const AirportFTA **AirportBuildTransitions(AirportFTA *layout, uint nofelements)
+{
+	for (uint i = 0; i < nofelements; i++) {
+		for (AirportFTA *current = &layout[i]; current != nullptr; current = current->next) {
+			/* Only these headings have their own column in the table. */
+			assert(current->heading <= MAX_HEADINGS || current->heading == TERMGROUP);
+			current->reserve_block = AirportGetReserveBlock(layout, current);
+		}
+	}
+
+	const uint columns = AirportFTAClass::NUM_TRANSITION_COLUMNS;
+	const AirportFTA **transitions = MallocT<const AirportFTA *>(nofelements * columns);
+	for (uint i = 0; i < nofelements; i++) {
+		for (uint state = 0; state <= MAX_HEADINGS; state++) {
+			transitions[i * columns + state] = AirportFindTransition(&layout[i], state);
+		}
+		transitions[i * columns + MAX_HEADINGS + 1] = AirportFindTransition(&layout[i], TERMGROUP);
+		/* Any other state does not match a heading; it can only take a movement for all headings. */
+		transitions[i * columns + MAX_HEADINGS + 2] = AirportFindTransition(&layout[i], UINT_MAX);
+	}
+	return transitions;
+}
+
 /**
  * Get the finite state machine of an airport type.
  * @param airport_type %Airport type to query FTA from. @see AirportTypes
@@ -173,8 +173,25 @@ public:
 		return &moving_data[position];
 	}
 
+	/**
+	 * Get the movement an aircraft takes from a position, when it has arrived there.
+	 * @param position Element number the aircraft is at.
+	 * @param state State (heading) of the aircraft.
+	 * @return The movement to take, or nullptr when there is none for the state.
+	 */
+	const struct AirportFTA *GetTransition(byte position, byte state) const
+	{
+		assert(position < nofelements);
+		uint column = state <= MAX_HEADINGS ? state : (state == TERMGROUP ? MAX_HEADINGS + 1 : MAX_HEADINGS + 2);
+		return transitions[position * NUM_TRANSITION_COLUMNS + column];
+	}
+
+	/** Number of transitions per position: one per heading, one for #TERMGROUP and one for any other state. */
+	static const uint NUM_TRANSITION_COLUMNS = MAX_HEADINGS + 3;
+
 	const AirportMovingData *moving_data; ///< Movement data.
 	struct AirportFTA *layout;            ///< state machine for airport
+	const struct AirportFTA **transitions; ///< For every position and state the movement an aircraft takes. @see GetTransition
 	const byte *terminals;                ///< %Array with the number of terminal groups, followed by the number of terminals in each group.
 	const byte num_helipads;              ///< Number of helipads on this airport. When 0 helicopters will go to normal terminals.
 	Flags flags;                          ///< Flags for this airport type.
@@ -190,6 +207,7 @@ DECLARE_ENUM_AS_BIT_SET(AirportFTAClass::Flags)
 struct AirportFTA {
 	AirportFTA *next;        ///< possible extra movement choices from this position
 	uint64 block;            ///< 64 bit blocks (st->airport.flags), should be enough for the most complex airports
+	uint64 reserve_block;    ///< Blocks to check and occupy when taking this movement, 0 when there is nothing to check.
 	byte position;           ///< the position that an airplane is at
 	byte next_position;      ///< next position from this position
 	byte heading;            ///< heading (current orders), guiding an airplane to its target on an airport
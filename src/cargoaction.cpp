@@ -203,9 +203,9 @@ bool StationCargoReroute::operator()(CargoPacket *cp)
 		this->destination->AddToCache(cp_new);
 	}
 
-	/* Legal, as insert doesn't invalidate iterators in the MultiMap, however
-	 * this might insert the packet between range.first and range.second (which might be end())
-	 * This is why we check for GetKey above to avoid infinite loops. */
+	/* Legal, as next != avoid, so the packet goes to a different range than the
+	 * one being iterated. It might still end up between range.first and range.second
+	 * (which might be end()). This is why we check for GetKey above to avoid infinite loops. */
 	this->destination->packets.Insert(next, cp_new);
 	return cp_new == cp;
 }
@@ -227,7 +227,7 @@ bool VehicleCargoReroute::operator()(CargoPacket *cp)
 		this->destination->AddToMeta(cp_new, VehicleCargoList::MTA_TRANSFER);
 	}
 
-	/* Legal, as front pushing doesn't invalidate iterators in std::list. */
+	/* Legal, as VehicleCargoList::ShiftCargo accounts for packets pushed to the front. */
 	this->destination->packets.push_front(cp_new);
 	return cp_new == cp;
 }
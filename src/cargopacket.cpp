@@ -14,6 +14,8 @@
 #include "economy_base.h"
 #include "cargoaction.h"
 #include "order_type.h"
+#include "profile_probe.h"
+#include <unordered_map>
 
 #include "safeguards.h"
 
@@ -21,6 +23,22 @@
 CargoPacketPool _cargopacket_pool("CargoPacket");
 INSTANTIATE_POOL_METHODS(CargoPacket)
 
+/** Cargo packets indexed by their source station, so they can be found quickly when the station is removed. */
+static std::unordered_map<StationID, std::vector<CargoPacket *>> _packets_by_station;
+/** Cargo packets indexed by their source_type and source_id, so they can be found quickly when the source is removed. */
+static std::unordered_map<uint32, std::vector<CargoPacket *>> _packets_by_source;
+
+/**
+ * Get the key for a source in the index of cargo packets by source.
+ * @param src_type Type of source.
+ * @param src Index of source.
+ * @return Key into _packets_by_source.
+ */
+static inline uint32 GetSourceIndexKey(SourceType src_type, SourceID src)
+{
+	return src_type << 16 | src;
+}
+
 /**
  * Create a new packet for savegame loading.
  */
@@ -52,6 +70,7 @@ CargoPacket::CargoPacket(StationID source, TileIndex source_xy, uint16 count, So
 {
 	assert(count != 0);
 	this->source_type  = source_type;
+	this->AddToSourceIndex();
 }
 
 /**
@@ -79,6 +98,67 @@ CargoPacket::CargoPacket(uint16 count, byte days_in_transit, StationID source, T
 {
 	assert(count != 0);
 	this->source_type = source_type;
+	this->AddToSourceIndex();
+}
+
+/**
+ * Destroy the packet and remove it from the index of packets by source.
+ */
+CargoPacket::~CargoPacket()
+{
+	if (CleaningPool()) {
+		/* All packets are going away; drop the index in one go. */
+		if (!_packets_by_station.empty()) _packets_by_station.clear();
+		if (!_packets_by_source.empty()) _packets_by_source.clear();
+		return;
+	}
+	this->RemoveFromSourceIndex();
+}
+
+/**
+ * Add this packet to the index of packets by source station and by
+ * source_type/source_id. Invalid sources are not indexed.
+ */
+void CargoPacket::AddToSourceIndex()
+{
+	if (this->source != INVALID_STATION) {
+		std::vector<CargoPacket *> &packets = _packets_by_station[this->source];
+		this->station_index_pos = (uint32)packets.size();
+		packets.push_back(this);
+	}
+	if (this->source_id != INVALID_SOURCE) {
+		std::vector<CargoPacket *> &packets = _packets_by_source[GetSourceIndexKey(this->source_type, this->source_id)];
+		this->source_index_pos = (uint32)packets.size();
+		packets.push_back(this);
+	}
+}
+
+/**
+ * Remove this packet from the index of packets by source. This has to be
+ * done before changing the source, source_type or source_id of the packet.
+ */
+void CargoPacket::RemoveFromSourceIndex()
+{
+	if (this->source != INVALID_STATION) {
+		auto it = _packets_by_station.find(this->source);
+		assert(it != _packets_by_station.end() && it->second[this->station_index_pos] == this);
+		std::vector<CargoPacket *> &packets = it->second;
+		CargoPacket *last = packets.back();
+		packets[this->station_index_pos] = last;
+		last->station_index_pos = this->station_index_pos;
+		packets.pop_back();
+		if (packets.empty()) _packets_by_station.erase(it);
+	}
+	if (this->source_id != INVALID_SOURCE) {
+		auto it = _packets_by_source.find(GetSourceIndexKey(this->source_type, this->source_id));
+		assert(it != _packets_by_source.end() && it->second[this->source_index_pos] == this);
+		std::vector<CargoPacket *> &packets = it->second;
+		CargoPacket *last = packets.back();
+		packets[this->source_index_pos] = last;
+		last->source_index_pos = this->source_index_pos;
+		packets.pop_back();
+		if (packets.empty()) _packets_by_source.erase(it);
+	}
 }
 
 /**
@@ -126,9 +206,11 @@ void CargoPacket::Reduce(uint count)
  */
 /* static */ void CargoPacket::InvalidateAllFrom(SourceType src_type, SourceID src)
 {
-	for (CargoPacket *cp : CargoPacket::Iterate()) {
-		if (cp->source_type == src_type && cp->source_id == src) cp->source_id = INVALID_SOURCE;
-	}
+	auto it = _packets_by_source.find(GetSourceIndexKey(src_type, src));
+	if (it == _packets_by_source.end()) return;
+
+	for (CargoPacket *cp : it->second) cp->source_id = INVALID_SOURCE;
+	_packets_by_source.erase(it);
 }
 
 /**
@@ -137,9 +219,11 @@ void CargoPacket::Reduce(uint count)
  */
 /* static */ void CargoPacket::InvalidateAllFrom(StationID sid)
 {
-	for (CargoPacket *cp : CargoPacket::Iterate()) {
-		if (cp->source == sid) cp->source = INVALID_STATION;
-	}
+	auto it = _packets_by_station.find(sid);
+	if (it == _packets_by_station.end()) return;
+
+	for (CargoPacket *cp : it->second) cp->source = INVALID_STATION;
+	_packets_by_station.erase(it);
 }
 
 /*
@@ -252,6 +336,7 @@ void VehicleCargoList::Append(CargoPacket *cp, MoveToAction action)
 	assert(cp != nullptr);
 	assert(action == MTA_LOAD ||
 			(action == MTA_KEEP && this->action_counts[MTA_LOAD] == 0));
+	this->UpdateAge();
 	this->AddToMeta(cp, action);
 
 	if (this->count == cp->count) {
@@ -284,11 +369,15 @@ void VehicleCargoList::Append(CargoPacket *cp, MoveToAction action)
 template<class Taction>
 void VehicleCargoList::ShiftCargo(Taction action)
 {
-	Iterator it(this->packets.begin());
-	while (it != this->packets.end() && action.MaxMove() > 0) {
-		CargoPacket *cp = *it;
+	/* Work with positions rather than iterators, as the action may push
+	 * packets to the front of this very list (see VehicleCargoReroute). */
+	size_t pos = 0;
+	while (pos < this->packets.size() && action.MaxMove() > 0) {
+		CargoPacket *cp = this->packets[pos];
+		size_t size = this->packets.size();
 		if (action(cp)) {
-			it = this->packets.erase(it);
+			pos += this->packets.size() - size;
+			this->packets.erase(this->packets.begin() + pos);
 		} else {
 			break;
 		}
@@ -306,18 +395,10 @@ void VehicleCargoList::ShiftCargo(Taction action)
 template<class Taction>
 void VehicleCargoList::PopCargo(Taction action)
 {
-	if (this->packets.empty()) return;
-	Iterator it(--(this->packets.end()));
-	Iterator begin(this->packets.begin());
-	while (action.MaxMove() > 0) {
-		CargoPacket *cp = *it;
+	while (!this->packets.empty() && action.MaxMove() > 0) {
+		CargoPacket *cp = this->packets.back();
 		if (action(cp)) {
-			if (it != begin) {
-				this->packets.erase(it--);
-			} else {
-				this->packets.erase(it);
-				break;
-			}
+			this->packets.pop_back();
 		} else {
 			break;
 		}
@@ -334,6 +415,11 @@ void VehicleCargoList::RemoveFromCache(const CargoPacket *cp, uint count)
 {
 	this->feeder_share -= cp->FeederShare(count);
 	this->Parent::RemoveFromCache(cp, count);
+	if (cp->days_in_transit == 0xFF) {
+		this->capped_count -= count;
+	} else {
+		this->cargo_days_in_transit -= this->age_pending * count;
+	}
 }
 
 /**
@@ -345,6 +431,12 @@ void VehicleCargoList::AddToCache(const CargoPacket *cp)
 {
 	this->feeder_share += cp->feeder_share;
 	this->Parent::AddToCache(cp);
+	if (cp->days_in_transit == 0xFF) {
+		this->capped_count += cp->count;
+	} else {
+		this->cargo_days_in_transit += this->age_pending * cp->count;
+		this->age_headroom = std::min<uint>(this->age_headroom, 0xFF - cp->days_in_transit);
+	}
 }
 
 /**
@@ -376,18 +468,38 @@ void VehicleCargoList::AddToMeta(const CargoPacket *cp, MoveToAction action)
 }
 
 /**
- * Ages the all cargo in this list.
+ * Ages the all cargo in this list. The packets themselves are only updated
+ * when they are accessed next or when one of them would reach the maximum
+ * days in transit. Until then only the cached sum is increased.
  */
 void VehicleCargoList::AgeCargo()
 {
-	for (ConstIterator it(this->packets.begin()); it != this->packets.end(); it++) {
-		CargoPacket *cp = *it;
+	if (this->age_pending == this->age_headroom) this->ApplyAge();
+
+	this->age_pending++;
+	this->cargo_days_in_transit += this->count - this->capped_count;
+}
+
+/**
+ * Apply the pending ageing to all packets and recalculate how often the
+ * cargo can be aged before that has to be done again.
+ */
+void VehicleCargoList::ApplyAge()
+{
+	this->age_headroom = 0xFF;
+	for (CargoPacket *cp : this->packets) {
 		/* If we're at the maximum, then we can't increase no more. */
 		if (cp->days_in_transit == 0xFF) continue;
 
-		cp->days_in_transit++;
-		this->cargo_days_in_transit += cp->count;
+		assert(cp->days_in_transit + this->age_pending <= 0xFF);
+		cp->days_in_transit += this->age_pending;
+		if (cp->days_in_transit == 0xFF) {
+			this->capped_count += cp->count;
+		} else {
+			this->age_headroom = std::min<uint>(this->age_headroom, 0xFF - cp->days_in_transit);
+		}
 	}
+	this->age_pending = 0;
 }
 
 /**
@@ -447,19 +559,23 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 {
 	this->AssertCountConsistency();
 	assert(this->action_counts[MTA_LOAD] == 0);
+	this->UpdateAge();
 	this->action_counts[MTA_TRANSFER] = this->action_counts[MTA_DELIVER] = this->action_counts[MTA_KEEP] = 0;
-	Iterator deliver = this->packets.end();
-	Iterator it = this->packets.begin();
+	/* Packets to be transferred go to the front in reverse order, followed by
+	 * the ones to be delivered and then the ones to be kept. */
+	std::vector<CargoPacket *> transfers;
+	std::vector<CargoPacket *> delivers;
+	std::vector<CargoPacket *> keeps;
+	size_t pos = 0;
 	uint sum = 0;
 
 	bool force_keep = (order_flags & OUFB_NO_UNLOAD) != 0;
 	bool force_unload = (order_flags & OUFB_UNLOAD) != 0;
 	bool force_transfer = (order_flags & (OUFB_TRANSFER | OUFB_UNLOAD)) != 0;
-	assert(this->count > 0 || it == this->packets.end());
+	assert(this->count > 0 || this->packets.empty());
 	while (sum < this->count) {
-		CargoPacket *cp = *it;
+		CargoPacket *cp = this->packets[pos++];
 
-		this->packets.erase(it++);
 		StationID cargo_next = INVALID_STATION;
 		MoveToAction action = MTA_LOAD;
 		if (force_keep) {
@@ -490,7 +606,9 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 			/* Rewrite an invalid source station to some random other one to
 			 * avoid keeping the cargo in the vehicle forever. */
 			if (cp->source == INVALID_STATION && !ge->flows.empty()) {
+				cp->RemoveFromSourceIndex();
 				cp->source = ge->flows.begin()->first;
+				cp->AddToSourceIndex();
 			}
 			bool restricted = false;
 			FlowStatMap::const_iterator flow_it(ge->flows.find(cp->source));
@@ -510,14 +628,13 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 		Money share;
 		switch (action) {
 			case MTA_KEEP:
-				this->packets.push_back(cp);
-				if (deliver == this->packets.end()) --deliver;
+				keeps.push_back(cp);
 				break;
 			case MTA_DELIVER:
-				this->packets.insert(deliver, cp);
+				delivers.push_back(cp);
 				break;
 			case MTA_TRANSFER:
-				this->packets.push_front(cp);
+				transfers.push_back(cp);
 				/* Add feeder share here to allow reusing field for next station. */
 				share = payment->PayTransfer(cp, cp->count);
 				cp->AddFeederShare(share);
@@ -530,6 +647,10 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 		this->action_counts[action] += cp->count;
 		sum += cp->count;
 	}
+	assert(pos == this->packets.size());
+	this->packets.assign(transfers.rbegin(), transfers.rend());
+	this->packets.insert(this->packets.end(), delivers.begin(), delivers.end());
+	this->packets.insert(this->packets.end(), keeps.begin(), keeps.end());
 	this->AssertCountConsistency();
 	return this->action_counts[MTA_DELIVER] > 0 || this->action_counts[MTA_TRANSFER] > 0;
 }
@@ -538,6 +659,7 @@ bool VehicleCargoList::Stage(bool accepted, StationID current_station, StationID
 void VehicleCargoList::InvalidateCache()
 {
 	this->feeder_share = 0;
+	this->capped_count = 0;
 	this->Parent::InvalidateCache();
 }
 
@@ -575,16 +697,18 @@ template<>
 uint VehicleCargoList::Reassign<VehicleCargoList::MTA_DELIVER, VehicleCargoList::MTA_TRANSFER>(uint max_move, TileOrStationID next_station)
 {
 	max_move = std::min(this->action_counts[MTA_DELIVER], max_move);
+	this->UpdateAge();
 
 	uint sum = 0;
-	for (Iterator it(this->packets.begin()); sum < this->action_counts[MTA_TRANSFER] + max_move;) {
-		CargoPacket *cp = *it++;
+	for (size_t pos = 0; sum < this->action_counts[MTA_TRANSFER] + max_move;) {
+		CargoPacket *cp = this->packets[pos++];
 		sum += cp->Count();
 		if (sum <= this->action_counts[MTA_TRANSFER]) continue;
 		if (sum > this->action_counts[MTA_TRANSFER] + max_move) {
 			CargoPacket *cp_split = cp->Split(sum - this->action_counts[MTA_TRANSFER] + max_move);
 			sum -= cp_split->Count();
-			this->packets.insert(it, cp_split);
+			/* Insert the split off part behind cp and skip it. */
+			this->packets.insert(this->packets.begin() + pos++, cp_split);
 		}
 		cp->next_station = next_station;
 	}
@@ -604,6 +728,7 @@ uint VehicleCargoList::Reassign<VehicleCargoList::MTA_DELIVER, VehicleCargoList:
 uint VehicleCargoList::Return(uint max_move, StationCargoList *dest, StationID next)
 {
 	max_move = std::min(this->action_counts[MTA_LOAD], max_move);
+	this->UpdateAge();
 	this->PopCargo(CargoReturn(this, dest, max_move, next));
 	return max_move;
 }
@@ -617,6 +742,7 @@ uint VehicleCargoList::Return(uint max_move, StationCargoList *dest, StationID n
 uint VehicleCargoList::Shift(uint max_move, VehicleCargoList *dest)
 {
 	max_move = std::min(this->count, max_move);
+	this->UpdateAge();
 	this->PopCargo(CargoShift(this, dest, max_move));
 	return max_move;
 }
@@ -632,6 +758,7 @@ uint VehicleCargoList::Shift(uint max_move, VehicleCargoList *dest)
 uint VehicleCargoList::Unload(uint max_move, StationCargoList *dest, CargoPayment *payment)
 {
 	uint moved = 0;
+	this->UpdateAge();
 	if (this->action_counts[MTA_TRANSFER] > 0) {
 		uint move = std::min(this->action_counts[MTA_TRANSFER], max_move);
 		this->ShiftCargo(CargoTransfer(this, dest, move));
@@ -654,6 +781,7 @@ uint VehicleCargoList::Unload(uint max_move, StationCargoList *dest, CargoPaymen
 uint VehicleCargoList::Truncate(uint max_move)
 {
 	max_move = std::min(this->count, max_move);
+	this->UpdateAge();
 	this->PopCargo(CargoRemoval<VehicleCargoList>(this, max_move));
 	return max_move;
 }
@@ -669,6 +797,8 @@ uint VehicleCargoList::Truncate(uint max_move)
 uint VehicleCargoList::Reroute(uint max_move, VehicleCargoList *dest, StationID avoid, StationID avoid2, const GoodsEntry *ge)
 {
 	max_move = std::min(this->action_counts[MTA_TRANSFER], max_move);
+	this->UpdateAge();
+	dest->UpdateAge();
 	this->ShiftCargo(VehicleCargoReroute(this, dest, max_move, avoid, avoid2, ge));
 	return max_move;
 }
@@ -758,6 +888,9 @@ uint StationCargoList::ShiftCargo(Taction action, StationIDStack next, bool incl
 	return max_move - action.MaxMove();
 }
 
+/** Probe for profiling StationCargoList::Truncate. */
+static ProfileProbe _probe_station_cargo_truncate("StationCargoList::Truncate");
+
 /**
  * Truncates where each destination loses roughly the same percentage of its
  * cargo. This is done by randomizing the selection of packets to be removed.
@@ -768,7 +901,10 @@ uint StationCargoList::ShiftCargo(Taction action, StationIDStack next, bool incl
  */
 uint StationCargoList::Truncate(uint max_move, StationCargoAmountMap *cargo_per_source)
 {
+	ProfileScope profile(_probe_station_cargo_truncate);
+
 	max_move = std::min(max_move, this->count);
+	_probe_station_cargo_truncate.Count(max_move);
 	uint prev_count = this->count;
 	uint moved = 0;
 	uint loop = 0;
@@ -18,7 +18,7 @@
 #include "vehicle_type.h"
 #include "core/multimap.hpp"
 #include "saveload/saveload.h"
-#include <list>
+#include <deque>
 
 /** Unique identifier for a single cargo packet. */
 typedef uint32 CargoPacketID;
@@ -53,6 +53,8 @@ private:
 		TileOrStationID loaded_at_xy; ///< Location where this cargo has been loaded into the vehicle.
 		TileOrStationID next_station; ///< Station where the cargo wants to go next.
 	};
+	uint32 station_index_pos; ///< Position of this packet in the list of packets with the same source station.
+	uint32 source_index_pos;  ///< Position of this packet in the list of packets with the same source_type and source_id.
 
 	/** The CargoList caches, thus needs to know about it. */
 	template <class Tinst, class Tcont> friend class CargoList;
@@ -68,8 +70,7 @@ public:
 	CargoPacket(StationID source, TileIndex source_xy, uint16 count, SourceType source_type, SourceID source_id);
 	CargoPacket(uint16 count, byte days_in_transit, StationID source, TileIndex source_xy, TileIndex loaded_at_xy, Money feeder_share = 0, SourceType source_type = ST_INDUSTRY, SourceID source_id = INVALID_SOURCE);
 
-	/** Destroy the packet. */
-	~CargoPacket() { }
+	~CargoPacket();
 
 	CargoPacket *Split(uint new_size);
 	void Merge(CargoPacket *cp);
@@ -188,6 +189,9 @@ public:
 		return this->next_station;
 	}
 
+	void AddToSourceIndex();
+	void RemoveFromSourceIndex();
+
 	static void InvalidateAllFrom(SourceType src_type, SourceID src);
 	static void InvalidateAllFrom(StationID sid);
 	static void AfterLoad();
@@ -261,7 +265,7 @@ public:
 	void InvalidateCache();
 };
 
-typedef std::list<CargoPacket *> CargoPacketList;
+typedef std::deque<CargoPacket *> CargoPacketList;
 
 /**
  * CargoList that is used for vehicles.
@@ -273,6 +277,9 @@ protected:
 
 	Money feeder_share;                     ///< Cache for the feeder share.
 	uint action_counts[NUM_MOVE_TO_ACTION]; ///< Counts of cargo to be transferred, delivered, kept and loaded.
+	uint capped_count;                      ///< Cache for the amount of cargo in packets that have been in transit for 0xFF days.
+	byte age_pending;                       ///< Number of times the cargo has been aged without updating the packets yet.
+	byte age_headroom;                      ///< Lower bound for the number of times the cargo can be aged before a packet reaches 0xFF days in transit.
 
 	template<class Taction>
 	void ShiftCargo(Taction action);
@@ -280,6 +287,8 @@ protected:
 	template<class Taction>
 	void PopCargo(Taction action);
 
+	void ApplyAge();
+
 	/**
 	 * Assert that the designation counts add up.
 	 */
@@ -394,6 +403,15 @@ public:
 
 	void AgeCargo();
 
+	/**
+	 * Bring the days in transit of all packets up to date. This has to be
+	 * done before packets are read, added or removed.
+	 */
+	inline void UpdateAge()
+	{
+		if (this->age_pending != 0) this->ApplyAge();
+	}
+
 	void InvalidateCache();
 
 	void SetTransferLoadPlace(TileIndex xy);
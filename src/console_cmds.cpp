@@ -42,6 +42,12 @@
 #include "game/game.hpp"
 #include "table/strings.h"
 #include "walltime_func.h"
+#include "gfx_layout.h"
+#include "profile_probe.h"
+#include "pathfinder/pathfinder_log.h"
+#include "vehicle_func.h"
+#include "signal_func.h"
+#include "pbs.h"
 
 #include "safeguards.h"
 
@@ -243,6 +249,8 @@ DEF_CONSOLE_CMD(ConResetTile)
 		uint32 result;
 		if (GetArgumentInteger(&result, argv[1])) {
 			DoClearSquare((TileIndex)result);
+			InvalidateSignalSegmentCache();
+			InvalidateReservationCache();
 			return true;
 		}
 	}
@@ -1414,11 +1422,12 @@ DEF_CONSOLE_CMD(ConAlias)
 DEF_CONSOLE_CMD(ConScreenShot)
 {
 	if (argc == 0) {
-		IConsolePrint(CC_HELP, "Create a screenshot of the game. Usage: 'screenshot [viewport | normal | big | giant | heightmap | minimap] [no_con] [size <width> <height>] [<filename>]'.");
+		IConsolePrint(CC_HELP, "Create a screenshot of the game. Usage: 'screenshot [viewport | normal | big | giant | tiles | heightmap | minimap] [no_con] [size <width> <height>] [<filename>]'.");
 		IConsolePrint(CC_HELP, "  'viewport' (default) makes a screenshot of the current viewport (including menus, windows).");
 		IConsolePrint(CC_HELP, "  'normal' makes a screenshot of the visible area.");
 		IConsolePrint(CC_HELP, "  'big' makes a zoomed-in screenshot of the visible area.");
 		IConsolePrint(CC_HELP, "  'giant' makes a screenshot of the whole map.");
+		IConsolePrint(CC_HELP, "  'tiles' makes a screenshot of the whole map as a pyramid of PNG tiles (<zoom>/<x>/<y>.png) for zoomable maps.");
 		IConsolePrint(CC_HELP, "  'heightmap' makes a heightmap screenshot of the map that can be loaded in as heightmap.");
 		IConsolePrint(CC_HELP, "  'minimap' makes a top-viewed minimap screenshot of the whole world which represents one tile by one pixel.");
 		IConsolePrint(CC_HELP, "  'no_con' hides the console to create the screenshot (only useful in combination with 'viewport').");
@@ -1447,6 +1456,9 @@ DEF_CONSOLE_CMD(ConScreenShot)
 		} else if (strcmp(argv[arg_index], "giant") == 0) {
 			type = SC_WORLD;
 			arg_index += 1;
+		} else if (strcmp(argv[arg_index], "tiles") == 0) {
+			type = SC_WORLD_TILES;
+			arg_index += 1;
 		} else if (strcmp(argv[arg_index], "heightmap") == 0) {
 			type = SC_HEIGHTMAP;
 			arg_index += 1;
@@ -2108,6 +2120,102 @@ DEF_CONSOLE_CMD(ConNewGRFProfile)
 	return false;
 }
 
+DEF_CONSOLE_CMD(ConProfile)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Collect performance data about parts of the game logic. Sub-commands can be abbreviated.");
+		IConsolePrint(CC_HELP, "Usage: 'profile start':");
+		IConsolePrint(CC_HELP, "  Discard the data collected so far and begin collecting.");
+		IConsolePrint(CC_HELP, "Usage: 'profile stop':");
+		IConsolePrint(CC_HELP, "  End collecting data.");
+		IConsolePrint(CC_HELP, "Usage: 'profile [print]':");
+		IConsolePrint(CC_HELP, "  Show the data collected so far.");
+		IConsolePrint(CC_HELP, "Usage: 'profile write [<filename>]':");
+		IConsolePrint(CC_HELP, "  Write the data collected so far in the folded stacks format of flame graph tools.");
+		return true;
+	}
+
+	/* "print" sub-command */
+	if (argc == 1 || strncasecmp(argv[1], "pri", 3) == 0) {
+		PrintProfile();
+		return true;
+	}
+
+	/* "start" sub-command */
+	if (strncasecmp(argv[1], "sta", 3) == 0) {
+		StartProfiling();
+		IConsolePrint(CC_DEBUG, "Started profiling.");
+		return true;
+	}
+
+	/* "stop" sub-command */
+	if (strncasecmp(argv[1], "sto", 3) == 0) {
+		StopProfiling();
+		IConsolePrint(CC_DEBUG, "Stopped profiling.");
+		return true;
+	}
+
+	/* "write" sub-command */
+	if (strncasecmp(argv[1], "wri", 3) == 0) {
+		std::string filename = argc >= 3 ? argv[2] : GetProfileFilename();
+		if (!WriteProfile(filename)) {
+			IConsolePrint(CC_ERROR, "Could not write profile to '{}'.", filename);
+			return true;
+		}
+		IConsolePrint(CC_DEBUG, "Written profile to '{}'.", filename);
+		return true;
+	}
+
+	return false;
+}
+
+DEF_CONSOLE_CMD(ConPathfinderLog)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Log pathfinder queries, to compare the results and performance of pathfinders between builds. Sub-commands can be abbreviated.");
+		IConsolePrint(CC_HELP, "Usage: 'pathfinder_log start <filename>':");
+		IConsolePrint(CC_HELP, "  Begin writing every query for the track a vehicle should take to the file.");
+		IConsolePrint(CC_HELP, "Usage: 'pathfinder_log stop':");
+		IConsolePrint(CC_HELP, "  End logging, and show the totals of every pathfinder.");
+		IConsolePrint(CC_HELP, "Usage: 'pathfinder_log compare <filename1> <filename2>':");
+		IConsolePrint(CC_HELP, "  Compare two logs of the same savegame and number of ticks, e.g. made by two builds.");
+		IConsolePrint(CC_HELP, "  Shows the first query with a different result, or the totals of both logs.");
+		return true;
+	}
+
+	if (argc < 2) return false;
+
+	/* "start" sub-command */
+	if (strncasecmp(argv[1], "sta", 3) == 0) {
+		if (argc < 3) return false;
+		if (!StartPathfinderLog(argv[2])) {
+			IConsolePrint(CC_ERROR, "Could not open '{}' for writing.", argv[2]);
+			return true;
+		}
+		IConsolePrint(CC_DEBUG, "Started logging pathfinder queries to '{}'.", argv[2]);
+		return true;
+	}
+
+	/* "stop" sub-command */
+	if (strncasecmp(argv[1], "sto", 3) == 0) {
+		StopPathfinderLog();
+		IConsolePrint(CC_DEBUG, "Stopped logging pathfinder queries.");
+		PrintPathfinderLogSummary();
+		return true;
+	}
+
+	/* "compare" sub-command */
+	if (strncasecmp(argv[1], "com", 3) == 0) {
+		if (argc < 4) return false;
+		if (!ComparePathfinderLogs(argv[2], argv[3])) {
+			IConsolePrint(CC_ERROR, "Could not read '{}' and '{}'.", argv[2], argv[3]);
+		}
+		return true;
+	}
+
+	return false;
+}
+
 #ifdef _DEBUG
 /******************
  *  debug commands
@@ -2152,6 +2260,41 @@ DEF_CONSOLE_CMD(ConFramerateWindow)
 	return true;
 }
 
+/**
+ * Print the hit rate of a cache.
+ * @param name Name of the cache.
+ * @param hits Number of requests served from the cache.
+ * @param misses Number of requests not served from the cache.
+ */
+static void ConPrintCacheHitRate(const char *name, uint64 hits, uint64 misses)
+{
+	uint64 total = hits + misses;
+	IConsolePrint(CC_DEFAULT, "  {}: {} hits, {} misses ({:.1f}% hit rate)", name, hits, misses, total == 0 ? 0.0 : 100.0 * hits / total);
+}
+
+DEF_CONSOLE_CMD(ConTextCache)
+{
+	if (argc == 0) {
+		IConsolePrint(CC_HELP, "Show statistics of the text layout and glyph caches. Usage: 'textcache [reset]'.");
+		return true;
+	}
+
+	if (argc > 2) return false;
+
+	if (argc == 2) {
+		if (strcasecmp(argv[1], "reset") != 0) return false;
+		Layouter::linecache_hits = Layouter::linecache_misses = 0;
+		FontCache::glyph_hits = FontCache::glyph_misses = FontCache::glyph_evictions = 0;
+		return true;
+	}
+
+	IConsolePrint(CC_INFO, "Text cache statistics:");
+	ConPrintCacheHitRate("Line cache", Layouter::linecache_hits, Layouter::linecache_misses);
+	ConPrintCacheHitRate("Glyph cache", FontCache::glyph_hits, FontCache::glyph_misses);
+	IConsolePrint(CC_DEFAULT, "  Glyphs evicted: {}", FontCache::glyph_evictions);
+	return true;
+}
+
 static void ConDumpRoadTypes()
 {
 	IConsolePrint(CC_DEFAULT, "  Flags:");
@@ -2277,13 +2420,23 @@ static void ConDumpCargoTypes()
 	}
 }
 
+static void ConDumpVehicleHash()
+{
+	VehicleTileHashStats stats = GetVehicleTileHashStats();
+
+	IConsolePrint(CC_DEFAULT, "  Vehicle tile hash: {} buckets of {}x{} tiles", stats.buckets, stats.chunk_size, stats.chunk_size);
+	IConsolePrint(CC_DEFAULT, "  Used buckets: {} ({:.1f}%)", stats.used_buckets, stats.buckets == 0 ? 0.0 : 100.0 * stats.used_buckets / stats.buckets);
+	IConsolePrint(CC_DEFAULT, "  Vehicles: {}, average per used bucket: {:.2f}, most in one bucket: {}",
+			stats.vehicles, stats.used_buckets == 0 ? 0.0 : (double)stats.vehicles / stats.used_buckets, stats.longest_chain);
+}
+
 
 DEF_CONSOLE_CMD(ConDumpInfo)
 {
 	if (argc != 2) {
 		IConsolePrint(CC_HELP, "Dump debugging information.");
-		IConsolePrint(CC_HELP, "Usage: 'dump_info roadtypes|railtypes|cargotypes'.");
-		IConsolePrint(CC_HELP, "  Show information about road/tram types, rail types or cargo types.");
+		IConsolePrint(CC_HELP, "Usage: 'dump_info roadtypes|railtypes|cargotypes|vehiclehash'.");
+		IConsolePrint(CC_HELP, "  Show information about road/tram types, rail types, cargo types or the occupancy of the vehicle tile hash.");
 		return true;
 	}
 
@@ -2302,6 +2455,11 @@ DEF_CONSOLE_CMD(ConDumpInfo)
 		return true;
 	}
 
+	if (strcasecmp(argv[1], "vehiclehash") == 0) {
+		ConDumpVehicleHash();
+		return true;
+	}
+
 	return false;
 }
 
@@ -2438,10 +2596,13 @@ void IConsoleStdLibRegister()
 #endif
 	IConsole::CmdRegister("fps",                     ConFramerate);
 	IConsole::CmdRegister("fps_wnd",                 ConFramerateWindow);
+	IConsole::CmdRegister("textcache",               ConTextCache);
 
 	/* NewGRF development stuff */
 	IConsole::CmdRegister("reload_newgrfs",          ConNewGRFReload,     ConHookNewGRFDeveloperTool);
 	IConsole::CmdRegister("newgrf_profile",          ConNewGRFProfile,    ConHookNewGRFDeveloperTool);
+	IConsole::CmdRegister("profile",                 ConProfile);
+	IConsole::CmdRegister("pathfinder_log",          ConPathfinderLog);
 
 	IConsole::CmdRegister("dump_info",               ConDumpInfo);
 }
@@ -0,0 +1,100 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file timer_wheel.hpp Deterministic scheduling of periodic work on pool items. */
+
+#ifndef TIMER_WHEEL_HPP
+#define TIMER_WHEEL_HPP
+
+#include <vector>
+#include <algorithm>
+
+/**
+ * Timer wheel for items that only need attention every now and then.
+ * Instead of visiting every item every tick, items are put in the slot of
+ * the tick they are due. Items due further ahead than the number of slots
+ * stay in their slot for another lap. Items that are due at the same tick
+ * are returned in index order, so processing them in that order gives the
+ * same result as scanning the whole pool.
+ * @tparam Tindex Index type of the scheduled items.
+ * @tparam Tslots Number of slots; should be about the usual interval between visits.
+ */
+template <typename Tindex, uint Tslots>
+class TimerWheel {
+	typedef std::pair<uint64, Tindex> Entry; ///< Tick the item is due and its index.
+
+	std::vector<Entry> slots[Tslots]; ///< Scheduled items by the tick they are due, modulo Tslots.
+	uint64 now = 0;                   ///< Number of ticks the wheel has advanced.
+
+public:
+	/**
+	 * Get the tick the wheel is currently at.
+	 * @return Number of times Advance has been called since the last Clear.
+	 */
+	inline uint64 Now() const
+	{
+		return this->now;
+	}
+
+	/**
+	 * Schedule an item.
+	 * @param index Item to schedule.
+	 * @param due Tick the item is due; must be in the future.
+	 */
+	inline void Schedule(Tindex index, uint64 due)
+	{
+		assert(due > this->now);
+		this->slots[due % Tslots].emplace_back(due, index);
+	}
+
+	/**
+	 * Remove an item from the schedule.
+	 * Nothing happens if the item was not scheduled, e.g. because it is being processed.
+	 * @param index Item to remove.
+	 * @param due Tick the item was scheduled for.
+	 */
+	void Unschedule(Tindex index, uint64 due)
+	{
+		std::vector<Entry> &slot = this->slots[due % Tslots];
+		auto it = std::find(slot.begin(), slot.end(), Entry(due, index));
+		if (it == slot.end()) return;
+		*it = slot.back();
+		slot.pop_back();
+	}
+
+	/**
+	 * Advance the wheel by one tick and take out the items due in it.
+	 * @param[out] due Items that are due, in index order.
+	 */
+	void Advance(std::vector<Tindex> &due)
+	{
+		this->now++;
+		due.clear();
+
+		std::vector<Entry> &slot = this->slots[this->now % Tslots];
+		auto keep = slot.begin();
+		for (const Entry &entry : slot) {
+			if (entry.first == this->now) {
+				due.push_back(entry.second);
+			} else {
+				*keep++ = entry;
+			}
+		}
+		slot.erase(keep, slot.end());
+
+		std::sort(due.begin(), due.end());
+	}
+
+	/** Remove all items and restart at tick 0. */
+	void Clear()
+	{
+		for (std::vector<Entry> &slot : this->slots) slot.clear();
+		this->now = 0;
+	}
+};
+
+#endif /* TIMER_WHEEL_HPP */
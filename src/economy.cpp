@@ -48,6 +48,7 @@
 #include "goal_base.h"
 #include "story_base.h"
 #include "linkgraph/refresh.h"
+#include "profile_probe.h"
 
 #include "table/strings.h"
 #include "table/pricebase.h"
@@ -480,6 +481,10 @@ void ChangeOwnershipOfCompanyItems(Owner old_owner, Owner new_owner)
 			ChangeTileOwner(tile, old_owner, new_owner);
 		} while (++tile != MapSize());
 
+		/* Signal blocks and reservations end where the owner of the track changes. */
+		InvalidateSignalSegmentCache();
+		InvalidateReservationCache();
+
 		if (new_owner != INVALID_OWNER) {
 			/* Update all signals because there can be new segment that was owned by two companies
 			 * and signals were not propagated
@@ -1252,6 +1257,7 @@ void PrepareUnload(Vehicle *front_v)
 {
 	Station *curr_station = Station::Get(front_v->last_station_visited);
 	curr_station->loading_vehicles.push_back(front_v);
+	UpdateLoadingStation(curr_station);
 
 	/* At this moment loading cannot be finished */
 	ClrBit(front_v->vehicle_flags, VF_LOADING_FINISHED);
@@ -1541,6 +1547,9 @@ struct ReserveCargoAction {
 
 	bool operator()(Vehicle *v)
 	{
+		/* Reserving from an empty cargo list wouldn't do anything. */
+		if (st->goods[v->cargo_type].cargo.AvailableCount() == 0) return true;
+
 		if (v->cargo_cap > v->cargo.RemainingCount() && MayLoadUnderExclusiveRights(st, v)) {
 			st->goods[v->cargo_type].cargo.Reserve(v->cargo_cap - v->cargo.RemainingCount(),
 					&v->cargo, st->xy, *next_station);
@@ -1603,22 +1612,32 @@ static void UpdateLoadUnloadTicks(Vehicle *front, const Station *st, int ticks)
 	front->load_unload_ticks = std::max(1, ticks);
 }
 
+/** Probe for profiling LoadUnloadVehicle. */
+static ProfileProbe _probe_load_unload_vehicle("LoadUnloadVehicle");
+
 /**
  * Loads/unload the vehicle if possible.
  * @param front the vehicle to be (un)loaded
  */
 static void LoadUnloadVehicle(Vehicle *front)
 {
+	ProfileScope profile(_probe_load_unload_vehicle);
+
 	assert(front->current_order.IsType(OT_LOADING));
 
 	StationID last_visited = front->last_station_visited;
 	Station *st = Station::Get(last_visited);
 
-	StationIDStack next_station = front->GetNextStoppingStation();
 	bool use_autorefit = front->current_order.IsRefit() && front->current_order.GetRefitCargo() == CT_AUTO_REFIT;
+	bool reserve = _settings_game.order.improved_load && use_autorefit ?
+			front->cargo_payment == nullptr : (front->current_order.GetLoadType() & OLFB_FULL_LOAD) != 0;
+
+	/* Most vehicles are just waiting; don't bother looking at their orders then. */
+	if (!reserve && front->load_unload_ticks != 0) return;
+
+	StationIDStack next_station = front->GetNextStoppingStation();
 	CargoArray consist_capleft;
-	if (_settings_game.order.improved_load && use_autorefit ?
-			front->cargo_payment == nullptr : (front->current_order.GetLoadType() & OLFB_FULL_LOAD) != 0) {
+	if (reserve) {
 		ReserveConsist(st, front,
 				(use_autorefit && front->load_unload_ticks != 0) ? &consist_capleft : nullptr,
 				&next_station);
@@ -1701,6 +1720,7 @@ static void LoadUnloadVehicle(Vehicle *front)
 					 * first unload to prevent the cargo from quickly decaying after the initial drop. */
 					ge->time_since_pickup = 0;
 					SetBit(ge->status, GoodsEntry::GES_RATING);
+					SetBit(st->rating_cargoes, v->cargo_type);
 				}
 			}
 
@@ -1912,6 +1932,9 @@ static void LoadUnloadVehicle(Vehicle *front)
 	}
 }
 
+/** Probe for profiling LoadUnloadStation. */
+static ProfileProbe _probe_load_unload_station("LoadUnloadStation");
+
 /**
  * Load/unload the vehicles in this station according to the order
  * they entered.
@@ -1919,20 +1942,23 @@ static void LoadUnloadVehicle(Vehicle *front)
  */
 void LoadUnloadStation(Station *st)
 {
+	ProfileScope profile(_probe_load_unload_station);
+
 	/* No vehicle is here... */
 	if (st->loading_vehicles.empty()) return;
 
-	Vehicle *last_loading = nullptr;
-	std::list<Vehicle *>::iterator iter;
+	/* Vehicles that are neither stopped nor crashed, in the order they entered. */
+	static std::vector<Vehicle *> active;
+	active.clear();
+	size_t last_loading = SIZE_MAX;
 
 	/* Check if anything will be loaded at all. Otherwise we don't need to reserve either. */
-	for (iter = st->loading_vehicles.begin(); iter != st->loading_vehicles.end(); ++iter) {
-		Vehicle *v = *iter;
-
+	for (Vehicle *v : st->loading_vehicles) {
 		if ((v->vehstatus & (VS_STOPPED | VS_CRASHED))) continue;
 
 		assert(v->load_unload_ticks != 0);
-		if (--v->load_unload_ticks == 0) last_loading = v;
+		if (--v->load_unload_ticks == 0) last_loading = active.size();
+		active.push_back(v);
 	}
 
 	/* We only need to reserve and load/unload up to the last loading vehicle.
@@ -1942,12 +1968,10 @@ void LoadUnloadStation(Station *st)
 	 * consist in a station which is not allowed to load yet because its
 	 * load_unload_ticks is still not 0.
 	 */
-	if (last_loading == nullptr) return;
+	if (last_loading == SIZE_MAX) return;
 
-	for (iter = st->loading_vehicles.begin(); iter != st->loading_vehicles.end(); ++iter) {
-		Vehicle *v = *iter;
-		if (!(v->vehstatus & (VS_STOPPED | VS_CRASHED))) LoadUnloadVehicle(v);
-		if (v == last_loading) break;
+	for (size_t i = 0; i <= last_loading; i++) {
+		LoadUnloadVehicle(active[i]);
 	}
 
 	/* Call the production machinery of industries */
@@ -52,6 +52,7 @@ static const char * const _subdirs[] = {
 	"game" PATHSEP,
 	"game" PATHSEP "library" PATHSEP,
 	"screenshot" PATHSEP,
+	"cache" PATHSEP,
 };
 static_assert(lengthof(_subdirs) == NUM_SUBDIRS);
 
@@ -165,6 +166,20 @@ std::string FioGetDirectory(Searchpath sp, Subdirectory subdir)
 	return _searchpaths[sp] + _subdirs[subdir];
 }
 
+/**
+ * Get the directory for the given type of files within the personal directory.
+ * Unlike #FioFindDirectory this never falls back to another directory, so files
+ * can be written there after creating the directory when it does not exist yet.
+ * @param subdir The type of files.
+ * @return The full path of the directory.
+ */
+std::string FioGetPersonalDirectory(Subdirectory subdir)
+{
+	assert(subdir < NUM_SUBDIRS);
+
+	return _personal_dir + _subdirs[subdir];
+}
+
 std::string FioFindDirectory(Subdirectory subdir)
 {
 	/* Find and return the first valid directory */
@@ -20,6 +20,7 @@ FILE *FioFOpenFile(const std::string &filename, const char *mode, Subdirectory s
 bool FioCheckFileExists(const std::string &filename, Subdirectory subdir);
 std::string FioFindFullPath(Subdirectory subdir, const char *filename);
 std::string FioGetDirectory(Searchpath sp, Subdirectory subdir);
+std::string FioGetPersonalDirectory(Subdirectory subdir);
 std::string FioFindDirectory(Subdirectory subdir);
 void FioCreateDirectory(const std::string &name);
 
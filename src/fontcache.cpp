@@ -200,6 +200,11 @@ bool SpriteFontCache::GetDrawGlyphShadow()
 }
 
 /* static */ FontCache *FontCache::caches[FS_END] = { new SpriteFontCache(FS_NORMAL), new SpriteFontCache(FS_SMALL), new SpriteFontCache(FS_LARGE), new SpriteFontCache(FS_MONO) };
+/* static */ uint64 FontCache::glyph_hits = 0;
+/* static */ uint64 FontCache::glyph_misses = 0;
+/* static */ uint64 FontCache::glyph_evictions = 0;
+
+/* static */ size_t TrueTypeFontCache::last_glyph_size = 0;
 
 
 /**
@@ -207,7 +212,7 @@ bool SpriteFontCache::GetDrawGlyphShadow()
  * @param fs     The font size that is going to be cached.
  * @param pixels The number of pixels this font should be high.
  */
-TrueTypeFontCache::TrueTypeFontCache(FontSize fs, int pixels) : FontCache(fs), req_size(pixels), glyph_to_sprite(nullptr)
+TrueTypeFontCache::TrueTypeFontCache(FontSize fs, int pixels) : FontCache(fs), req_size(pixels), glyph_to_sprite(nullptr), glyph_cache_size(0), glyph_use_counter(0)
 {
 }
 
@@ -244,10 +249,67 @@ void TrueTypeFontCache::ClearFontCache()
 
 	free(this->glyph_to_sprite);
 	this->glyph_to_sprite = nullptr;
+	this->glyph_cache_size = 0;
 
 	Layouter::ResetFontCache(this->fs);
 }
 
+/**
+ * Sprite allocator for glyphs, which remembers the size of the allocation so it can be accounted for.
+ * @param size Size of the sprite.
+ * @return The allocated memory.
+ */
+/* static */ void *TrueTypeFontCache::AllocateGlyph(size_t size)
+{
+	TrueTypeFontCache::last_glyph_size = size;
+	return MallocT<byte>(size);
+}
+
+/**
+ * Free the least recently used glyphs when the rendered glyphs use more memory than allowed.
+ * Only the sprites are freed; they are rendered again when requested.
+ */
+void TrueTypeFontCache::ReduceGlyphCache()
+{
+	if (this->glyph_cache_size <= MAX_GLYPH_CACHE_SIZE) return;
+
+	/* Glyphs that are duplicated for missing characters are kept, as the duplicates refer to their sprite. */
+	std::vector<const Sprite *> pinned;
+	std::vector<std::pair<uint32, GlyphEntry *>> glyphs;
+	for (int i = 0; i < 256; i++) {
+		if (this->glyph_to_sprite[i] == nullptr) continue;
+
+		for (int j = 0; j < 256; j++) {
+			GlyphEntry *glyph = &this->glyph_to_sprite[i][j];
+			if (glyph->sprite == nullptr) continue;
+			if (glyph->duplicate) {
+				pinned.push_back(glyph->sprite);
+				continue;
+			}
+			/* Counter values are compared relative to the current one, so wrapping around does no harm. */
+			glyphs.emplace_back(this->glyph_use_counter - glyph->last_use, glyph);
+		}
+	}
+
+	/* Free the oldest glyphs until only three quarters of the budget is in use. */
+	std::sort(glyphs.begin(), glyphs.end(), [](const auto &a, const auto &b) { return a.first > b.first; });
+
+	for (auto &it : glyphs) {
+		if (this->glyph_cache_size <= MAX_GLYPH_CACHE_SIZE / 4 * 3) break;
+
+		GlyphEntry *glyph = it.second;
+		if (std::find(pinned.begin(), pinned.end(), glyph->sprite) != pinned.end()) continue;
+
+		free(glyph->sprite);
+		glyph->sprite = nullptr;
+		this->glyph_cache_size -= glyph->size;
+		glyph->size = 0;
+		FontCache::glyph_evictions++;
+	}
+
+	Debug(freetype, 3, "Reduced glyph cache for size {} to {} bytes", this->fs, this->glyph_cache_size);
+}
+
 
 TrueTypeFontCache::GlyphEntry *TrueTypeFontCache::GetGlyphPtr(GlyphID key)
 {
@@ -269,9 +331,15 @@ void TrueTypeFontCache::SetGlyphPtr(GlyphID key, const GlyphEntry *glyph, bool d
 	}
 
 	Debug(freetype, 4, "Set glyph for unicode character 0x{:04X}, size {}", key, this->fs);
-	this->glyph_to_sprite[GB(key, 8, 8)][GB(key, 0, 8)].sprite = glyph->sprite;
-	this->glyph_to_sprite[GB(key, 8, 8)][GB(key, 0, 8)].width = glyph->width;
-	this->glyph_to_sprite[GB(key, 8, 8)][GB(key, 0, 8)].duplicate = duplicate;
+	GlyphEntry *entry = &this->glyph_to_sprite[GB(key, 8, 8)][GB(key, 0, 8)];
+	entry->sprite = glyph->sprite;
+	entry->width = glyph->width;
+	entry->duplicate = duplicate;
+	entry->size = duplicate ? 0 : (uint32)TrueTypeFontCache::last_glyph_size;
+	entry->last_use = this->glyph_use_counter;
+	this->glyph_cache_size += entry->size;
+
+	if (!duplicate) this->ReduceGlyphCache();
 }
 
 
@@ -314,7 +382,13 @@ const Sprite *TrueTypeFontCache::GetGlyph(GlyphID key)
 
 	/* Check for the glyph in our cache */
 	GlyphEntry *glyph = this->GetGlyphPtr(key);
-	if (glyph != nullptr && glyph->sprite != nullptr) return glyph->sprite;
+	this->glyph_use_counter++;
+	if (glyph != nullptr && glyph->sprite != nullptr) {
+		glyph->last_use = this->glyph_use_counter;
+		FontCache::glyph_hits++;
+		return glyph->sprite;
+	}
+	FontCache::glyph_misses++;
 
 	if (key == 0) {
 		GlyphID question_glyph = this->MapCharToGlyph('?');
@@ -347,7 +421,7 @@ const Sprite *TrueTypeFontCache::GetGlyph(GlyphID key)
 				builtin_questionmark_data
 			};
 
-			Sprite *spr = BlitterFactory::GetCurrentBlitter()->Encode(&builtin_questionmark, SimpleSpriteAlloc);
+			Sprite *spr = BlitterFactory::GetCurrentBlitter()->Encode(&builtin_questionmark, TrueTypeFontCache::AllocateGlyph);
 			assert(spr != nullptr);
 			GlyphEntry new_glyph;
 			new_glyph.sprite = spr;
@@ -636,7 +710,7 @@ const Sprite *FreeTypeFontCache::InternalGetGlyph(GlyphID key, bool aa)
 	}
 
 	GlyphEntry new_glyph;
-	new_glyph.sprite = BlitterFactory::GetCurrentBlitter()->Encode(&sprite, SimpleSpriteAlloc);
+	new_glyph.sprite = BlitterFactory::GetCurrentBlitter()->Encode(&sprite, TrueTypeFontCache::AllocateGlyph);
 	new_glyph.width  = slot->advance.x >> 6;
 
 	this->SetGlyphPtr(key, &new_glyph);
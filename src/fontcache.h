@@ -21,6 +21,10 @@ static const GlyphID SPRITE_GLYPH = 1U << 30;
 class FontCache {
 private:
 	static FontCache *caches[FS_END]; ///< All the font caches.
+public:
+	static uint64 glyph_hits;   ///< Number of glyph requests that were served from a glyph cache.
+	static uint64 glyph_misses; ///< Number of glyph requests that had to render the glyph.
+	static uint64 glyph_evictions; ///< Number of rendered glyphs that were dropped to stay within the memory budget.
 protected:
 	FontCache *parent;                ///< The parent of this font cache.
 	const FontSize fs;                ///< The size of the font.
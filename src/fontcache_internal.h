@@ -24,6 +24,7 @@ class TrueTypeFontCache : public FontCache {
 protected:
 	static constexpr int MAX_GLYPH_DIM = 256;          ///< Maximum glyph dimensions.
 	static constexpr uint MAX_FONT_MIN_REC_SIZE = 20u; ///< Upper limit for the recommended font size in case a font file contains nonsensical values.
+	static constexpr size_t MAX_GLYPH_CACHE_SIZE = 4 * 1024 * 1024; ///< Maximum memory used by the rendered glyphs of one font cache.
 
 	int req_size;  ///< Requested font size.
 	int used_size; ///< Used font size.
@@ -36,6 +37,8 @@ protected:
 		Sprite *sprite; ///< The loaded sprite.
 		byte width;     ///< The width of the glyph.
 		bool duplicate; ///< Whether this glyph entry is a duplicate, i.e. may this be freed?
+		uint32 size;    ///< Memory used by the sprite, 0 for duplicates.
+		uint32 last_use; ///< Value of #glyph_use_counter when the glyph was last requested.
 	};
 
 	/**
@@ -52,9 +55,15 @@ protected:
 	 * This can be simply changed in the two functions Get & SetGlyphPtr.
 	 */
 	GlyphEntry **glyph_to_sprite;
+	size_t glyph_cache_size;   ///< Memory used by the rendered glyphs of this font cache.
+	uint32 glyph_use_counter;  ///< Counter incremented on each glyph request, for finding the least recently used glyphs.
+
+	static size_t last_glyph_size; ///< Size of the sprite last allocated by #AllocateGlyph.
+	static void *AllocateGlyph(size_t size);
 
 	GlyphEntry *GetGlyphPtr(GlyphID key);
 	void SetGlyphPtr(GlyphID key, const GlyphEntry *glyph, bool duplicate = false);
+	void ReduceGlyphCache();
 
 	virtual const void *InternalGetFontTable(uint32 tag, size_t &length) = 0;
 	virtual const Sprite *InternalGetGlyph(GlyphID key, bool aa) = 0;
@@ -507,7 +507,8 @@ static int DrawLayoutLine(const ParagraphLayouter::Line &line, int y, int left,
 
 	truncation &= max_w < w;         // Whether we need to do truncation.
 	int dot_width = 0;               // Cache for the width of the dot.
-	const Sprite *dot_sprite = nullptr; // Cache for the sprite of the dot.
+	FontCache *dot_fc = nullptr; // Font cache to draw the dots with.
+	GlyphID dot_glyph = 0;       // Glyph of the dot.
 
 	if (truncation) {
 		/*
@@ -516,10 +517,9 @@ static int DrawLayoutLine(const ParagraphLayouter::Line &line, int y, int left,
 		 * another size would be chosen it won't have truncated too little for
 		 * the truncation dots.
 		 */
-		FontCache *fc = ((const Font*)line.GetVisualRun(0).GetFont())->fc;
-		GlyphID dot_glyph = fc->MapCharToGlyph('.');
-		dot_width = fc->GetGlyphWidth(dot_glyph);
-		dot_sprite = fc->GetGlyph(dot_glyph);
+		dot_fc = ((const Font*)line.GetVisualRun(0).GetFont())->fc;
+		dot_glyph = dot_fc->MapCharToGlyph('.');
+		dot_width = dot_fc->GetGlyphWidth(dot_glyph);
 
 		if (_current_text_dir == TD_RTL) {
 			min_x += 3 * dot_width;
@@ -602,6 +602,8 @@ static int DrawLayoutLine(const ParagraphLayouter::Line &line, int y, int left,
 	}
 
 	if (truncation) {
+		/* Only get the sprite now; drawing the other glyphs may have pushed it out of the glyph cache. */
+		const Sprite *dot_sprite = dot_fc->GetGlyph(dot_glyph);
 		int x = (_current_text_dir == TD_RTL) ? left : (right - 3 * dot_width);
 		for (int i = 0; i < 3; i++, x += dot_width) {
 			if (draw_shadow) {
@@ -32,6 +32,10 @@
 
 /** Cache of ParagraphLayout lines. */
 Layouter::LineCache *Layouter::linecache;
+/** Number of times the linecache has been reduced, used to find lines that have not been used for a while. */
+uint Layouter::linecache_generation = 0;
+uint64 Layouter::linecache_hits = 0;
+uint64 Layouter::linecache_misses = 0;
 
 /** Cache of Font instances. */
 Layouter::FontColourMap Layouter::fonts[FS_END];
@@ -681,11 +685,13 @@ Layouter::Layouter(const char *str, int maxw, TextColour colour, FontSize fontsi
 		LineCacheItem& line = GetCachedParagraphLayout(str, lineend - str, state);
 		if (line.layout != nullptr) {
 			/* Line is in cache */
+			linecache_hits++;
 			str = lineend + 1;
 			state = line.state_after;
 			line.layout->Reflow();
 		} else {
 			/* Line is new, layout it */
+			linecache_misses++;
 			FontState old_state = state;
 #if defined(WITH_ICU_LX) || defined(WITH_UNISCRIBE) || defined(WITH_COCOA)
 			const char *old_str = str;
@@ -891,7 +897,9 @@ Layouter::LineCacheItem &Layouter::GetCachedParagraphLayout(const char *str, siz
 	LineCacheKey key;
 	key.state_before = state;
 	key.str.assign(str, len);
-	return (*linecache)[key];
+	LineCacheItem &item = (*linecache)[key];
+	item.last_used = linecache_generation;
+	return item;
 }
 
 /**
@@ -907,8 +915,20 @@ void Layouter::ResetLineCache()
  */
 void Layouter::ReduceLineCache()
 {
-	if (linecache != nullptr) {
-		/* TODO LRU cache would be fancy, but not exactly necessary */
-		if (linecache->size() > 4096) ResetLineCache();
+	if (linecache == nullptr) return;
+
+	linecache_generation++;
+	if (linecache->size() <= MAX_LINE_CACHE_SIZE) return;
+
+	/* Drop the lines that have not been used for a while. */
+	for (auto it = linecache->begin(); it != linecache->end();) {
+		if (linecache_generation - it->second.last_used > LINE_CACHE_MAX_AGE) {
+			it = linecache->erase(it);
+		} else {
+			++it;
+		}
 	}
+
+	/* Everything is in use, so the cache is thrashing anyway; start over. */
+	if (linecache->size() > MAX_LINE_CACHE_SIZE) ResetLineCache();
 }
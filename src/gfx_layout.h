@@ -17,6 +17,7 @@
 #include <map>
 #include <string>
 #include <stack>
+#include <unordered_map>
 #include <vector>
 
 #ifdef WITH_ICU_LX
@@ -156,15 +157,27 @@ class Layouter : public std::vector<std::unique_ptr<const ParagraphLayouter::Lin
 		FontState state_before;  ///< Font state at the beginning of the line.
 		std::string str;         ///< Source string of the line (including colour and font size codes).
 
-		/** Comparison operator for std::map */
-		bool operator<(const LineCacheKey &other) const
+		/** Equality operator for std::unordered_map */
+		bool operator==(const LineCacheKey &other) const
 		{
-			if (this->state_before.fontsize != other.state_before.fontsize) return this->state_before.fontsize < other.state_before.fontsize;
-			if (this->state_before.cur_colour != other.state_before.cur_colour) return this->state_before.cur_colour < other.state_before.cur_colour;
-			if (this->state_before.colour_stack != other.state_before.colour_stack) return this->state_before.colour_stack < other.state_before.colour_stack;
-			return this->str < other.str;
+			return this->state_before.fontsize == other.state_before.fontsize &&
+					this->state_before.cur_colour == other.state_before.cur_colour &&
+					this->state_before.colour_stack == other.state_before.colour_stack &&
+					this->str == other.str;
 		}
 	};
+
+	/** Hash function for #LineCacheKey. */
+	struct LineCacheHash {
+		size_t operator()(const LineCacheKey &key) const
+		{
+			size_t state = (size_t)key.state_before.fontsize << 24 | (size_t)key.state_before.colour_stack.size() << 16 | (size_t)key.state_before.cur_colour;
+			return std::hash<std::string>{}(key.str) ^ (state * 0x9E3779B1U);
+		}
+	};
+
+	static const size_t MAX_LINE_CACHE_SIZE = 4096; ///< Number of lines in the linecache above which unused lines are dropped.
+	static const uint LINE_CACHE_MAX_AGE = 256;     ///< Number of calls to #ReduceLineCache after which an unused line may be dropped.
 public:
 	/** Item in the linecache */
 	struct LineCacheItem {
@@ -174,19 +187,24 @@ public:
 
 		FontState state_after;     ///< Font state after the line.
 		ParagraphLayouter *layout; ///< Layout of the line.
+		uint last_used;            ///< Value of #linecache_generation when the line was last used.
 
-		LineCacheItem() : buffer(nullptr), layout(nullptr) {}
+		LineCacheItem() : buffer(nullptr), layout(nullptr), last_used(0) {}
 		~LineCacheItem() { delete layout; free(buffer); }
 	};
 private:
-	typedef std::map<LineCacheKey, LineCacheItem> LineCache;
+	typedef std::unordered_map<LineCacheKey, LineCacheItem, LineCacheHash> LineCache;
 	static LineCache *linecache;
+	static uint linecache_generation;
 
 	static LineCacheItem &GetCachedParagraphLayout(const char *str, size_t len, const FontState &state);
 
 	typedef SmallMap<TextColour, Font *> FontColourMap;
 	static FontColourMap fonts[FS_END];
 public:
+	static uint64 linecache_hits;   ///< Number of lines that were taken from the linecache.
+	static uint64 linecache_misses; ///< Number of lines that had to be laid out.
+
 	static Font *GetFont(FontSize size, TextColour colour);
 
 	Layouter(const char *str, int maxw = INT32_MAX, TextColour colour = TC_FROMSTRING, FontSize fontsize = FS_NORMAL);
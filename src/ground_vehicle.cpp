@@ -88,6 +88,9 @@ void GroundVehicle<T, Type>::CargoChanged()
 		u->gcache.cached_slope_resistance = current_weight * u->GetSlopeSteepness() * 100;
 	}
 
+	/* The slope resistance of the parts changed with their weight. */
+	this->UpdateTotalSlopeResistance();
+
 	/* Store consist weight in cache. */
 	this->gcache.cached_weight = std::max(1u, weight);
 	/* Friction in bearings and other mechanical parts is 0.1% of the weight (result in N). */
@@ -25,6 +25,7 @@ enum AccelStatus {
 /**
  * Cached, frequently calculated values.
  * All of these values except cached_slope_resistance are set only for the first part of a vehicle.
+ * cached_total_slope_resistance is also kept up to date when a part starts or stops being at a slope.
  */
 struct GroundVehicleCache {
 	/* Cached acceleration values, recalculated when the cargo on a vehicle changes (in addition to the conditions below) */
@@ -32,6 +33,7 @@ struct GroundVehicleCache {
 	uint32 cached_slope_resistance; ///< Resistance caused by weight when this vehicle part is at a slope.
 	uint32 cached_max_te;           ///< Maximum tractive effort of consist (valid only for the first engine).
 	uint16 cached_axle_resistance;  ///< Resistance caused by the axles of the vehicle (valid only for the first engine).
+	int64 cached_total_slope_resistance; ///< Sum of the slope resistance of all parts at a slope, negative when going down (valid only for the first engine).
 
 	/* Cached acceleration values, recalculated on load and each time a vehicle is added to/removed from the consist. */
 	uint16 cached_max_track_speed;  ///< Maximum consist speed (in internal units) limited by track type (valid only for the first engine).
@@ -101,29 +103,60 @@ struct GroundVehicle : public SpecializedVehicle<T, Type> {
 	{
 		/* Crashed vehicles aren't going up or down */
 		for (T *v = T::From(this); v != nullptr; v = v->Next()) {
-			ClrBit(v->gv_flags, GVF_GOINGUP_BIT);
-			ClrBit(v->gv_flags, GVF_GOINGDOWN_BIT);
+			v->SetSlopeFlags(0);
 		}
 		return this->Vehicle::Crash(flooded);
 	}
 
+	/**
+	 * Calculates the slope resistance of this vehicle part.
+	 * @return Slope resistance of the part, negative when going down.
+	 */
+	inline int64 GetPartSlopeResistance() const
+	{
+		if (HasBit(this->gv_flags, GVF_GOINGUP_BIT)) return this->gcache.cached_slope_resistance;
+		if (HasBit(this->gv_flags, GVF_GOINGDOWN_BIT)) return -(int64)this->gcache.cached_slope_resistance;
+		return 0;
+	}
+
 	/**
 	 * Calculates the total slope resistance for this vehicle.
 	 * @return Slope resistance.
 	 */
 	inline int64 GetSlopeResistance() const
 	{
+		return this->gcache.cached_total_slope_resistance;
+	}
+
+	/**
+	 * Recalculates the cached total slope resistance of the consist from its parts.
+	 */
+	inline void UpdateTotalSlopeResistance()
+	{
+		assert(this->First() == this);
 		int64 incl = 0;
 
 		for (const T *u = T::From(this); u != nullptr; u = u->Next()) {
-			if (HasBit(u->gv_flags, GVF_GOINGUP_BIT)) {
-				incl += u->gcache.cached_slope_resistance;
-			} else if (HasBit(u->gv_flags, GVF_GOINGDOWN_BIT)) {
-				incl -= u->gcache.cached_slope_resistance;
-			}
+			incl += u->GetPartSlopeResistance();
 		}
 
-		return incl;
+		this->gcache.cached_total_slope_resistance = incl;
+	}
+
+	/**
+	 * Sets whether this vehicle part is going up or down, and updates the
+	 * cached total slope resistance of the consist to match.
+	 * @param slope_flags The new #GVF_GOINGUP_BIT and #GVF_GOINGDOWN_BIT of the part; other bits are ignored.
+	 */
+	inline void SetSlopeFlags(uint16 slope_flags)
+	{
+		int64 &total = T::From(this->First())->gcache.cached_total_slope_resistance;
+		total -= this->GetPartSlopeResistance();
+
+		const uint16 mask = (1U << GVF_GOINGUP_BIT) | (1U << GVF_GOINGDOWN_BIT);
+		this->gv_flags = (this->gv_flags & ~mask) | (slope_flags & mask);
+
+		total += this->GetPartSlopeResistance();
 	}
 
 	/**
@@ -135,8 +168,7 @@ struct GroundVehicle : public SpecializedVehicle<T, Type> {
 	inline void UpdateZPositionAndInclination()
 	{
 		this->z_pos = GetSlopePixelZ(this->x_pos, this->y_pos);
-		ClrBit(this->gv_flags, GVF_GOINGUP_BIT);
-		ClrBit(this->gv_flags, GVF_GOINGDOWN_BIT);
+		uint16 slope_flags = 0;
 
 		if (T::From(this)->TileMayHaveSlopedTrack()) {
 			/* To check whether the current tile is sloped, and in which
@@ -146,9 +178,11 @@ struct GroundVehicle : public SpecializedVehicle<T, Type> {
 			int middle_z = GetSlopePixelZ((this->x_pos & ~TILE_UNIT_MASK) | (TILE_SIZE / 2), (this->y_pos & ~TILE_UNIT_MASK) | (TILE_SIZE / 2));
 
 			if (middle_z != this->z_pos) {
-				SetBit(this->gv_flags, (middle_z > this->z_pos) ? GVF_GOINGUP_BIT : GVF_GOINGDOWN_BIT);
+				SetBit(slope_flags, (middle_z > this->z_pos) ? GVF_GOINGUP_BIT : GVF_GOINGDOWN_BIT);
 			}
 		}
+
+		this->SetSlopeFlags(slope_flags);
 	}
 
 	/**
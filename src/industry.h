@@ -78,7 +78,9 @@ struct Industry : IndustryPool::PoolItem<&_industry_pool> {
 	byte last_month_pct_transported[INDUSTRY_NUM_OUTPUTS]; ///< percentage transported per cargo in the last full month
 	uint16 last_month_production[INDUSTRY_NUM_OUTPUTS];    ///< total units produced per cargo in the last full month
 	uint16 last_month_transported[INDUSTRY_NUM_OUTPUTS];   ///< total units transported per cargo in the last full month
-	uint16 counter;                                        ///< used for animation and/or production (if available cargo)
+	uint16 counter;                                        ///< used for animation and/or production (if available cargo); value at counter_tick, see GetCounter()
+	uint64 counter_tick;                                   ///< NOSAVE: Industry tick at which counter was last brought up to date.
+	uint64 counter_due;                                    ///< NOSAVE: Industry tick at which the industry acts on its counter next, or 0 if not scheduled.
 
 	IndustryType type;             ///< type of industry.
 	Owner owner;                   ///< owner of the industry.  Which SHOULD always be (imho) OWNER_NONE
@@ -108,6 +110,7 @@ struct Industry : IndustryPool::PoolItem<&_industry_pool> {
 	~Industry();
 
 	void RecomputeProductionMultipliers();
+	uint16 GetCounter() const;
 
 	/**
 	 * Check if a given tile belongs to this industry.
@@ -202,6 +205,8 @@ protected:
 };
 
 void ClearAllIndustryCachedNames();
+void SyncIndustryCounters();
+void RebuildIndustrySchedule();
 
 void PlantRandomFarmField(const Industry *i);
 
@@ -42,6 +42,7 @@
 #include "error.h"
 #include "cmd_helper.h"
 #include "string_func.h"
+#include "core/timer_wheel.hpp"
 
 #include "table/strings.h"
 #include "table/industry_land.h"
@@ -64,6 +65,60 @@ IndustrySpec _industry_specs[NUM_INDUSTRYTYPES];
 IndustryTileSpec _industry_tile_specs[NUM_INDUSTRYTILES];
 IndustryBuildData _industry_builder; ///< In-game manager of industries.
 
+/**
+ * Industries count their counter down every tick, but only act on it every
+ * so many ticks. Rather than doing that for every industry every tick, the
+ * industries are scheduled for the next tick they act on it.
+ */
+static TimerWheel<IndustryID, INDUSTRY_PRODUCE_TICKS> _industry_wheel;
+
+/**
+ * Get the counter of the industry as if it was counted down every tick.
+ * @return The counter.
+ */
+uint16 Industry::GetCounter() const
+{
+	return this->counter - (uint16)(_industry_wheel.Now() - this->counter_tick);
+}
+
+/**
+ * Schedule the industry for the next tick ProduceIndustryGoods acts on its counter.
+ * @param i Industry to schedule; its counter must be up to date.
+ */
+static void ScheduleIndustry(Industry *i)
+{
+	assert(i->counter_due == 0 && i->counter_tick == _industry_wheel.Now());
+
+	/* A sound may be played when the counter is a multiple of 64 before
+	 * counting down, and cargo is produced when it is a multiple of
+	 * INDUSTRY_PRODUCE_TICKS after counting down. */
+	uint sound = i->counter % 64 + 1;
+	uint produce = i->counter % INDUSTRY_PRODUCE_TICKS != 0 ? i->counter % INDUSTRY_PRODUCE_TICKS : INDUSTRY_PRODUCE_TICKS;
+	i->counter_due = _industry_wheel.Now() + std::min(sound, produce);
+	_industry_wheel.Schedule(i->index, i->counter_due);
+}
+
+/** Bring the counter of all industries up to date, e.g. for saving. */
+void SyncIndustryCounters()
+{
+	for (Industry *i : Industry::Iterate()) {
+		i->counter = i->GetCounter();
+		i->counter_tick = _industry_wheel.Now();
+	}
+}
+
+/** Rebuild the schedule from scratch, e.g. after loading a game. */
+void RebuildIndustrySchedule()
+{
+	_industry_wheel.Clear();
+
+	for (Industry *i : Industry::Iterate()) {
+		i->counter_tick = 0;
+		i->counter_due = 0;
+		ScheduleIndustry(i);
+	}
+}
+
 /**
  * This function initialize the spec arrays of both
  * industry and industry tiles.
@@ -142,6 +197,8 @@ Industry::~Industry()
 {
 	if (CleaningPool()) return;
 
+	if (this->counter_due != 0) _industry_wheel.Unschedule(this->index, this->counter_due);
+
 	/* Industry can also be destroyed when not fully initialized.
 	 * This means that we do not have to clear tiles either.
 	 * Also we must not decrement industry counts in that case. */
@@ -1131,6 +1188,9 @@ static void ProduceIndustryGoods(Industry *i)
 {
 	const IndustrySpec *indsp = GetIndustrySpec(i->type);
 
+	/* Catch up on the ticks the industry had nothing to do. */
+	i->counter -= (uint16)(_industry_wheel.Now() - 1 - i->counter_tick);
+
 	/* play a sound? */
 	if ((i->counter & 0x3F) == 0) {
 		uint32 r;
@@ -1148,6 +1208,7 @@ static void ProduceIndustryGoods(Industry *i)
 	}
 
 	i->counter--;
+	i->counter_tick = _industry_wheel.Now();
 
 	/* produce some cargo */
 	if ((i->counter % INDUSTRY_PRODUCE_TICKS) == 0) {
@@ -1209,8 +1270,16 @@ void OnTick_Industry()
 
 	if (_game_mode == GM_EDITOR) return;
 
-	for (Industry *i : Industry::Iterate()) {
+	/* Only the industries acting on their counter need attention. They are
+	 * handled in index order, like it was done when scanning all of them. */
+	static std::vector<IndustryID> due;
+	_industry_wheel.Advance(due);
+
+	for (IndustryID index : due) {
+		Industry *i = Industry::Get(index);
+		i->counter_due = 0;
 		ProduceIndustryGoods(i);
+		ScheduleIndustry(i);
 	}
 }
 
@@ -1755,6 +1824,8 @@ static void DoCreateNewIndustry(Industry *i, TileIndex tile, IndustryType type,
 	uint16 r = Random();
 	i->random_colour = GB(r, 0, 4);
 	i->counter = GB(r, 4, 12);
+	i->counter_tick = _industry_wheel.Now();
+	ScheduleIndustry(i);
 	i->random = initial_random_bits;
 	i->was_cargo_delivered = false;
 	i->last_prod_year = _cur_year;
@@ -2949,6 +3020,7 @@ void InitializeIndustries()
 {
 	Industry::ResetIndustryCounts();
 	_industry_sound_tile = 0;
+	_industry_wheel.Clear();
 
 	_industry_builder.Reset();
 }
@@ -12,6 +12,8 @@
 #include "core/alloc_func.hpp"
 #include "water_map.h"
 #include "string_func.h"
+#include "pathfinder/road_regions.h"
+#include "pathfinder/water_regions.h"
 
 #include "safeguards.h"
 
@@ -61,6 +63,9 @@ void AllocateMap(uint size_x, uint size_y)
 
 	_m = CallocT<Tile>(_map_size);
 	_me = CallocT<TileExtended>(_map_size);
+
+	AllocateRoadRegions();
+	AllocateWaterRegions();
 }
 
 
@@ -0,0 +1,29 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file map_region_func.h Functions to keep the regions the pathfinders divide the map in up to date when tiles change. */
+
+#ifndef MAP_REGION_FUNC_H
+#define MAP_REGION_FUNC_H
+
+#include "tile_type.h"
+
+/**
+ * Check whether tiles of a type can carry road or tram track.
+ * @param type The tile type.
+ * @return True if changes to tiles of the type can matter to road vehicles.
+ */
+static inline bool IsRoadRegionTileType(TileType type)
+{
+	return type == MP_ROAD || type == MP_STATION || type == MP_TUNNELBRIDGE;
+}
+
+void InvalidateWaterRegion(TileIndex tile);
+void InvalidateRoadRegion(TileIndex tile);
+void InvalidateRoadRegionsAroundCorner(TileIndex tile);
+
+#endif /* MAP_REGION_FUNC_H */
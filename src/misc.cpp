@@ -47,7 +47,9 @@ void InitializeDockGui();
 void InitializeGraphGui();
 void InitializeObjectGui();
 void InitializeTownGui();
+void InitializeTowns();
 void InitializeIndustries();
+void InitializeStations();
 void InitializeObjects();
 void InitializeTrees();
 void InitializeCompanies();
@@ -90,6 +92,8 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	InitializeMusic();
 
 	InitializeVehicles();
+	InvalidateSignalSegmentCache();
+	InvalidateReservationCache();
 
 	InitNewsItemStructs();
 	InitializeLandscape();
@@ -102,7 +106,9 @@ void InitializeGame(uint size_x, uint size_y, bool reset_date, bool reset_settin
 	InitializeTownGui();
 	InitializeAIGui();
 	InitializeTrees();
+	InitializeTowns();
 	InitializeIndustries();
+	InitializeStations();
 	InitializeObjects();
 	InitializeBuildingCounts();
 
@@ -65,6 +65,7 @@
 #include "viewport_sprite_sorter.h"
 #include "framerate_type.h"
 #include "industry.h"
+#include "spritecache_disk.h"
 
 #include "linkgraph/linkgraphschedule.h"
 
@@ -325,6 +326,8 @@ static void ShutdownGame()
 	/* No NewGRFs were loaded when it was still bootstrapping. */
 	if (_game_mode != GM_BOOTSTRAP) ResetNewGRFData();
 
+	CloseSpriteDiskCaches();
+
 	UninitFreeType();
 }
 
@@ -23,6 +23,7 @@
 
 #include "../../stdafx.h"
 #include "../../core/alloc_func.hpp"
+#include "../pathfinder_log.h"
 #include "aystar.h"
 
 #include "../../safeguards.h"
@@ -257,6 +258,8 @@ int AyStar::Main()
 	}
 #endif
 	if (r != AYSTAR_STILL_BUSY) {
+		if (_pathfinder_logging) LogPathfinderSearch(this->closedlist_hash.GetSize(), 0);
+
 		/* We're done, clean up */
 		this->Clear();
 	}
@@ -17,6 +17,7 @@
 #include "../pathfinder_func.h"
 #include "../pathfinder_type.h"
 #include "../follow_track.hpp"
+#include "../pathfinder_log.h"
 #include "aystar.h"
 
 #include "../../safeguards.h"
@@ -1173,6 +1174,7 @@ FindDepotData NPFRoadVehicleFindNearestDepot(const RoadVehicle *v, int max_penal
 
 Trackdir NPFRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, bool &path_found)
 {
+	PathfinderQueryLog log(PFQ_NPF_ROAD, v, tile);
 	NPFFindStationOrTileData fstd;
 
 	NPFFillWithOrderData(&fstd, v);
@@ -1188,6 +1190,7 @@ Trackdir NPFRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDir
 	 * we did not find our target, but ftd.best_trackdir contains the direction leading
 	 * to the tile closest to our target. */
 	path_found = (ftd.best_bird_dist == 0);
+	log.SetResult(ftd.best_trackdir, path_found);
 	return ftd.best_trackdir;
 }
 
@@ -1195,6 +1198,7 @@ Trackdir NPFRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDir
 
 Track NPFShipChooseTrack(const Ship *v, bool &path_found)
 {
+	PathfinderQueryLog log(PFQ_NPF_SHIP, v, v->tile);
 	NPFFindStationOrTileData fstd;
 	Trackdir trackdir = v->GetVehicleTrackdir();
 	assert(trackdir != INVALID_TRACKDIR); // Check that we are not in a depot
@@ -1211,6 +1215,7 @@ Track NPFShipChooseTrack(const Ship *v, bool &path_found)
 	 * we did not find our target, but ftd.best_trackdir contains the direction leading
 	 * to the tile closest to our target. */
 	path_found = (ftd.best_bird_dist == 0);
+	log.SetResult(TrackdirToTrack(ftd.best_trackdir), path_found);
 	return TrackdirToTrack(ftd.best_trackdir);
 }
 
@@ -1298,6 +1303,7 @@ bool NPFTrainCheckReverse(const Train *v)
 
 Track NPFTrainChooseTrack(const Train *v, bool &path_found, bool reserve_track, struct PBSTileInfo *target)
 {
+	PathfinderQueryLog log(PFQ_NPF_TRAIN, v, v->tile);
 	NPFFindStationOrTileData fstd;
 	NPFFillWithOrderData(&fstd, v, reserve_track);
 
@@ -1320,6 +1326,7 @@ Track NPFTrainChooseTrack(const Train *v, bool &path_found, bool reserve_track,
 	 * we did not find our target, but ftd.best_trackdir contains the direction leading
 	 * to the tile closest to our target. */
 	path_found = (ftd.best_bird_dist == 0);
+	log.SetResult(TrackdirToTrack(ftd.best_trackdir), path_found);
 	/* Discard enterdir information, making it a normal track */
 	return TrackdirToTrack(ftd.best_trackdir);
 }
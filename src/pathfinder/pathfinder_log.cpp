@@ -0,0 +1,237 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pathfinder_log.cpp Logging of pathfinder queries, to compare pathfinders between builds. */
+
+#include "../stdafx.h"
+#include "../console_func.h"
+#include "../console_type.h"
+#include "../date_func.h"
+#include "../fileio_func.h"
+#include "../vehicle_base.h"
+#include "../3rdparty/fmt/format.h"
+#include "pathfinder_log.h"
+
+#include <array>
+#include <chrono>
+
+#include "../safeguards.h"
+
+bool _pathfinder_logging = false; ///< Whether pathfinder queries are being logged.
+
+/** Names of the pathfinders in the log. */
+static const char * const _pathfinder_query_names[PFQ_END] = {
+	"yapf_train",
+	"yapf_road",
+	"yapf_ship",
+	"npf_train",
+	"npf_road",
+	"npf_ship",
+};
+
+/**
+ * Number of fields at the start of every line that describe the query and its result;
+ * these must be the same for every build. The remaining fields are the effort it took.
+ */
+static const uint PATHFINDER_LOG_RESULT_FIELDS = 7;
+
+/** Totals over all queries of a pathfinder. */
+struct PathfinderQueryTotals {
+	uint64 queries;    ///< Number of queries.
+	uint64 nodes;      ///< Number of nodes the searches expanded.
+	uint64 cache_hits; ///< Number of node costs taken from a cache.
+	uint64 time;       ///< Time spent in the queries, in nanoseconds.
+};
+
+typedef std::array<PathfinderQueryTotals, PFQ_END> PathfinderLogTotals; ///< Totals of every pathfinder.
+
+static FILE *_pathfinder_log_file = nullptr;    ///< File the queries are written to.
+static PathfinderLogTotals _pathfinder_totals;  ///< Totals of the queries logged since logging started.
+static uint _pathfinder_query_nodes = 0;        ///< Nodes expanded by the searches of the current query.
+static uint _pathfinder_query_cache_hits = 0;   ///< Cache hits of the searches of the current query.
+
+/**
+ * Get the current time for measuring queries.
+ * @return Time in nanoseconds, from an arbitrary starting point.
+ */
+static uint64 GetPathfinderLogTimer()
+{
+	using namespace std::chrono;
+	return (uint64)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/** Start measuring the query. */
+void PathfinderQueryLog::Begin()
+{
+	this->active = true;
+	_pathfinder_query_nodes = 0;
+	_pathfinder_query_cache_hits = 0;
+	this->start_time = GetPathfinderLogTimer();
+}
+
+/** Write the query with its result and the effort it took. */
+void PathfinderQueryLog::End()
+{
+	uint64 time = GetPathfinderLogTimer() - this->start_time;
+
+	/* Logging may have been stopped while the query ran, e.g. from a game script. */
+	if (_pathfinder_log_file == nullptr) return;
+
+	PathfinderQueryTotals &totals = _pathfinder_totals[this->type];
+	totals.queries++;
+	totals.nodes += _pathfinder_query_nodes;
+	totals.cache_hits += _pathfinder_query_cache_hits;
+	totals.time += time;
+
+	fputs(fmt::format("{} {} {} {} {} {} {} {} {} {}\n", _date, _date_fract, _pathfinder_query_names[this->type], this->v->index, this->tile, this->result, this->path_found ? 1 : 0,
+			_pathfinder_query_nodes, _pathfinder_query_cache_hits, time).c_str(), _pathfinder_log_file);
+}
+
+/**
+ * Account for a search run by the query being logged. Queries can run several searches,
+ * for example YAPF for ships searches the water regions before the water tiles.
+ * @param nodes Number of nodes the search expanded.
+ * @param cache_hits Number of node costs the search took from a cache.
+ */
+void LogPathfinderSearch(uint nodes, uint cache_hits)
+{
+	_pathfinder_query_nodes += nodes;
+	_pathfinder_query_cache_hits += cache_hits;
+}
+
+/**
+ * Stop logging any previous queries, and start logging queries to a file.
+ * @param filename File to write the queries to.
+ * @return True if the file could be opened.
+ */
+bool StartPathfinderLog(const std::string &filename)
+{
+	StopPathfinderLog();
+
+	_pathfinder_log_file = FioFOpenFile(filename, "wt", Subdirectory::NO_DIRECTORY);
+	if (_pathfinder_log_file == nullptr) return false;
+
+	_pathfinder_totals = {};
+	_pathfinder_logging = true;
+	return true;
+}
+
+/** Stop logging queries, and close the file. */
+void StopPathfinderLog()
+{
+	_pathfinder_logging = false;
+	if (_pathfinder_log_file != nullptr) {
+		FioFCloseFile(_pathfinder_log_file);
+		_pathfinder_log_file = nullptr;
+	}
+}
+
+/**
+ * Print the totals of every pathfinder to the console.
+ * @param totals Totals to print.
+ */
+static void PrintPathfinderTotals(const PathfinderLogTotals &totals)
+{
+	for (uint type = 0; type < PFQ_END; type++) {
+		const PathfinderQueryTotals &t = totals[type];
+		if (t.queries == 0) continue;
+		IConsolePrint(CC_DEFAULT, "{}: {} queries, {} nodes, {} cache hits, {:.3f} ms", _pathfinder_query_names[type], t.queries, t.nodes, t.cache_hits, t.time / 1e6);
+	}
+}
+
+/** Print the totals of the queries logged since logging started to the console. */
+void PrintPathfinderLogSummary()
+{
+	if (std::all_of(_pathfinder_totals.begin(), _pathfinder_totals.end(), [](const PathfinderQueryTotals &t) { return t.queries == 0; })) {
+		IConsolePrint(CC_INFO, "No pathfinder queries logged.");
+		return;
+	}
+	PrintPathfinderTotals(_pathfinder_totals);
+}
+
+/**
+ * Read the next query from a log.
+ * @param f Log to read from.
+ * @param[out] query The fields describing the query and its result.
+ * @param totals Totals to add the effort of the query to.
+ * @return False at the end of the log, or if the line isn't a query.
+ */
+static bool ReadPathfinderQuery(FILE *f, std::string &query, PathfinderLogTotals &totals)
+{
+	char line[256];
+	if (fgets(line, sizeof(line), f) == nullptr) return false;
+
+	/* Split the line after the fields describing the query. */
+	const char *effort = line;
+	for (uint field = 0; field < PATHFINDER_LOG_RESULT_FIELDS; field++) {
+		effort = strchr(effort, ' ');
+		if (effort == nullptr) return false;
+		effort++;
+	}
+	query.assign(line, effort - line);
+
+	const char *name = strchr(line, ' ');
+	name = name == nullptr ? nullptr : strchr(name + 1, ' ');
+	if (name == nullptr) return false;
+	name++;
+
+	uint type = 0;
+	while (type < PFQ_END && strncmp(name, _pathfinder_query_names[type], strlen(_pathfinder_query_names[type])) != 0) type++;
+	if (type == PFQ_END) return false;
+
+	char *end;
+	PathfinderQueryTotals &t = totals[type];
+	t.queries++;
+	t.nodes += strtoull(effort, &end, 10);
+	t.cache_hits += strtoull(end, &end, 10);
+	t.time += strtoull(end, &end, 10);
+	return true;
+}
+
+/**
+ * Compare two logs of the same savegame, for example made by two different builds.
+ * Report the first query with a different result, and the effort of both logs.
+ * @param filename1 First log.
+ * @param filename2 Second log.
+ * @return True if the logs could be read.
+ */
+bool ComparePathfinderLogs(const std::string &filename1, const std::string &filename2)
+{
+	FILE *f1 = FioFOpenFile(filename1, "rt", Subdirectory::NO_DIRECTORY);
+	if (f1 == nullptr) return false;
+	FileCloser fcloser1(f1);
+
+	FILE *f2 = FioFOpenFile(filename2, "rt", Subdirectory::NO_DIRECTORY);
+	if (f2 == nullptr) return false;
+	FileCloser fcloser2(f2);
+
+	PathfinderLogTotals totals1 = {};
+	PathfinderLogTotals totals2 = {};
+	std::string query1;
+	std::string query2;
+	uint64 line = 0;
+	for (;;) {
+		bool read1 = ReadPathfinderQuery(f1, query1, totals1);
+		bool read2 = ReadPathfinderQuery(f2, query2, totals2);
+		if (!read1 && !read2) break;
+
+		line++;
+		if (read1 != read2 || query1 != query2) {
+			IConsolePrint(CC_ERROR, "Query {} differs:", line);
+			IConsolePrint(CC_ERROR, "  '{}': {}", filename1, read1 ? query1 : "end of log");
+			IConsolePrint(CC_ERROR, "  '{}': {}", filename2, read2 ? query2 : "end of log");
+			return true;
+		}
+	}
+
+	IConsolePrint(CC_INFO, "All {} queries have the same result.", line);
+	IConsolePrint(CC_INFO, "'{}':", filename1);
+	PrintPathfinderTotals(totals1);
+	IConsolePrint(CC_INFO, "'{}':", filename2);
+	PrintPathfinderTotals(totals2);
+	return true;
+}
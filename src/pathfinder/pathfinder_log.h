@@ -0,0 +1,94 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file pathfinder_log.h Logging of pathfinder queries, to compare pathfinders between builds.
+ *
+ * While logging, every query for the track a vehicle should take is written to a file,
+ * with its result and the effort it took. As the game is deterministic, running the same
+ * savegame for the same number of ticks with two builds gives the same queries, so the
+ * logs can be compared query by query: the results must match, and the effort shows what
+ * a change to a pathfinder gained.
+ *
+ * @see the \c pathfinder_log console command.
+ */
+
+#ifndef PATHFINDER_LOG_H
+#define PATHFINDER_LOG_H
+
+#include "../tile_type.h"
+#include "../vehicle_type.h"
+
+#include <string>
+
+/** Pathfinder entry points whose queries are logged. */
+enum PathfinderQueryType : byte {
+	PFQ_YAPF_TRAIN, ///< YapfTrainChooseTrack
+	PFQ_YAPF_ROAD,  ///< YapfRoadVehicleChooseTrack
+	PFQ_YAPF_SHIP,  ///< YapfShipChooseTrack
+	PFQ_NPF_TRAIN,  ///< NPFTrainChooseTrack
+	PFQ_NPF_ROAD,   ///< NPFRoadVehicleChooseTrack
+	PFQ_NPF_SHIP,   ///< NPFShipChooseTrack
+	PFQ_END,
+};
+
+extern bool _pathfinder_logging;
+
+/**
+ * RAII class logging a single pathfinder query.
+ * Construct it at the beginning of the query and give it the result before returning;
+ * the query is written when it goes out of scope.
+ */
+class PathfinderQueryLog {
+	PathfinderQueryType type; ///< Pathfinder being queried.
+	const Vehicle *v;         ///< Vehicle the query is for.
+	TileIndex tile;           ///< Tile the query is made for.
+	int result;               ///< Track or trackdir chosen by the pathfinder.
+	bool path_found;          ///< Whether the pathfinder found a path to the destination.
+	bool active;              ///< Whether the query is logged.
+	uint64 start_time;        ///< Time the query started.
+
+	void Begin();
+	void End();
+
+public:
+	/**
+	 * Begin logging a query.
+	 * @param type Pathfinder being queried.
+	 * @param v Vehicle the query is for.
+	 * @param tile Tile the query is made for, usually the one the vehicle is about to enter.
+	 */
+	inline PathfinderQueryLog(PathfinderQueryType type, const Vehicle *v, TileIndex tile) : type(type), v(v), tile(tile), result(-1), path_found(false), active(false)
+	{
+		if (_pathfinder_logging) this->Begin();
+	}
+
+	/** Write the query, if it is logged. */
+	inline ~PathfinderQueryLog()
+	{
+		if (this->active) this->End();
+	}
+
+	/**
+	 * Set the result of the query.
+	 * @param result Track or trackdir chosen by the pathfinder.
+	 * @param path_found Whether the pathfinder found a path to the destination.
+	 */
+	inline void SetResult(int result, bool path_found)
+	{
+		this->result = result;
+		this->path_found = path_found;
+	}
+};
+
+void LogPathfinderSearch(uint nodes, uint cache_hits);
+
+bool StartPathfinderLog(const std::string &filename);
+void StopPathfinderLog();
+void PrintPathfinderLogSummary();
+bool ComparePathfinderLogs(const std::string &filename1, const std::string &filename2);
+
+#endif /* PATHFINDER_LOG_H */
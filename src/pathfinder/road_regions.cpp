@@ -0,0 +1,377 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file road_regions.cpp Handles dividing the road network in the map into square regions to assist pathfinding. */
+
+#include "../stdafx.h"
+#include "../map_func.h"
+#include "../road.h"
+#include "../tilearea_type.h"
+#include "../tunnelbridge_map.h"
+#include "pathfinder_func.h"
+#include "road_regions.h"
+
+#include <array>
+
+#include "../safeguards.h"
+
+typedef uint16 RoadRegionTraversabilityBits; ///< Bit per tile along an edge of a road region, set when the road at that tile reaches the edge.
+
+/** Connectivity of either the road or the tram track within a road region. */
+struct RoadRegionLayer {
+	std::vector<RoadRegionPatchLabel> tile_patch_labels; ///< Patch label of every tile; empty if the region has no track of this type.
+	std::array<RoadRegionTraversabilityBits, DIAGDIR_END> edge_traversability_bits; ///< Per side, the positions along the edge where the track reaches the neighbouring region.
+	std::vector<std::pair<RoadRegionPatchLabel, TileIndex>> cross_region_links; ///< Patch and far end of every tunnel or bridge leading to another region.
+};
+
+/**
+ * Connectivity of the road network within a square part of the map.
+ * The tiles with road or tram track are split into patches of tiles that are connected without leaving
+ * the region. Tiles are considered connected whenever a road vehicle could possibly drive from one
+ * to the other, so two tiles in different patches can't be reached from each other within the region.
+ * The information is only calculated when it is first asked for after the region has been invalidated.
+ */
+struct RoadRegion {
+	std::array<RoadRegionLayer, 2> layers; ///< Connectivity of the road and of the tram track.
+	uint32 generation;                     ///< Changes whenever anything in the region changes that could matter to road vehicles.
+	bool initialized;                      ///< Whether the connectivity of the region is up to date.
+};
+
+static std::vector<RoadRegion> _road_regions; ///< All road regions, row by row.
+static uint32 _road_region_generation = 0;    ///< Last generation given to a road region; never reused for the same map.
+static uint32 _road_regions_reset_count = 0;  ///< Number of times all road regions were reset.
+
+/**
+ * Get the number of road regions along the x axis of the map.
+ * @return The number of road regions.
+ */
+static inline uint GetRoadRegionMapSizeX()
+{
+	return MapSizeX() / ROAD_REGION_EDGE_LENGTH;
+}
+
+/**
+ * Get the number of road regions along the y axis of the map.
+ * @return The number of road regions.
+ */
+static inline uint GetRoadRegionMapSizeY()
+{
+	return MapSizeY() / ROAD_REGION_EDGE_LENGTH;
+}
+
+/**
+ * Get the index of the road region at the given region coordinates.
+ * @param region_x X coordinate of the region.
+ * @param region_y Y coordinate of the region.
+ * @return Index into #_road_regions.
+ */
+static inline uint GetRoadRegionIndex(int region_x, int region_y)
+{
+	return region_y * GetRoadRegionMapSizeX() + region_x;
+}
+
+/**
+ * Get the number of road regions on the map.
+ * @return The number of road regions.
+ */
+uint GetNumberOfRoadRegions()
+{
+	return (uint)_road_regions.size();
+}
+
+/**
+ * Get the index of the road region a patch is in.
+ * @param road_region_patch The patch.
+ * @return Unique index of the road region.
+ */
+uint GetRoadRegionIndex(const RoadRegionPatchDesc &road_region_patch)
+{
+	return GetRoadRegionIndex(road_region_patch.x, road_region_patch.y);
+}
+
+/**
+ * Get a number that identifies a road region patch on the whole map.
+ * @param road_region_patch The patch.
+ * @return Unique key of the patch.
+ */
+uint GetRoadRegionPatchKey(const RoadRegionPatchDesc &road_region_patch)
+{
+	/* A region has at most one patch per tile, so labels never exceed the number of tiles. */
+	return GetRoadRegionIndex(road_region_patch) * (ROAD_REGION_NUMBER_OF_TILES + 1) + road_region_patch.label;
+}
+
+/**
+ * Get the index of the road region a tile is in.
+ * @param tile The tile.
+ * @return Unique index of the road region.
+ */
+uint GetRoadRegionIndex(TileIndex tile)
+{
+	return GetRoadRegionIndex(TileX(tile) / ROAD_REGION_EDGE_LENGTH, TileY(tile) / ROAD_REGION_EDGE_LENGTH);
+}
+
+/**
+ * Get the generation of a road region. The generation changes whenever anything in the
+ * region changes that could matter to road vehicles, so data derived from the region can
+ * be kept as long as the generation stays the same.
+ * @param index Index of the road region.
+ * @return The generation.
+ */
+uint32 GetRoadRegionGeneration(uint index)
+{
+	return _road_regions[index].generation;
+}
+
+/**
+ * Get the number of times all road regions were reset, for example because a game was loaded.
+ * @return The count.
+ */
+uint32 GetRoadRegionsResetCount()
+{
+	return _road_regions_reset_count;
+}
+
+/**
+ * Get a number that changes whenever anything in any road region changes that could matter
+ * to road vehicles, or when all road regions are reset.
+ * @return The generation of the road network as a whole.
+ */
+uint32 GetRoadRegionsGeneration()
+{
+	return _road_region_generation;
+}
+
+/**
+ * Get the index of a tile within the label array of its road region.
+ * @param tile The tile.
+ * @return Index into RoadRegionLayer::tile_patch_labels.
+ */
+static inline uint GetLocalTileIndex(TileIndex tile)
+{
+	return (TileY(tile) % ROAD_REGION_EDGE_LENGTH) * ROAD_REGION_EDGE_LENGTH + TileX(tile) % ROAD_REGION_EDGE_LENGTH;
+}
+
+/**
+ * Get the tile at a given position along an edge of a road region.
+ * @param region_x X coordinate of the region.
+ * @param region_y Y coordinate of the region.
+ * @param side The edge of the region.
+ * @param x_or_y Position along the edge, i.e. the local y coordinate for the north east and south west edges and the local x coordinate otherwise.
+ * @return The tile.
+ */
+static TileIndex GetEdgeTile(int region_x, int region_y, DiagDirection side, uint x_or_y)
+{
+	uint x = region_x * ROAD_REGION_EDGE_LENGTH;
+	uint y = region_y * ROAD_REGION_EDGE_LENGTH;
+	switch (side) {
+		case DIAGDIR_NE: return TileXY(x, y + x_or_y);
+		case DIAGDIR_SE: return TileXY(x + x_or_y, y + ROAD_REGION_EDGE_LENGTH - 1);
+		case DIAGDIR_SW: return TileXY(x + ROAD_REGION_EDGE_LENGTH - 1, y + x_or_y);
+		case DIAGDIR_NW: return TileXY(x + x_or_y, y);
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Get the sides of a tile that its road or tram track reaches.
+ * @param tile The tile.
+ * @param rtt Whether to look at the road or the tram track.
+ * @return Bit per DiagDirection.
+ */
+static uint8 GetRoadSides(TileIndex tile, RoadTramType rtt)
+{
+	uint8 sides = 0;
+	for (TrackdirBits tdb = GetTrackdirBitsForRoad(tile, rtt); tdb != TRACKDIR_BIT_NONE; tdb = KillFirstBit(tdb)) {
+		Trackdir td = (Trackdir)FindFirstBit2x64(tdb);
+		SetBit(sides, TrackdirToExitdir(td));
+		SetBit(sides, TrackdirToExitdir(ReverseTrackdir(td)));
+	}
+	return sides;
+}
+
+/**
+ * Label the patches of one type of track in a road region, and determine where the track leaves it.
+ * @param layer The connectivity to fill.
+ * @param tile_area The tiles of the region.
+ * @param rtt Whether to look at the road or the tram track.
+ */
+static void UpdateRoadRegionLayer(RoadRegionLayer &layer, const OrthogonalTileArea &tile_area, RoadTramType rtt)
+{
+	layer.tile_patch_labels.clear();
+	layer.edge_traversability_bits.fill(0);
+	layer.cross_region_links.clear();
+
+	RoadRegionPatchLabel current_label = INVALID_ROAD_REGION_PATCH;
+	std::vector<TileIndex> tiles_to_check;
+
+	for (TileIndex start_tile : tile_area) {
+		if (!layer.tile_patch_labels.empty() && layer.tile_patch_labels[GetLocalTileIndex(start_tile)] != INVALID_ROAD_REGION_PATCH) continue;
+		if (GetRoadSides(start_tile, rtt) == 0) continue;
+
+		if (layer.tile_patch_labels.empty()) layer.tile_patch_labels.resize(ROAD_REGION_NUMBER_OF_TILES, INVALID_ROAD_REGION_PATCH);
+
+		current_label++;
+		assert(current_label <= ROAD_REGION_NUMBER_OF_TILES);
+		layer.tile_patch_labels[GetLocalTileIndex(start_tile)] = current_label;
+		tiles_to_check.push_back(start_tile);
+
+		while (!tiles_to_check.empty()) {
+			TileIndex tile = tiles_to_check.back();
+			tiles_to_check.pop_back();
+
+			uint8 sides = GetRoadSides(tile, rtt);
+			for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) {
+				if (!HasBit(sides, side)) continue;
+
+				TileIndex neighbour;
+				if (IsTileType(tile, MP_TUNNELBRIDGE) && GetTunnelBridgeDirection(tile) == side) {
+					/* Road vehicles jump to the far end of tunnels and bridges. */
+					neighbour = GetOtherTunnelBridgeEnd(tile);
+					if (!tile_area.Contains(neighbour)) {
+						layer.cross_region_links.emplace_back(current_label, neighbour);
+						continue;
+					}
+				} else {
+					TileIndexDiffC offset = TileIndexDiffCByDiagDir(side);
+					uint x = TileX(tile) + offset.x;
+					uint y = TileY(tile) + offset.y;
+					if (x < TileX(tile_area.tile) || x >= TileX(tile_area.tile) + tile_area.w || y < TileY(tile_area.tile) || y >= TileY(tile_area.tile) + tile_area.h) {
+						uint x_or_y = DiagDirToAxis(side) == AXIS_X ? TileY(tile) % ROAD_REGION_EDGE_LENGTH : TileX(tile) % ROAD_REGION_EDGE_LENGTH;
+						SetBit(layer.edge_traversability_bits[side], x_or_y);
+						continue;
+					}
+					neighbour = TileXY(x, y);
+					if (!HasBit(GetRoadSides(neighbour, rtt), ReverseDiagDir(side))) continue;
+				}
+
+				RoadRegionPatchLabel &label = layer.tile_patch_labels[GetLocalTileIndex(neighbour)];
+				if (label == INVALID_ROAD_REGION_PATCH) {
+					label = current_label;
+					tiles_to_check.push_back(neighbour);
+				}
+			}
+		}
+	}
+}
+
+/**
+ * Get the road region at the given region coordinates, and bring it up to date first if needed.
+ * @param region_x X coordinate of the region.
+ * @param region_y Y coordinate of the region.
+ * @return The road region.
+ */
+static const RoadRegion &GetUpdatedRoadRegion(int region_x, int region_y)
+{
+	RoadRegion &region = _road_regions[GetRoadRegionIndex(region_x, region_y)];
+	if (!region.initialized) {
+		const OrthogonalTileArea tile_area(TileXY(region_x * ROAD_REGION_EDGE_LENGTH, region_y * ROAD_REGION_EDGE_LENGTH), ROAD_REGION_EDGE_LENGTH, ROAD_REGION_EDGE_LENGTH);
+		UpdateRoadRegionLayer(region.layers[RTT_ROAD], tile_area, RTT_ROAD);
+		UpdateRoadRegionLayer(region.layers[RTT_TRAM], tile_area, RTT_TRAM);
+		region.initialized = true;
+	}
+	return region;
+}
+
+/**
+ * Get the patch label of a tile from its road region.
+ * @param layer The up to date connectivity of the region.
+ * @param tile The tile.
+ * @return The label.
+ */
+static inline RoadRegionPatchLabel GetLabel(const RoadRegionLayer &layer, TileIndex tile)
+{
+	return layer.tile_patch_labels.empty() ? INVALID_ROAD_REGION_PATCH : layer.tile_patch_labels[GetLocalTileIndex(tile)];
+}
+
+/**
+ * Get the road region patch a tile belongs to.
+ * @param tile The tile.
+ * @param rtt Whether to look at the road or the tram track.
+ * @return The patch; its label is #INVALID_ROAD_REGION_PATCH when the tile has no track of the type.
+ */
+RoadRegionPatchDesc GetRoadRegionPatchInfo(TileIndex tile, RoadTramType rtt)
+{
+	int region_x = TileX(tile) / ROAD_REGION_EDGE_LENGTH;
+	int region_y = TileY(tile) / ROAD_REGION_EDGE_LENGTH;
+	return { region_x, region_y, GetLabel(GetUpdatedRoadRegion(region_x, region_y).layers[rtt], tile) };
+}
+
+/**
+ * Mark the road region of a tile as out of date, for example after road was built or removed on the tile.
+ * @param tile The changed tile.
+ */
+void InvalidateRoadRegion(TileIndex tile)
+{
+	RoadRegion &region = _road_regions[GetRoadRegionIndex(tile)];
+	region.initialized = false;
+	region.generation = ++_road_region_generation;
+}
+
+/**
+ * Mark the road regions of all tiles that share the northern corner of a tile as out of date,
+ * for example after the height of the corner changed.
+ * @param tile The tile.
+ */
+void InvalidateRoadRegionsAroundCorner(TileIndex tile)
+{
+	InvalidateRoadRegion(tile);
+
+	bool west_edge = TileX(tile) % ROAD_REGION_EDGE_LENGTH == 0 && TileX(tile) != 0;
+	bool east_edge = TileY(tile) % ROAD_REGION_EDGE_LENGTH == 0 && TileY(tile) != 0;
+	if (west_edge) InvalidateRoadRegion(tile - TileDiffXY(1, 0));
+	if (east_edge) InvalidateRoadRegion(tile - TileDiffXY(0, 1));
+	if (west_edge && east_edge) InvalidateRoadRegion(tile - TileDiffXY(1, 1));
+}
+
+/**
+ * Call a function for every road region patch directly connected to the given one.
+ * The connections are conservative: they are there when any vehicle, whatever its road type,
+ * might be able to drive between the patches, in whatever direction one way roads allow it to.
+ * @param patch The patch to find the neighbours of.
+ * @param rtt Whether to look at the road or the tram track.
+ * @param callback Function to call for every neighbour.
+ */
+void VisitRoadRegionPatchNeighbours(const RoadRegionPatchDesc &patch, RoadTramType rtt, const VisitRoadRegionPatchCallback &callback)
+{
+	const RoadRegionLayer &layer = GetUpdatedRoadRegion(patch.x, patch.y).layers[rtt];
+
+	for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) {
+		RoadRegionTraversabilityBits traversability_bits = layer.edge_traversability_bits[side];
+		if (traversability_bits == 0) continue;
+
+		TileIndexDiffC offset = TileIndexDiffCByDiagDir(side);
+		int neighbour_x = patch.x + offset.x;
+		int neighbour_y = patch.y + offset.y;
+		if (neighbour_x < 0 || neighbour_y < 0 || neighbour_x >= (int)GetRoadRegionMapSizeX() || neighbour_y >= (int)GetRoadRegionMapSizeY()) continue;
+
+		const RoadRegionLayer &neighbour = GetUpdatedRoadRegion(neighbour_x, neighbour_y).layers[rtt];
+		traversability_bits &= neighbour.edge_traversability_bits[ReverseDiagDir(side)];
+
+		for (uint x_or_y = 0; x_or_y < ROAD_REGION_EDGE_LENGTH; x_or_y++) {
+			if (!HasBit(traversability_bits, x_or_y)) continue;
+			if (GetLabel(layer, GetEdgeTile(patch.x, patch.y, side, x_or_y)) != patch.label) continue;
+
+			callback(RoadRegionPatchDesc{ neighbour_x, neighbour_y, GetLabel(neighbour, GetEdgeTile(neighbour_x, neighbour_y, ReverseDiagDir(side), x_or_y)) });
+		}
+	}
+
+	for (const auto &link : layer.cross_region_links) {
+		if (link.first == patch.label) callback(GetRoadRegionPatchInfo(link.second, rtt));
+	}
+}
+
+/** Size the road regions to the map, and mark all of them as out of date. */
+void AllocateRoadRegions()
+{
+	_road_regions.clear();
+	_road_regions.resize(GetRoadRegionMapSizeX() * GetRoadRegionMapSizeY());
+	for (RoadRegion &region : _road_regions) {
+		region.initialized = false;
+		region.generation = ++_road_region_generation;
+	}
+	_road_regions_reset_count++;
+}
@@ -0,0 +1,51 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file road_regions.h Handles dividing the road network in the map into regions to assist pathfinding. */
+
+#ifndef ROAD_REGIONS_H
+#define ROAD_REGIONS_H
+
+#include "../map_region_func.h"
+
+#include <functional>
+
+enum RoadTramType : bool;
+
+typedef uint16 RoadRegionPatchLabel; ///< Label of a patch of connected road tiles within a road region; every tile of a region can be a patch of its own.
+
+static const uint ROAD_REGION_EDGE_LENGTH = 16; ///< Number of tiles along each edge of a road region.
+static const uint ROAD_REGION_NUMBER_OF_TILES = ROAD_REGION_EDGE_LENGTH * ROAD_REGION_EDGE_LENGTH; ///< Number of tiles in a road region.
+static const RoadRegionPatchLabel INVALID_ROAD_REGION_PATCH = 0; ///< Label of tiles without road or tram track of the asked type.
+
+/** Describes a single patch of connected road tiles within a road region. */
+struct RoadRegionPatchDesc {
+	int x;                      ///< X coordinate of the road region, i.e. the tile x coordinate divided by #ROAD_REGION_EDGE_LENGTH.
+	int y;                      ///< Y coordinate of the road region, i.e. the tile y coordinate divided by #ROAD_REGION_EDGE_LENGTH.
+	RoadRegionPatchLabel label; ///< Label of the patch within its region, #INVALID_ROAD_REGION_PATCH if there is no road.
+
+	bool operator==(const RoadRegionPatchDesc &other) const { return this->x == other.x && this->y == other.y && this->label == other.label; }
+	bool operator!=(const RoadRegionPatchDesc &other) const { return !(*this == other); }
+};
+
+/** Callback for every road region patch that is directly reachable from another patch. */
+typedef std::function<void(const RoadRegionPatchDesc &)> VisitRoadRegionPatchCallback;
+
+void AllocateRoadRegions();
+
+uint32 GetRoadRegionsResetCount();
+uint32 GetRoadRegionsGeneration();
+uint GetNumberOfRoadRegions();
+uint GetRoadRegionIndex(TileIndex tile);
+uint GetRoadRegionIndex(const RoadRegionPatchDesc &road_region_patch);
+uint GetRoadRegionPatchKey(const RoadRegionPatchDesc &road_region_patch);
+uint32 GetRoadRegionGeneration(uint index);
+
+RoadRegionPatchDesc GetRoadRegionPatchInfo(TileIndex tile, RoadTramType rtt);
+void VisitRoadRegionPatchNeighbours(const RoadRegionPatchDesc &patch, RoadTramType rtt, const VisitRoadRegionPatchCallback &callback);
+
+#endif /* ROAD_REGIONS_H */
@@ -0,0 +1,335 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file water_regions.cpp Handles dividing the water in the map into square regions to assist pathfinding. */
+
+#include "../stdafx.h"
+#include "../map_func.h"
+#include "../ship.h"
+#include "../tilearea_type.h"
+#include "../tunnelbridge_map.h"
+#include "follow_track.hpp"
+#include "water_regions.h"
+
+#include <array>
+#include <vector>
+
+#include "../safeguards.h"
+
+typedef uint16 WaterRegionTraversabilityBits; ///< Bit per tile along an edge of a water region, set when ships can leave the region there.
+
+/**
+ * Connectivity of the water within a square part of the map.
+ * The water tiles are split into patches of tiles that ships can travel between without leaving the region.
+ * The information is only calculated when it is first asked for after the region has been invalidated.
+ */
+struct WaterRegion {
+	std::array<WaterRegionTraversabilityBits, DIAGDIR_END> edge_traversability_bits; ///< Per side, the positions along the edge where ships can move into the neighbouring region.
+	std::array<WaterRegionPatchLabel, WATER_REGION_NUMBER_OF_TILES> tile_patch_labels; ///< Patch label of every tile, #INVALID_WATER_REGION_PATCH for tiles ships can't use.
+	bool has_cross_region_aqueducts; ///< Whether an aqueduct leads from this region into another one.
+	bool initialized;                ///< Whether the information of the region is up to date.
+};
+
+static std::vector<WaterRegion> _water_regions; ///< All water regions, row by row.
+
+/**
+ * Get the number of water regions along the x axis of the map.
+ * @return The number of water regions.
+ */
+static inline uint GetWaterRegionMapSizeX()
+{
+	return MapSizeX() / WATER_REGION_EDGE_LENGTH;
+}
+
+/**
+ * Get the number of water regions along the y axis of the map.
+ * @return The number of water regions.
+ */
+static inline uint GetWaterRegionMapSizeY()
+{
+	return MapSizeY() / WATER_REGION_EDGE_LENGTH;
+}
+
+/**
+ * Get the total number of water regions of the map.
+ * @return The number of water regions.
+ */
+uint GetNumberOfWaterRegions()
+{
+	return GetWaterRegionMapSizeX() * GetWaterRegionMapSizeY();
+}
+
+/**
+ * Get the index of the water region at the given region coordinates.
+ * @param region_x X coordinate of the region.
+ * @param region_y Y coordinate of the region.
+ * @return Index into #_water_regions.
+ */
+static inline uint GetWaterRegionIndex(int region_x, int region_y)
+{
+	return region_y * GetWaterRegionMapSizeX() + region_x;
+}
+
+/**
+ * Get the index of the water region a tile is in.
+ * @param tile The tile.
+ * @return Index into #_water_regions.
+ */
+static inline uint GetWaterRegionIndex(TileIndex tile)
+{
+	return GetWaterRegionIndex(TileX(tile) / WATER_REGION_EDGE_LENGTH, TileY(tile) / WATER_REGION_EDGE_LENGTH);
+}
+
+/**
+ * Get the index of the water region of a patch.
+ * @param water_region_patch The patch.
+ * @return Unique index of the water region.
+ */
+uint GetWaterRegionIndex(const WaterRegionPatchDesc &water_region_patch)
+{
+	return GetWaterRegionIndex(water_region_patch.x, water_region_patch.y);
+}
+
+/**
+ * Get the northern tile of a water region.
+ * @param region_x X coordinate of the region.
+ * @param region_y Y coordinate of the region.
+ * @return The tile.
+ */
+static inline TileIndex GetWaterRegionBaseTile(int region_x, int region_y)
+{
+	return TileXY(region_x * WATER_REGION_EDGE_LENGTH, region_y * WATER_REGION_EDGE_LENGTH);
+}
+
+/**
+ * Get the tile in the middle of the water region of a patch.
+ * @param water_region_patch The patch.
+ * @return The tile.
+ */
+TileIndex GetWaterRegionCenterTile(const WaterRegionPatchDesc &water_region_patch)
+{
+	return TileXY(water_region_patch.x * WATER_REGION_EDGE_LENGTH + WATER_REGION_EDGE_LENGTH / 2, water_region_patch.y * WATER_REGION_EDGE_LENGTH + WATER_REGION_EDGE_LENGTH / 2);
+}
+
+/**
+ * Get the index of a tile within the label array of its water region.
+ * @param tile The tile.
+ * @return Index into WaterRegion::tile_patch_labels.
+ */
+static inline uint GetLocalTileIndex(TileIndex tile)
+{
+	return (TileY(tile) % WATER_REGION_EDGE_LENGTH) * WATER_REGION_EDGE_LENGTH + TileX(tile) % WATER_REGION_EDGE_LENGTH;
+}
+
+/**
+ * Get the tile at a given position along an edge of a water region.
+ * @param region_x X coordinate of the region.
+ * @param region_y Y coordinate of the region.
+ * @param side The edge of the region.
+ * @param x_or_y Position along the edge, i.e. the local y coordinate for the north east and south west edges and the local x coordinate otherwise.
+ * @return The tile.
+ */
+static TileIndex GetEdgeTile(int region_x, int region_y, DiagDirection side, uint x_or_y)
+{
+	uint x = region_x * WATER_REGION_EDGE_LENGTH;
+	uint y = region_y * WATER_REGION_EDGE_LENGTH;
+	switch (side) {
+		case DIAGDIR_NE: return TileXY(x, y + x_or_y);
+		case DIAGDIR_SE: return TileXY(x + x_or_y, y + WATER_REGION_EDGE_LENGTH - 1);
+		case DIAGDIR_SW: return TileXY(x + WATER_REGION_EDGE_LENGTH - 1, y + x_or_y);
+		case DIAGDIR_NW: return TileXY(x + x_or_y, y);
+		default: NOT_REACHED();
+	}
+}
+
+/**
+ * Check whether a tile is the start of an aqueduct.
+ * @param tile The tile.
+ * @return True if ships can enter an aqueduct at the tile.
+ */
+static inline bool IsAqueductTile(TileIndex tile)
+{
+	return IsBridgeTile(tile) && GetTunnelBridgeTransportType(tile) == TRANSPORT_WATER;
+}
+
+/**
+ * Get the trackdirs ships can use on a tile.
+ * @param tile The tile.
+ * @return The trackdirs.
+ */
+static inline TrackdirBits GetWaterTrackdirs(TileIndex tile)
+{
+	return TrackStatusToTrackdirBits(GetTileTrackStatus(tile, TRANSPORT_WATER, 0));
+}
+
+/**
+ * Label the patches of a water region and determine where ships can leave it.
+ * Tiles are connected by the same track follower the ship pathfinder uses, so ships can
+ * travel between any two tiles of a patch.
+ * @param region_x X coordinate of the region.
+ * @param region_y Y coordinate of the region.
+ */
+static void UpdateWaterRegion(int region_x, int region_y)
+{
+	WaterRegion &region = _water_regions[GetWaterRegionIndex(region_x, region_y)];
+	const OrthogonalTileArea tile_area(GetWaterRegionBaseTile(region_x, region_y), WATER_REGION_EDGE_LENGTH, WATER_REGION_EDGE_LENGTH);
+
+	region.edge_traversability_bits.fill(0);
+	region.tile_patch_labels.fill(INVALID_WATER_REGION_PATCH);
+	region.has_cross_region_aqueducts = false;
+
+	WaterRegionPatchLabel current_label = INVALID_WATER_REGION_PATCH;
+	std::vector<TileIndex> tiles_to_check;
+
+	for (TileIndex start_tile : tile_area) {
+		if (region.tile_patch_labels[GetLocalTileIndex(start_tile)] != INVALID_WATER_REGION_PATCH) continue;
+		if (GetWaterTrackdirs(start_tile) == TRACKDIR_BIT_NONE) continue;
+
+		current_label++;
+		assert(current_label != INVALID_WATER_REGION_PATCH);
+		region.tile_patch_labels[GetLocalTileIndex(start_tile)] = current_label;
+		tiles_to_check.push_back(start_tile);
+
+		while (!tiles_to_check.empty()) {
+			TileIndex tile = tiles_to_check.back();
+			tiles_to_check.pop_back();
+
+			for (TrackdirBits tdb = GetWaterTrackdirs(tile); tdb != TRACKDIR_BIT_NONE; tdb = KillFirstBit(tdb)) {
+				Trackdir td = (Trackdir)FindFirstBit2x64(tdb);
+
+				CFollowTrackWater ft;
+				if (!ft.Follow(tile, td)) continue;
+
+				if (tile_area.Contains(ft.m_new_tile)) {
+					WaterRegionPatchLabel &label = region.tile_patch_labels[GetLocalTileIndex(ft.m_new_tile)];
+					if (label == INVALID_WATER_REGION_PATCH) {
+						label = current_label;
+						tiles_to_check.push_back(ft.m_new_tile);
+					}
+				} else if (ft.m_is_bridge) {
+					region.has_cross_region_aqueducts = true;
+				} else {
+					DiagDirection side = DiagdirBetweenTiles(tile, ft.m_new_tile);
+					uint x_or_y = DiagDirToAxis(side) == AXIS_X ? TileY(tile) % WATER_REGION_EDGE_LENGTH : TileX(tile) % WATER_REGION_EDGE_LENGTH;
+					SetBit(region.edge_traversability_bits[side], x_or_y);
+				}
+			}
+		}
+	}
+
+	region.initialized = true;
+}
+
+/**
+ * Get the water region at the given region coordinates, and bring it up to date first if needed.
+ * @param region_x X coordinate of the region.
+ * @param region_y Y coordinate of the region.
+ * @return The water region.
+ */
+static const WaterRegion &GetUpdatedWaterRegion(int region_x, int region_y)
+{
+	const WaterRegion &region = _water_regions[GetWaterRegionIndex(region_x, region_y)];
+	if (!region.initialized) UpdateWaterRegion(region_x, region_y);
+	return region;
+}
+
+/**
+ * Get the patch label of a tile from its water region.
+ * @param region The up to date water region of the tile.
+ * @param tile The tile.
+ * @return The label.
+ */
+static inline WaterRegionPatchLabel GetLabel(const WaterRegion &region, TileIndex tile)
+{
+	return region.tile_patch_labels[GetLocalTileIndex(tile)];
+}
+
+/**
+ * Get the water region patch a tile belongs to.
+ * @param tile The tile.
+ * @return The patch; its label is #INVALID_WATER_REGION_PATCH when ships can't use the tile.
+ */
+WaterRegionPatchDesc GetWaterRegionPatchInfo(TileIndex tile)
+{
+	int region_x = TileX(tile) / WATER_REGION_EDGE_LENGTH;
+	int region_y = TileY(tile) / WATER_REGION_EDGE_LENGTH;
+	return { region_x, region_y, GetLabel(GetUpdatedWaterRegion(region_x, region_y), tile) };
+}
+
+/**
+ * Mark the water region of a tile as out of date, for example after the tile changed type.
+ * A change to a tile at the edge of a region can also change where ships can leave the
+ * neighbouring region, so that region is marked as out of date as well.
+ * @param tile The changed tile.
+ */
+void InvalidateWaterRegion(TileIndex tile)
+{
+	_water_regions[GetWaterRegionIndex(tile)].initialized = false;
+
+	for (DiagDirection dir = DIAGDIR_BEGIN; dir < DIAGDIR_END; dir++) {
+		TileIndex neighbour = AddTileIndexDiffCWrap(tile, TileIndexDiffCByDiagDir(dir));
+		if (neighbour == INVALID_TILE) continue;
+
+		uint index = GetWaterRegionIndex(neighbour);
+		if (index != GetWaterRegionIndex(tile)) _water_regions[index].initialized = false;
+	}
+}
+
+/**
+ * Call a function for every water region patch ships can move to directly from the given one.
+ * The neighbours are visited in a fixed order, so the pathfinder gives the same results for all clients.
+ * @param water_region_patch The patch to find the neighbours of.
+ * @param callback Function to call for every neighbour.
+ */
+void VisitWaterRegionPatchNeighbours(const WaterRegionPatchDesc &water_region_patch, const VisitWaterRegionPatchCallback &callback)
+{
+	const WaterRegion &region = GetUpdatedWaterRegion(water_region_patch.x, water_region_patch.y);
+
+	for (DiagDirection side = DIAGDIR_BEGIN; side < DIAGDIR_END; side++) {
+		WaterRegionTraversabilityBits traversability_bits = region.edge_traversability_bits[side];
+		if (traversability_bits == 0) continue;
+
+		/* The edge bits are only set where ships can actually enter the neighbouring tile, so the neighbouring region exists. */
+		TileIndexDiffC offset = TileIndexDiffCByDiagDir(side);
+		int neighbour_x = water_region_patch.x + offset.x;
+		int neighbour_y = water_region_patch.y + offset.y;
+		const WaterRegion &neighbour = GetUpdatedWaterRegion(neighbour_x, neighbour_y);
+
+		std::array<WaterRegionPatchLabel, WATER_REGION_EDGE_LENGTH> unique_labels;
+		uint num_labels = 0;
+		for (uint x_or_y = 0; x_or_y < WATER_REGION_EDGE_LENGTH; x_or_y++) {
+			if (!HasBit(traversability_bits, x_or_y)) continue;
+			if (GetLabel(region, GetEdgeTile(water_region_patch.x, water_region_patch.y, side, x_or_y)) != water_region_patch.label) continue;
+
+			WaterRegionPatchLabel neighbour_label = GetLabel(neighbour, GetEdgeTile(neighbour_x, neighbour_y, ReverseDiagDir(side), x_or_y));
+			assert(neighbour_label != INVALID_WATER_REGION_PATCH);
+			if (std::find(unique_labels.begin(), unique_labels.begin() + num_labels, neighbour_label) == unique_labels.begin() + num_labels) {
+				unique_labels[num_labels++] = neighbour_label;
+			}
+		}
+
+		for (uint i = 0; i < num_labels; i++) callback({ neighbour_x, neighbour_y, unique_labels[i] });
+	}
+
+	if (region.has_cross_region_aqueducts) {
+		const OrthogonalTileArea tile_area(GetWaterRegionBaseTile(water_region_patch.x, water_region_patch.y), WATER_REGION_EDGE_LENGTH, WATER_REGION_EDGE_LENGTH);
+		for (TileIndex tile : tile_area) {
+			if (GetLabel(region, tile) != water_region_patch.label || !IsAqueductTile(tile)) continue;
+
+			TileIndex other_end = GetOtherBridgeEnd(tile);
+			if (GetWaterRegionIndex(other_end) != GetWaterRegionIndex(tile)) callback(GetWaterRegionPatchInfo(other_end));
+		}
+	}
+}
+
+/** Size the water regions to the map, and mark all of them as out of date. */
+void AllocateWaterRegions()
+{
+	_water_regions.clear();
+	_water_regions.resize(GetNumberOfWaterRegions());
+	for (WaterRegion &region : _water_regions) region.initialized = false;
+}
@@ -0,0 +1,45 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file water_regions.h Handles dividing the water in the map into regions to assist pathfinding. */
+
+#ifndef WATER_REGIONS_H
+#define WATER_REGIONS_H
+
+#include "../map_region_func.h"
+
+#include <functional>
+
+typedef uint8 WaterRegionPatchLabel; ///< Label of a patch of connected water tiles within a water region.
+
+static const uint WATER_REGION_EDGE_LENGTH = 16; ///< Number of tiles along each edge of a water region.
+static const uint WATER_REGION_NUMBER_OF_TILES = WATER_REGION_EDGE_LENGTH * WATER_REGION_EDGE_LENGTH; ///< Number of tiles in a water region.
+static const WaterRegionPatchLabel INVALID_WATER_REGION_PATCH = 0; ///< Label of tiles that ships can't use.
+
+/** Describes a single patch of connected water tiles within a water region. */
+struct WaterRegionPatchDesc {
+	int x;                       ///< X coordinate of the water region, i.e. the tile x coordinate divided by #WATER_REGION_EDGE_LENGTH.
+	int y;                       ///< Y coordinate of the water region, i.e. the tile y coordinate divided by #WATER_REGION_EDGE_LENGTH.
+	WaterRegionPatchLabel label; ///< Label of the patch within its region, #INVALID_WATER_REGION_PATCH if there is no water.
+
+	bool operator==(const WaterRegionPatchDesc &other) const { return this->x == other.x && this->y == other.y && this->label == other.label; }
+	bool operator!=(const WaterRegionPatchDesc &other) const { return !(*this == other); }
+};
+
+/** Callback for every water region patch that is directly reachable from another patch. */
+typedef std::function<void(const WaterRegionPatchDesc &)> VisitWaterRegionPatchCallback;
+
+void AllocateWaterRegions();
+
+uint GetNumberOfWaterRegions();
+uint GetWaterRegionIndex(const WaterRegionPatchDesc &water_region_patch);
+TileIndex GetWaterRegionCenterTile(const WaterRegionPatchDesc &water_region_patch);
+WaterRegionPatchDesc GetWaterRegionPatchInfo(TileIndex tile);
+
+void VisitWaterRegionPatchNeighbours(const WaterRegionPatchDesc &water_region_patch, const VisitWaterRegionPatchCallback &callback);
+
+#endif /* WATER_REGIONS_H */
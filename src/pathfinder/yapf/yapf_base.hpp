@@ -12,6 +12,7 @@
 
 #include "../../debug.h"
 #include "../../settings_type.h"
+#include "../pathfinder_log.h"
 
 /**
  * CYapfBaseT - A-star type path finder base class.
@@ -139,6 +140,8 @@ public:
 
 		bDestFound &= (m_pBestDestNode != nullptr);
 
+		if (_pathfinder_logging) LogPathfinderSearch(m_nodes.ClosedCount(), m_stats_cache_hits);
+
 		if (_debug_yapf_level >= 3) {
 			UnitID veh_idx = (m_veh != nullptr) ? m_veh->unitnumber : 0;
 			char ttc = Yapf().TransportTypeChar();
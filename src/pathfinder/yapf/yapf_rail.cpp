@@ -16,6 +16,7 @@
 #include "yapf_destrail.hpp"
 #include "../../viewport_func.h"
 #include "../../newgrf_station.h"
+#include "../../profile_probe.h"
 
 #include "../../safeguards.h"
 
@@ -528,8 +529,14 @@ struct CYapfAnySafeTileRail1 : CYapfT<CYapfRail_TypesT<CYapfAnySafeTileRail1, CF
 struct CYapfAnySafeTileRail2 : CYapfT<CYapfRail_TypesT<CYapfAnySafeTileRail2, CFollowTrackFreeRailNo90, CRailNodeListTrackDir, CYapfDestinationAnySafeTileRailT , CYapfFollowAnySafeTileRailT> > {};
 
 
+/** Probe for profiling YapfTrainChooseTrack. */
+static ProfileProbe _probe_yapf_train_choose_track("YapfTrainChooseTrack");
+
 Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, bool reserve_track, PBSTileInfo *target)
 {
+	ProfileScope profile(_probe_yapf_train_choose_track);
+	PathfinderQueryLog log(PFQ_YAPF_TRAIN, v, tile);
+
 	/* default is YAPF type 2 */
 	typedef Trackdir (*PfnChooseRailTrack)(const Train*, TileIndex, DiagDirection, TrackBits, bool&, bool, PBSTileInfo*);
 	PfnChooseRailTrack pfnChooseRailTrack = &CYapfRail1::stChooseRailTrack;
@@ -540,7 +547,9 @@ Track YapfTrainChooseTrack(const Train *v, TileIndex tile, DiagDirection enterdi
 	}
 
 	Trackdir td_ret = pfnChooseRailTrack(v, tile, enterdir, tracks, path_found, reserve_track, target);
-	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : FindFirstTrack(tracks);
+	Track track = (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : FindFirstTrack(tracks);
+	log.SetResult(track, path_found);
+	return track;
 }
 
 bool YapfTrainCheckReverse(const Train *v)
@@ -640,4 +649,7 @@ int CSegmentCostCacheBase::s_rail_change_counter = 0;
 void YapfNotifyTrackLayoutChange(TileIndex tile, Track track)
 {
 	CSegmentCostCacheBase::NotifyTrackLayoutChange(tile, track);
+	/* The cached signal blocks and reservation ends depend on the track layout as well. */
+	InvalidateSignalSegmentCache();
+	InvalidateReservationCache();
 }
@@ -11,9 +11,176 @@
 #include "yapf.hpp"
 #include "yapf_node_road.hpp"
 #include "../../roadstop_base.h"
+#include "../../profile_probe.h"
+#include "../road_regions.h"
+#include "yapf_road_regions.h"
+
+#include <unordered_map>
 
 #include "../../safeguards.h"
 
+/** Key of a cached road segment; besides its start, the route depends on what the vehicle may drive on. */
+struct CYapfRoadSegmentKey {
+	TileIndex    m_tile;
+	Trackdir     m_td;
+	RoadTramType m_rtt;
+	Owner        m_owner;
+	RoadTypes    m_compatible_roadtypes;
+
+	inline bool operator==(const CYapfRoadSegmentKey &other) const
+	{
+		return m_tile == other.m_tile && m_td == other.m_td && m_rtt == other.m_rtt && m_owner == other.m_owner && m_compatible_roadtypes == other.m_compatible_roadtypes;
+	}
+};
+
+/** Hash function for the keys of cached road segments. */
+struct CYapfRoadSegmentKeyHash {
+	inline size_t operator()(const CYapfRoadSegmentKey &key) const
+	{
+		return ((size_t)key.m_tile << 4 | key.m_td) ^ (size_t)key.m_owner << 24 ^ (size_t)key.m_rtt << 29 ^ std::hash<uint64>()(key.m_compatible_roadtypes);
+	}
+};
+
+/** Consecutive steps along a road segment with the same speed limit. */
+struct CYapfRoadSpeedLimit {
+	int  m_max_speed;     ///< maximum speed on the steps
+	int  m_min_speed;     ///< minimum speed on the steps
+	int  m_tiles_skipped; ///< tunnel or bridge tiles skipped by each step
+	uint m_count;         ///< number of steps
+};
+
+/**
+ * Cached route and cost of a road segment. Costs that depend on the vehicle, like
+ *  speed limits, or that change all the time, like road stop occupancy, are only
+ *  stored as what they depend on, and are added when the segment is used.
+ */
+struct CYapfRoadSegment {
+	TileIndex m_last_tile; ///< last tile of the segment
+	Trackdir  m_last_td;   ///< last trackdir of the segment
+	bool      m_valid;     ///< false if the segment is a loop without any junction
+	int       m_cost;      ///< cost of all tiles except road stops, without speed limit penalties
+	std::vector<std::pair<TileIndex, Trackdir>> m_stops;        ///< road stop tiles along the segment
+	std::vector<CYapfRoadSpeedLimit>            m_speed_limits; ///< speed limits along the segment
+	std::vector<std::pair<uint, uint32>>        m_regions;      ///< index and generation of every road region the segment depends on
+
+	/**
+	 * Make the segment depend on the road region of a tile.
+	 * @param tile The tile.
+	 */
+	void AddRegion(TileIndex tile)
+	{
+		uint index = GetRoadRegionIndex(tile);
+		for (const auto &region : m_regions) {
+			if (region.first == index) return;
+		}
+		m_regions.emplace_back(index, GetRoadRegionGeneration(index));
+	}
+
+	/**
+	 * Check whether none of the road regions the segment depends on changed since it was cached.
+	 * @return True if the segment can still be used.
+	 */
+	bool IsUpToDate() const
+	{
+		for (const auto &region : m_regions) {
+			if (GetRoadRegionGeneration(region.first) != region.second) return false;
+		}
+		return true;
+	}
+};
+
+/** Storage of cached road segments. */
+typedef std::unordered_map<CYapfRoadSegmentKey, CYapfRoadSegment, CYapfRoadSegmentKeyHash> CYapfRoadSegmentCache;
+
+static const size_t MAX_CACHED_ROAD_SEGMENTS = 1 << 16; ///< number of segments after which the cache is cleared
+
+/**
+ * Get the global storage of road segments. It is shared by all road YAPF types,
+ *  as the route and cost of a segment don't depend on how the nodes are keyed.
+ * @return The segment cache.
+ */
+static CYapfRoadSegmentCache &GetGlobalRoadSegmentCache()
+{
+	static uint32 last_reset_count = 0;
+	static uint32 last_penalties[3] = {};
+	static CYapfRoadSegmentCache C;
+
+	/* the cached costs include these penalties; and a new map makes all segments useless */
+	const YAPFSettings &settings = _settings_game.pf.yapf;
+	uint32 penalties[3] = { settings.road_slope_penalty, settings.road_curve_penalty, settings.road_crossing_penalty };
+	if (last_reset_count != GetRoadRegionsResetCount() || !std::equal(penalties, penalties + 3, last_penalties) || C.size() >= MAX_CACHED_ROAD_SEGMENTS) {
+		last_reset_count = GetRoadRegionsResetCount();
+		std::copy(penalties, penalties + 3, last_penalties);
+		C.clear();
+	}
+	return C;
+}
+
+/**
+ * CYapfSegmentCostCacheRoadT - the yapf cost cache provider for road vehicles. Segments
+ *  are kept until any road region they pass through changes, so unlike the rail cache
+ *  the cache doesn't have to be thrown away whenever anything is built.
+ */
+template <class Types>
+class CYapfSegmentCostCacheRoadT
+{
+public:
+	typedef typename Types::Tpf Tpf;              ///< the pathfinder class (derived from THIS class)
+	typedef typename Types::NodeList::Titem Node; ///< this will be our node type
+
+protected:
+	CYapfRoadSegmentCache  &m_global_cache;
+	const CYapfRoadSegment *m_segment; ///< cached segment of the node whose cost is calculated next, nullptr if it must be walked
+
+	inline CYapfSegmentCostCacheRoadT() : m_global_cache(GetGlobalRoadSegmentCache()), m_segment(nullptr) {};
+
+	/** to access inherited path finder */
+	inline Tpf& Yapf()
+	{
+		return *static_cast<Tpf *>(this);
+	}
+
+public:
+	/**
+	 * Called by YAPF to attach cached segment cost data to the given node.
+	 *  @return true if globally cached data were used or false if the segment has to be walked
+	 */
+	inline bool PfNodeCacheFetch(Node &n)
+	{
+		m_segment = nullptr;
+		if (!Yapf().CanUseGlobalCache(n)) return false;
+
+		const RoadVehicle *v = Yapf().GetVehicle();
+		CYapfRoadSegmentKey key = { n.GetTile(), n.GetTrackdir(), GetRoadTramType(v->roadtype), v->owner, v->compatible_roadtypes };
+		auto it = m_global_cache.find(key);
+		bool found = it != m_global_cache.end() && it->second.IsUpToDate();
+		if (it == m_global_cache.end()) it = m_global_cache.emplace(key, CYapfRoadSegment()).first;
+		if (!found) Yapf().RecordSegment(n, it->second);
+
+		/* the cached segment doesn't end at the destination, so stop tiles that are the destination must be walked */
+		for (const auto &stop : it->second.m_stops) {
+			if (Yapf().PfDetectDestinationTile(stop.first, stop.second)) return false;
+		}
+
+		m_segment = &it->second;
+		return found;
+	}
+
+	/**
+	 * Called by YAPF to flush the cached segment cost data back into cache storage.
+	 *  Current cache implementation doesn't use that.
+	 */
+	inline void PfNodeCacheFlush(Node &n)
+	{
+	}
+
+	/** Get the cached segment for the node whose cost is calculated next, or nullptr if it must be walked. */
+	inline const CYapfRoadSegment *GetCachedSegment() const
+	{
+		return m_segment;
+	}
+};
+
 
 template <class Types>
 class CYapfCostRoadT
@@ -98,38 +265,60 @@ protected:
 		return cost;
 	}
 
-public:
-	inline void SetMaxCost(int max_cost)
+	/** return the penalty for the speed limit on one step, depending on the speed the vehicle wants to drive at */
+	inline static int SpeedLimitCost(int max_veh_speed, int max_speed, int min_speed, int tiles_skipped)
 	{
-		m_max_cost = max_cost;
+		int cost = 0;
+		if (max_speed < max_veh_speed) cost += YAPF_TILE_LENGTH * (max_veh_speed - max_speed) * (4 + tiles_skipped) / max_veh_speed;
+		if (min_speed > max_veh_speed) cost += YAPF_TILE_LENGTH * (min_speed - max_veh_speed);
+		return cost;
 	}
 
 	/**
-	 * Called by YAPF to calculate the cost from the origin to the given node.
-	 *  Calculates only the cost of given node, adds it to the parent node cost
-	 *  and stores the result into Node::m_cost member
+	 * Walk from the start of a segment to its end, and store the end in the node.
+	 * @param n Node the segment starts at.
+	 * @param parent_cost Cost of the path up to the segment.
+	 * @param[out] segment_cost Cost of the segment.
+	 * @param segment If not nullptr, walk regardless of the destination, and store the route and the
+	 *                costs that can't be cached in it instead of adding them to the segment cost.
+	 * @return False if the node can't be used.
 	 */
-	inline bool PfCalcCost(Node &n, const TrackFollower *tf)
+	inline bool WalkSegment(Node &n, int parent_cost, int &segment_cost, CYapfRoadSegment *segment)
 	{
-		int segment_cost = 0;
 		uint tiles = 0;
 		/* start at n.m_key.m_tile / n.m_key.m_td and walk to the end of segment */
 		TileIndex tile = n.m_key.m_tile;
 		Trackdir trackdir = n.m_key.m_td;
-		int parent_cost = (n.m_parent != nullptr) ? n.m_parent->m_cost : 0;
+		const RoadVehicle *v = Yapf().GetVehicle();
+		int max_veh_speed = std::min<int>(v->GetDisplayMaxSpeed(), v->current_order.GetMaxSpeed() * 2);
 
 		for (;;) {
-			/* base tile cost depending on distance between edges */
-			segment_cost += Yapf().OneTileCost(tile, trackdir);
+			if (segment != nullptr && IsTileType(tile, MP_STATION)) {
+				/* road stop costs depend on their occupation */
+				segment->m_stops.emplace_back(tile, trackdir);
+			} else {
+				/* base tile cost depending on distance between edges */
+				segment_cost += Yapf().OneTileCost(tile, trackdir);
+			}
 
-			const RoadVehicle *v = Yapf().GetVehicle();
-			/* we have reached the vehicle's destination - segment should end here to avoid target skipping */
-			if (Yapf().PfDetectDestinationTile(tile, trackdir)) break;
+			if (segment == nullptr) {
+				/* we have reached the vehicle's destination - segment should end here to avoid target skipping */
+				if (Yapf().PfDetectDestinationTile(tile, trackdir)) break;
 
-			/* Finish if we already exceeded the maximum path cost (i.e. when
-			 * searching for the nearest depot). */
-			if (m_max_cost > 0 && (parent_cost + segment_cost) > m_max_cost) {
-				return false;
+				/* Finish if we already exceeded the maximum path cost (i.e. when
+				 * searching for the nearest depot). */
+				if (m_max_cost > 0 && (parent_cost + segment_cost) > m_max_cost) {
+					return false;
+				}
+			} else {
+				/* the segment depends on this tile and on the one the follower looks at next */
+				segment->AddRegion(tile);
+				DiagDirection exitdir = TrackdirToExitdir(trackdir);
+				if (IsTileType(tile, MP_TUNNELBRIDGE) && GetTunnelBridgeDirection(tile) == exitdir) {
+					segment->AddRegion(GetOtherTunnelBridgeEnd(tile));
+				} else if (TileAddByDiagDir(tile, exitdir) < MapSize()) {
+					segment->AddRegion(TileAddByDiagDir(tile, exitdir));
+				}
 			}
 
 			/* stop if we have just entered the depot */
@@ -148,7 +337,10 @@ public:
 			Trackdir new_td = (Trackdir)FindFirstBit2x64(F.m_new_td_bits);
 
 			/* stop if RV is on simple loop with no junctions */
-			if (F.m_new_tile == n.m_key.m_tile && new_td == n.m_key.m_td) return false;
+			if (F.m_new_tile == n.m_key.m_tile && new_td == n.m_key.m_td) {
+				if (segment != nullptr) segment->m_valid = false;
+				return false;
+			}
 
 			/* if we skipped some tunnel tiles, add their cost */
 			segment_cost += F.m_tiles_skipped * YAPF_TILE_LENGTH;
@@ -159,10 +351,15 @@ public:
 
 			/* add min/max speed penalties */
 			int min_speed = 0;
-			int max_veh_speed = std::min<int>(v->GetDisplayMaxSpeed(), v->current_order.GetMaxSpeed() * 2);
 			int max_speed = F.GetSpeedLimit(&min_speed);
-			if (max_speed < max_veh_speed) segment_cost += YAPF_TILE_LENGTH * (max_veh_speed - max_speed) * (4 + F.m_tiles_skipped) / max_veh_speed;
-			if (min_speed > max_veh_speed) segment_cost += YAPF_TILE_LENGTH * (min_speed - max_veh_speed);
+			if (segment == nullptr) {
+				segment_cost += SpeedLimitCost(max_veh_speed, max_speed, min_speed, F.m_tiles_skipped);
+			} else if (!segment->m_speed_limits.empty() && segment->m_speed_limits.back().m_max_speed == max_speed &&
+					segment->m_speed_limits.back().m_min_speed == min_speed && segment->m_speed_limits.back().m_tiles_skipped == F.m_tiles_skipped) {
+				segment->m_speed_limits.back().m_count++;
+			} else {
+				segment->m_speed_limits.push_back({ max_speed, min_speed, F.m_tiles_skipped, 1 });
+			}
 
 			/* move to the next tile */
 			tile = F.m_new_tile;
@@ -173,6 +370,66 @@ public:
 		/* save end of segment back to the node */
 		n.m_segment_last_tile = tile;
 		n.m_segment_last_td = trackdir;
+		return true;
+	}
+
+public:
+	inline void SetMaxCost(int max_cost)
+	{
+		m_max_cost = max_cost;
+	}
+
+	/** Check whether the cost of a node may be taken from the global segment cache. */
+	inline bool CanUseGlobalCache(Node &n)
+	{
+		return m_max_cost == 0 && n.m_parent != nullptr && Yapf().CanSkipDestinationTileCheck(n.GetTile());
+	}
+
+	/**
+	 * Walk a segment to store it in the global segment cache.
+	 * @param n Node the segment starts at.
+	 * @param[out] segment The segment to fill.
+	 */
+	inline void RecordSegment(Node &n, CYapfRoadSegment &segment)
+	{
+		segment = CYapfRoadSegment();
+		segment.m_valid = true;
+		segment.m_cost = 0;
+		WalkSegment(n, 0, segment.m_cost, &segment);
+		segment.m_last_tile = n.m_segment_last_tile;
+		segment.m_last_td = n.m_segment_last_td;
+	}
+
+	/**
+	 * Called by YAPF to calculate the cost from the origin to the given node.
+	 *  Calculates only the cost of given node, adds it to the parent node cost
+	 *  and stores the result into Node::m_cost member
+	 */
+	inline bool PfCalcCost(Node &n, const TrackFollower *tf)
+	{
+		int segment_cost = 0;
+		int parent_cost = (n.m_parent != nullptr) ? n.m_parent->m_cost : 0;
+
+		const CYapfRoadSegment *segment = Yapf().GetCachedSegment();
+		if (segment != nullptr) {
+			if (!segment->m_valid) return false;
+
+			/* add the costs that weren't cached */
+			segment_cost = segment->m_cost;
+			for (const auto &stop : segment->m_stops) {
+				segment_cost += Yapf().OneTileCost(stop.first, stop.second);
+			}
+			const RoadVehicle *v = Yapf().GetVehicle();
+			int max_veh_speed = std::min<int>(v->GetDisplayMaxSpeed(), v->current_order.GetMaxSpeed() * 2);
+			for (const CYapfRoadSpeedLimit &limit : segment->m_speed_limits) {
+				segment_cost += limit.m_count * SpeedLimitCost(max_veh_speed, limit.m_max_speed, limit.m_min_speed, limit.m_tiles_skipped);
+			}
+
+			n.m_segment_last_tile = segment->m_last_tile;
+			n.m_segment_last_td = segment->m_last_td;
+		} else if (!WalkSegment(n, parent_cost, segment_cost, nullptr)) {
+			return false;
+		}
 
 		/* save also tile cost */
 		n.m_cost = parent_cost + segment_cost;
@@ -207,6 +464,12 @@ public:
 		return IsRoadDepotTile(tile);
 	}
 
+	/** Check whether segments starting at the tile can only reach the destination at their end or at a road stop. */
+	inline bool CanSkipDestinationTileCheck(TileIndex tile) const
+	{
+		return false;
+	}
+
 	/**
 	 * Called by YAPF to calculate cost estimate. Calculates distance to the destination
 	 *  adds it to the actual cost from origin and stores the sum to the Node::m_estimate
@@ -256,6 +519,34 @@ public:
 		return m_dest_station != INVALID_STATION ? Station::GetIfValid(m_dest_station) : nullptr;
 	}
 
+	/**
+	 * Get the road region patches of the destination.
+	 * @param rtt Whether the vehicle drives on road or on tram track.
+	 * @return The patches of all road stops of the destination station, or the patch of the destination tile.
+	 */
+	std::vector<RoadRegionPatchDesc> GetDestinationRegionPatches(RoadTramType rtt) const
+	{
+		std::vector<RoadRegionPatchDesc> patches;
+		if (m_dest_station == INVALID_STATION) {
+			patches.push_back(GetRoadRegionPatchInfo(m_destTile, rtt));
+			return patches;
+		}
+
+		const Station *st = GetDestinationStation();
+		if (st == nullptr) return patches;
+		for (const RoadStop *rs = st->GetPrimaryRoadStop(m_bus ? ROADSTOP_BUS : ROADSTOP_TRUCK); rs != nullptr; rs = rs->next) {
+			patches.push_back(GetRoadRegionPatchInfo(rs->xy, rtt));
+		}
+		return patches;
+	}
+
+	/** Check whether segments starting at the tile can only reach the destination at their end or at a road stop. */
+	inline bool CanSkipDestinationTileCheck(TileIndex tile) const
+	{
+		/* Stations can only be reached at road stops; a depot tile only at the end of the segment, as the segment ends there, unless it starts there. */
+		return m_dest_station != INVALID_STATION || m_destTrackdirs == TRACKDIR_BIT_NONE || (IsRoadDepotTile(m_destTile) && tile != m_destTile);
+	}
+
 protected:
 	/** to access inherited path finder */
 	Tpf& Yapf()
@@ -314,6 +605,8 @@ public:
 
 
 
+static const int ROAD_REGION_CORRIDOR_MIN_DISTANCE = 2; ///< Distance in road regions to the destination from which the search is limited to a corridor.
+
 template <class Types>
 class CYapfFollowRoadT
 {
@@ -324,6 +617,8 @@ public:
 	typedef typename Node::Key Key;                      ///< key to hash tables
 
 protected:
+	std::vector<uint> m_search_patches; ///< if not empty, the keys of the only road region patches the search may enter, sorted
+
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
 	{
@@ -331,6 +626,72 @@ protected:
 	}
 
 public:
+	/**
+	 * Limit the search to a corridor along a route over the road regions: the patches
+	 *  of the route, and the patches directly connected to them.
+	 * @param path The patches along the route.
+	 * @param rtt Whether the vehicle drives on road or on tram track.
+	 */
+	void RestrictSearch(const std::vector<RoadRegionPatchDesc> &path, RoadTramType rtt)
+	{
+		m_search_patches.clear();
+		for (const RoadRegionPatchDesc &road_region_patch : path) {
+			m_search_patches.push_back(GetRoadRegionPatchKey(road_region_patch));
+			VisitRoadRegionPatchNeighbours(road_region_patch, rtt, [&](const RoadRegionPatchDesc &neighbour) {
+				m_search_patches.push_back(GetRoadRegionPatchKey(neighbour));
+			});
+		}
+		std::sort(m_search_patches.begin(), m_search_patches.end());
+		m_search_patches.erase(std::unique(m_search_patches.begin(), m_search_patches.end()), m_search_patches.end());
+	}
+
+	/**
+	 * Check whether the search is limited to a corridor.
+	 * @return True if RestrictSearch was called.
+	 */
+	inline bool IsSearchRestricted() const
+	{
+		return !m_search_patches.empty();
+	}
+
+	/**
+	 * Check whether the search may enter a tile.
+	 * @param tile The tile.
+	 * @return True if the search isn't restricted, or the tile is in one of the allowed patches.
+	 */
+	inline bool IsInSearchArea(TileIndex tile)
+	{
+		if (m_search_patches.empty()) return true;
+		RoadRegionPatchDesc patch = GetRoadRegionPatchInfo(tile, GetRoadTramType(Yapf().GetVehicle()->roadtype));
+		return std::binary_search(m_search_patches.begin(), m_search_patches.end(), GetRoadRegionPatchKey(patch));
+	}
+
+	/**
+	 * Find the route over the road regions to the destination, and limit the search to a
+	 *  corridor along it. Destinations in or next to the region of the tile are searched for
+	 *  directly, as the corridor wouldn't save anything.
+	 * @param v The vehicle.
+	 * @param tile The tile the search starts at.
+	 * @return False if the road network doesn't connect the tile to the destination at all.
+	 */
+	inline bool RestrictSearchToRegionRoute(const RoadVehicle *v, TileIndex tile)
+	{
+		RoadTramType rtt = GetRoadTramType(v->roadtype);
+		RoadRegionPatchDesc start = GetRoadRegionPatchInfo(tile, rtt);
+		if (start.label == INVALID_ROAD_REGION_PATCH) return true;
+
+		std::vector<RoadRegionPatchDesc> destinations = Yapf().GetDestinationRegionPatches(rtt);
+		for (const RoadRegionPatchDesc &destination : destinations) {
+			if (abs(destination.x - start.x) + abs(destination.y - start.y) < ROAD_REGION_CORRIDOR_MIN_DISTANCE) return true;
+		}
+
+		std::vector<RoadRegionPatchDesc> path;
+		if (!YapfRoadVehicleFindRoadRegionPath(v, tile, destinations, path)) return false;
+
+		/* When the search over the road regions gave up, search the whole network. */
+		if (!path.empty()) RestrictSearch(path, rtt);
+		return true;
+	}
 
 	/**
 	 * Called by YAPF to move from the given node to the next tile. For each
@@ -340,7 +701,7 @@ public:
 	inline void PfFollowNode(Node &old_node)
 	{
 		TrackFollower F(Yapf().GetVehicle());
-		if (F.Follow(old_node.m_segment_last_tile, old_node.m_segment_last_td)) {
+		if (F.Follow(old_node.m_segment_last_tile, old_node.m_segment_last_td) && IsInSearchArea(F.m_new_tile)) {
 			Yapf().AddMultipleNodes(&old_node, F);
 		}
 	}
@@ -378,9 +739,36 @@ public:
 		Yapf().SetOrigin(src_tile, src_trackdirs);
 		Yapf().SetDestination(v);
 
+		/* Search along the route over the road regions only. Without such a route the
+		 * vehicle is lost, and the whole network is searched like it always was. */
+		Yapf().RestrictSearchToRegionRoute(v, src_tile);
+
 		/* find the best path */
 		path_found = Yapf().FindPath(v);
 
+		if (!path_found && IsSearchRestricted()) {
+			/* The road regions don't know about one way roads and road types, so the corridor
+			 * can miss the route. Search the whole network then. */
+			Tpf pf;
+			pf.SetOrigin(src_tile, src_trackdirs);
+			pf.SetDestination(v);
+			path_found = pf.FindPath(v);
+			return pf.ExtractRoadVehPath(v, tile, path_found, path_cache);
+		}
+
+		return ExtractRoadVehPath(v, tile, path_found, path_cache);
+	}
+
+	/**
+	 * Turn the result of a search into the trackdir to take next, and fill the path cache.
+	 * @param v The vehicle.
+	 * @param tile Tile the vehicle is about to enter.
+	 * @param path_found Whether the search found the destination.
+	 * @param path_cache [out] Choices to make after the next one.
+	 * @return The trackdir to take on \a tile, or INVALID_TRACKDIR if there is none.
+	 */
+	inline Trackdir ExtractRoadVehPath(const RoadVehicle *v, TileIndex tile, bool path_found, RoadVehPathCache &path_cache)
+	{
 		/* if path not found - return INVALID_TRACKDIR */
 		Trackdir next_trackdir = INVALID_TRACKDIR;
 		Node *pNode = Yapf().GetBestNode();
@@ -449,8 +837,20 @@ public:
 		/* if path not found - return distance = UINT_MAX */
 		uint dist = UINT_MAX;
 
+		/* no need to search when the road network doesn't connect to the destination at all */
+		if (!Yapf().RestrictSearchToRegionRoute(v, v->tile)) return dist;
+
 		/* find the best path */
-		if (!Yapf().FindPath(v)) return dist;
+		if (!Yapf().FindPath(v)) {
+			if (!IsSearchRestricted()) return dist;
+
+			/* the corridor along the route over the road regions can miss the route; search the whole network then */
+			Tpf pf;
+			pf.SetOriginFromVehiclePos(v);
+			pf.SetDestination(v);
+			if (!pf.FindPath(v)) return dist;
+			return pf.GetBestNode()->GetCostEstimate();
+		}
 
 		Node *pNode = Yapf().GetBestNode();
 		if (pNode != nullptr) {
@@ -518,7 +918,7 @@ struct CYapfRoad_TypesT
 	typedef CYapfFollowRoadT<Types>           PfFollow;
 	typedef CYapfOriginTileT<Types>           PfOrigin;
 	typedef Tdestination<Types>               PfDestination;
-	typedef CYapfSegmentCostCacheNoneT<Types> PfCache;
+	typedef CYapfSegmentCostCacheRoadT<Types> PfCache;
 	typedef CYapfCostRoadT<Types>             PfCost;
 };
 
@@ -529,8 +929,14 @@ struct CYapfRoadAnyDepot1 : CYapfT<CYapfRoad_TypesT<CYapfRoadAnyDepot1, CRoadNod
 struct CYapfRoadAnyDepot2 : CYapfT<CYapfRoad_TypesT<CYapfRoadAnyDepot2, CRoadNodeListExitDir , CYapfDestinationAnyDepotRoadT> > {};
 
 
+/** Probe for profiling YapfRoadVehicleChooseTrack. */
+static ProfileProbe _probe_yapf_road_choose_track("YapfRoadVehicleChooseTrack");
+
 Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDirection enterdir, TrackdirBits trackdirs, bool &path_found, RoadVehPathCache &path_cache)
 {
+	ProfileScope profile(_probe_yapf_road_choose_track);
+	PathfinderQueryLog log(PFQ_YAPF_ROAD, v, tile);
+
 	/* default is YAPF type 2 */
 	typedef Trackdir (*PfnChooseRoadTrack)(const RoadVehicle*, TileIndex, DiagDirection, bool &path_found, RoadVehPathCache &path_cache);
 	PfnChooseRoadTrack pfnChooseRoadTrack = &CYapfRoad2::stChooseRoadTrack; // default: ExitDir, allow 90-deg
@@ -541,7 +947,9 @@ Trackdir YapfRoadVehicleChooseTrack(const RoadVehicle *v, TileIndex tile, DiagDi
 	}
 
 	Trackdir td_ret = pfnChooseRoadTrack(v, tile, enterdir, path_found, path_cache);
-	return (td_ret != INVALID_TRACKDIR) ? td_ret : (Trackdir)FindFirstBit2x64(trackdirs);
+	if (td_ret == INVALID_TRACKDIR) td_ret = (Trackdir)FindFirstBit2x64(trackdirs);
+	log.SetResult(td_ret, path_found);
+	return td_ret;
 }
 
 FindDepotData YapfRoadVehicleFindNearestDepot(const RoadVehicle *v, int max_distance)
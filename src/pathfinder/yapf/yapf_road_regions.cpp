@@ -0,0 +1,373 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_road_regions.cpp Implementation of YAPF for road regions, which are used for limiting the area road vehicles search. */
+
+#include "../../stdafx.h"
+#include "../../roadveh.h"
+
+#include "yapf.hpp"
+#include "yapf_road_regions.h"
+
+#include <map>
+
+#include "../../safeguards.h"
+
+static const int ROAD_REGION_NEIGHBOUR_COST = 100; ///< Cost of moving from a road region to one next to it.
+
+/** Yapf Node Key that represents a single patch of connected road tiles within a road region. */
+struct CYapfRoadRegionPatchNodeKey {
+	RoadRegionPatchDesc m_road_region_patch;
+
+	inline void Set(const RoadRegionPatchDesc &road_region_patch)
+	{
+		m_road_region_patch = road_region_patch;
+	}
+
+	inline int CalcHash() const
+	{
+		return GetRoadRegionPatchKey(m_road_region_patch);
+	}
+
+	inline bool operator==(const CYapfRoadRegionPatchNodeKey &other) const
+	{
+		return m_road_region_patch == other.m_road_region_patch;
+	}
+};
+
+/**
+ * Get the cost of moving directly between two road region patches.
+ * @param a The first patch.
+ * @param b The second patch.
+ * @return The Manhattan distance between the regions, in cost units.
+ */
+static inline int ManhattanDistance(const CYapfRoadRegionPatchNodeKey &a, const CYapfRoadRegionPatchNodeKey &b)
+{
+	return (abs(a.m_road_region_patch.x - b.m_road_region_patch.x) + abs(a.m_road_region_patch.y - b.m_road_region_patch.y)) * ROAD_REGION_NEIGHBOUR_COST;
+}
+
+/** Yapf Node for road regions. */
+template <class Tkey_>
+struct CYapfRoadRegionNodeT {
+	typedef Tkey_ Key;
+	typedef CYapfRoadRegionNodeT<Tkey_> Node;
+
+	Tkey_  m_key;
+	Node  *m_hash_next;
+	Node  *m_parent;
+	int    m_cost;
+	int    m_estimate;
+
+	inline void Set(Node *parent, const RoadRegionPatchDesc &road_region_patch)
+	{
+		m_key.Set(road_region_patch);
+		m_hash_next = nullptr;
+		m_parent = parent;
+		m_cost = 0;
+		m_estimate = 0;
+	}
+
+	inline Node *GetHashNext()
+	{
+		return m_hash_next;
+	}
+
+	inline void SetHashNext(Node *pNext)
+	{
+		m_hash_next = pNext;
+	}
+
+	inline const Tkey_ &GetKey() const
+	{
+		return m_key;
+	}
+
+	inline int GetCost() const
+	{
+		return m_cost;
+	}
+
+	inline int GetCostEstimate() const
+	{
+		return m_estimate;
+	}
+
+	inline bool operator<(const Node &other) const
+	{
+		return m_estimate < other.m_estimate;
+	}
+};
+
+/** YAPF origin provider for road regions; any of several patches can be the origin. */
+template <class Types>
+class CYapfOriginRoadRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;              ///< the pathfinder class (derived from THIS class)
+	typedef typename Types::NodeList::Titem Node; ///< this will be our node type
+	typedef typename Node::Key Key;               ///< key to hash tables
+
+protected:
+	std::vector<CYapfRoadRegionPatchNodeKey> m_origin_keys; ///< origin patches
+
+	/** to access inherited path finder */
+	inline Tpf& Yapf()
+	{
+		return *static_cast<Tpf *>(this);
+	}
+
+public:
+	/** Add a patch to the origins, ignoring duplicates and tiles without road. */
+	void AddOrigin(const RoadRegionPatchDesc &road_region_patch)
+	{
+		if (road_region_patch.label == INVALID_ROAD_REGION_PATCH) return;
+		if (!HasOrigin(road_region_patch)) m_origin_keys.push_back(CYapfRoadRegionPatchNodeKey{ road_region_patch });
+	}
+
+	/** Check whether a patch is one of the origins. */
+	bool HasOrigin(const RoadRegionPatchDesc &road_region_patch)
+	{
+		return std::find(m_origin_keys.begin(), m_origin_keys.end(), CYapfRoadRegionPatchNodeKey{ road_region_patch }) != m_origin_keys.end();
+	}
+
+	/** Check whether there is any origin at all. */
+	bool HasAnyOrigin() const
+	{
+		return !m_origin_keys.empty();
+	}
+
+	/** Called when YAPF needs to place origin nodes into open list */
+	void PfSetStartupNodes()
+	{
+		for (const CYapfRoadRegionPatchNodeKey &origin_key : m_origin_keys) {
+			Node &node = Yapf().CreateNewNode();
+			node.Set(nullptr, origin_key.m_road_region_patch);
+			Yapf().AddStartupNode(node);
+		}
+	}
+};
+
+/** YAPF destination provider for road regions. */
+template <class Types>
+class CYapfDestinationRoadRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;              ///< the pathfinder class (derived from THIS class)
+	typedef typename Types::NodeList::Titem Node; ///< this will be our node type
+	typedef typename Node::Key Key;               ///< key to hash tables
+
+protected:
+	Key m_dest; ///< destination patch
+
+public:
+	void SetDestination(const RoadRegionPatchDesc &road_region_patch)
+	{
+		m_dest.Set(road_region_patch);
+	}
+
+	/** Called by YAPF to detect if node ends in the desired destination */
+	inline bool PfDetectDestination(Node &n) const
+	{
+		return n.m_key == m_dest;
+	}
+
+	/**
+	 * Called by YAPF to calculate cost estimate. Calculates distance to the destination
+	 *  adds it to the actual cost from origin and stores the sum to the Node::m_estimate
+	 */
+	inline bool PfCalcEstimate(Node &n)
+	{
+		n.m_estimate = n.m_cost + ManhattanDistance(n.m_key, m_dest);
+		return true;
+	}
+};
+
+/** Node Follower module of YAPF for road regions. */
+template <class Types>
+class CYapfFollowRoadRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;                     ///< the pathfinder class (derived from THIS class)
+	typedef typename Types::TrackFollower TrackFollower;
+	typedef typename Types::NodeList::Titem Node;        ///< this will be our node type
+	typedef typename Node::Key Key;                      ///< key to hash tables
+
+protected:
+	/** to access inherited path finder */
+	inline Tpf& Yapf()
+	{
+		return *static_cast<Tpf *>(this);
+	}
+
+public:
+	/** Called by YAPF to create a node for every patch that can be reached directly from the given one. */
+	inline void PfFollowNode(Node &old_node)
+	{
+		VisitRoadRegionPatchCallback visit = [&](const RoadRegionPatchDesc &road_region_patch) {
+			Node &node = Yapf().CreateNewNode();
+			node.Set(&old_node, road_region_patch);
+			Yapf().AddNewNode(node, TrackFollower{});
+		};
+		VisitRoadRegionPatchNeighbours(old_node.m_key.m_road_region_patch, GetRoadTramType(Yapf().GetVehicle()->roadtype), visit);
+	}
+
+	/** return debug report character to identify the transportation type */
+	inline char TransportTypeChar() const
+	{
+		return '%';
+	}
+
+	/**
+	 * Find a route over the road regions from a tile to the destination of a road vehicle.
+	 * The search runs from the destination towards the vehicle, so a vehicle heading for a
+	 * station with road stops in several regions still only needs a single search.
+	 * @param v The road vehicle.
+	 * @param start_road_region_patch Patch the route starts at.
+	 * @param destinations Patches of the destination.
+	 * @param[out] path The patches along the route, starting with \a start_road_region_patch; empty if no route was found.
+	 * @return False if the destination can't be reached at all, true if it was found or the search gave up.
+	 */
+	static bool FindRoadRegionPath(const RoadVehicle *v, const RoadRegionPatchDesc &start_road_region_patch, const std::vector<RoadRegionPatchDesc> &destinations, std::vector<RoadRegionPatchDesc> &path)
+	{
+		path.clear();
+
+		Tpf pf;
+		pf.SetDestination(start_road_region_patch);
+		for (const RoadRegionPatchDesc &destination : destinations) pf.AddOrigin(destination);
+
+		if (!pf.HasAnyOrigin()) return false;
+
+		if (pf.HasOrigin(start_road_region_patch)) {
+			path.push_back(start_road_region_patch);
+			return true;
+		}
+
+		/* Only when all patches connected to the destination were visited, the vehicle certainly can't get there. */
+		if (!pf.FindPath(v)) return pf.m_nodes.OpenCount() != 0;
+
+		path.push_back(start_road_region_patch);
+		for (Node *node = pf.GetBestNode()->m_parent; node != nullptr; node = node->m_parent) {
+			path.push_back(node->m_key.m_road_region_patch);
+		}
+		return true;
+	}
+};
+
+/** Cost Provider module of YAPF for road regions. */
+template <class Types>
+class CYapfCostRoadRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;              ///< the pathfinder class (derived from THIS class)
+	typedef typename Types::TrackFollower TrackFollower;
+	typedef typename Types::NodeList::Titem Node; ///< this will be our node type
+	typedef typename Node::Key Key;               ///< key to hash tables
+
+	/**
+	 * Called by YAPF to calculate the cost from the origin to the given node.
+	 *  Tunnels and bridges can skip regions, so the cost is the distance between the regions.
+	 */
+	inline bool PfCalcCost(Node &n, const TrackFollower *tf)
+	{
+		n.m_cost = n.m_parent->m_cost + ManhattanDistance(n.m_key, n.m_parent->m_key);
+		return true;
+	}
+};
+
+/** Dummy track follower; the road regions know their neighbours themselves. */
+struct DummyRoadRegionFollower {
+};
+
+/**
+ * Config struct of YAPF for road regions.
+ *  Defines all 6 base YAPF modules as classes providing services for CYapfBaseT.
+ */
+template <class Tpf_, class Tnode_list>
+struct CYapfRoadRegion_TypesT
+{
+	/** Types - shortcut for this struct type */
+	typedef CYapfRoadRegion_TypesT<Tpf_, Tnode_list> Types;
+
+	/** Tpf - pathfinder type */
+	typedef Tpf_                                Tpf;
+	/** track follower helper class */
+	typedef DummyRoadRegionFollower             TrackFollower;
+	/** node list type */
+	typedef Tnode_list                          NodeList;
+	typedef RoadVehicle                         VehicleType;
+	/** pathfinder components (modules) */
+	typedef CYapfBaseT<Types>                   PfBase;        // base pathfinder class
+	typedef CYapfFollowRoadRegionT<Types>       PfFollow;      // node follower
+	typedef CYapfOriginRoadRegionT<Types>       PfOrigin;      // origin provider
+	typedef CYapfDestinationRoadRegionT<Types>  PfDestination; // destination/distance provider
+	typedef CYapfSegmentCostCacheNoneT<Types>   PfCache;       // segment cost cache provider
+	typedef CYapfCostRoadRegionT<Types>         PfCost;        // cost provider
+};
+
+typedef CNodeList_HashTableT<CYapfRoadRegionNodeT<CYapfRoadRegionPatchNodeKey>, 12, 12> CRoadRegionNodeList;
+
+/** YAPF for road regions, limited by the same node limit as the search over the tiles. */
+struct CYapfRoadRegion : CYapfT<CYapfRoadRegion_TypesT<CYapfRoadRegion, CRoadRegionNodeList> > {};
+
+/** Result of a search over the road regions. */
+struct CYapfRoadRegionRoute {
+	bool                             m_reachable; ///< false if the destination can't be reached at all
+	std::vector<RoadRegionPatchDesc> m_path;      ///< patches along the route, empty if no route was found
+};
+
+/** Results of searches over the road regions, by track type, start patch and destination patches. */
+typedef std::map<std::vector<uint>, CYapfRoadRegionRoute> CYapfRoadRegionRouteCache;
+
+static const size_t MAX_CACHED_ROAD_REGION_ROUTES = 1 << 12; ///< number of routes after which the cache is cleared
+
+/**
+ * Get the storage of the results of searches over the road regions. A search only depends on
+ *  the road regions and the node limit, so the results are kept until either changes.
+ * @return The route cache.
+ */
+static CYapfRoadRegionRouteCache &GetRoadRegionRouteCache()
+{
+	static uint32 last_generation = 0;
+	static uint32 last_max_search_nodes = 0;
+	static CYapfRoadRegionRouteCache C;
+
+	uint32 max_search_nodes = _settings_game.pf.yapf.max_search_nodes;
+	if (last_generation != GetRoadRegionsGeneration() || last_max_search_nodes != max_search_nodes || C.size() >= MAX_CACHED_ROAD_REGION_ROUTES) {
+		last_generation = GetRoadRegionsGeneration();
+		last_max_search_nodes = max_search_nodes;
+		C.clear();
+	}
+	return C;
+}
+
+/**
+ * Find a route over the road regions from a tile to the destination of a road vehicle.
+ * @param v The road vehicle.
+ * @param start_tile Tile the route starts at.
+ * @param destinations Patches of the destination.
+ * @param[out] path The patches along the route, starting with the patch of \a start_tile; empty if no route was found.
+ * @return False if the destination can't be reached at all, true if it was found or the search gave up.
+ */
+bool YapfRoadVehicleFindRoadRegionPath(const RoadVehicle *v, TileIndex start_tile, const std::vector<RoadRegionPatchDesc> &destinations, std::vector<RoadRegionPatchDesc> &path)
+{
+	RoadTramType rtt = GetRoadTramType(v->roadtype);
+	const RoadRegionPatchDesc start_road_region_patch = GetRoadRegionPatchInfo(start_tile, rtt);
+
+	std::vector<uint> key = { (uint)rtt, GetRoadRegionPatchKey(start_road_region_patch) };
+	for (const RoadRegionPatchDesc &destination : destinations) key.push_back(GetRoadRegionPatchKey(destination));
+
+	CYapfRoadRegionRouteCache &cache = GetRoadRegionRouteCache();
+	auto it = cache.find(key);
+	if (it == cache.end()) {
+		CYapfRoadRegionRoute route;
+		route.m_reachable = CYapfRoadRegion::FindRoadRegionPath(v, start_road_region_patch, destinations, route.m_path);
+		it = cache.emplace(std::move(key), std::move(route)).first;
+	}
+
+	path = it->second.m_path;
+	return it->second.m_reachable;
+}
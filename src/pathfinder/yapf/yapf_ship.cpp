@@ -11,12 +11,16 @@
 #include "../../ship.h"
 #include "../../industry.h"
 #include "../../vehicle_func.h"
+#include "../../profile_probe.h"
 
 #include "yapf.hpp"
 #include "yapf_node_ship.hpp"
+#include "yapf_ship_regions.h"
 
 #include "../../safeguards.h"
 
+static const uint SHIP_PATH_REGIONS_LOOKAHEAD = 4; ///< Number of water regions beyond the current one the tile search may look ahead.
+
 template <class Types>
 class CYapfDestinationTileWaterT
 {
@@ -31,6 +35,9 @@ protected:
 	TrackdirBits m_destTrackdirs;
 	StationID    m_destStation;
 
+	bool                 m_has_intermediate_dest = false;
+	WaterRegionPatchDesc m_intermediate_dest_region_patch;
+
 public:
 	void SetDestination(const Ship *v)
 	{
@@ -45,6 +52,16 @@ public:
 		}
 	}
 
+	/**
+	 * Stop the search at any tile of a water region patch instead of at the destination.
+	 * @param water_region_patch The patch to find a path to.
+	 */
+	void SetIntermediateDestination(const WaterRegionPatchDesc &water_region_patch)
+	{
+		m_has_intermediate_dest = true;
+		m_intermediate_dest_region_patch = water_region_patch;
+	}
+
 protected:
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
@@ -61,6 +78,10 @@ public:
 
 	inline bool PfDetectDestinationTile(TileIndex tile, Trackdir trackdir)
 	{
+		if (m_has_intermediate_dest) {
+			return GetWaterRegionPatchInfo(tile) == m_intermediate_dest_region_patch;
+		}
+
 		if (m_destStation != INVALID_STATION) {
 			return IsDockingTile(tile) && IsShipDestinationTile(tile, m_destStation);
 		}
@@ -87,6 +108,13 @@ public:
 		int y1 = 2 * TileY(tile) + dg_dir_to_y_offs[(int)exitdir];
 		int x2 = 2 * TileX(m_destTile);
 		int y2 = 2 * TileY(m_destTile);
+		if (m_has_intermediate_dest) {
+			/* Aim for the closest tile of the region, so the estimate never exceeds the actual cost. */
+			int min_x = m_intermediate_dest_region_patch.x * WATER_REGION_EDGE_LENGTH;
+			int min_y = m_intermediate_dest_region_patch.y * WATER_REGION_EDGE_LENGTH;
+			x2 = 2 * Clamp<int>(TileX(tile), min_x, min_x + WATER_REGION_EDGE_LENGTH - 1);
+			y2 = 2 * Clamp<int>(TileY(tile), min_y, min_y + WATER_REGION_EDGE_LENGTH - 1);
+		}
 		int dx = abs(x1 - x2);
 		int dy = abs(y1 - y2);
 		int dmin = std::min(dx, dy);
@@ -110,6 +138,8 @@ public:
 	typedef typename Node::Key Key;                      ///< key to hash tables
 
 protected:
+	std::vector<WaterRegionPatchDesc> m_search_patches; ///< if not empty, the only water region patches the search may enter
+
 	/** to access inherited path finder */
 	inline Tpf& Yapf()
 	{
@@ -117,6 +147,26 @@ protected:
 	}
 
 public:
+	/**
+	 * Limit the search to the given water region patches.
+	 * @param water_region_patches The patches the search may enter.
+	 */
+	void RestrictSearch(const std::vector<WaterRegionPatchDesc> &water_region_patches)
+	{
+		m_search_patches = water_region_patches;
+	}
+
+	/**
+	 * Check whether the search may enter a tile.
+	 * @param tile The tile.
+	 * @return True if the search isn't restricted, or the tile is in one of the allowed patches.
+	 */
+	inline bool IsInSearchArea(TileIndex tile) const
+	{
+		if (m_search_patches.empty()) return true;
+		return std::find(m_search_patches.begin(), m_search_patches.end(), GetWaterRegionPatchInfo(tile)) != m_search_patches.end();
+	}
+
 	/**
 	 * Called by YAPF to move from the given node to the next tile. For each
 	 *  reachable trackdir on the new tile creates new node, initializes it
@@ -125,7 +175,7 @@ public:
 	inline void PfFollowNode(Node &old_node)
 	{
 		TrackFollower F(Yapf().GetVehicle());
-		if (F.Follow(old_node.m_key.m_tile, old_node.m_key.m_td)) {
+		if (F.Follow(old_node.m_key.m_tile, old_node.m_key.m_td) && IsInSearchArea(F.m_new_tile)) {
 			Yapf().AddMultipleNodes(&old_node, F);
 		}
 	}
@@ -158,17 +208,51 @@ public:
 		/* convert origin trackdir to TrackdirBits */
 		TrackdirBits trackdirs = TrackdirToTrackdirBits(trackdir);
 
+		/* Find a route over the water regions first. It tells whether the destination can be
+		 * reached at all, and lets the search over the tiles stop a few regions ahead. */
+		std::vector<WaterRegionPatchDesc> high_level_path = YapfShipFindWaterRegionPath(v, tile, SHIP_PATH_REGIONS_LOOKAHEAD + 1);
+		bool reachable = !high_level_path.empty();
+		if (!reachable) high_level_path.push_back(GetWaterRegionPatchInfo(tile));
+		bool is_intermediate_destination = high_level_path.size() > SHIP_PATH_REGIONS_LOOKAHEAD;
+
 		/* create pathfinder instance */
 		Tpf pf;
 		/* set origin and destination nodes */
 		pf.SetOrigin(src_tile, trackdirs);
 		pf.SetDestination(v);
+		if (is_intermediate_destination) pf.SetIntermediateDestination(high_level_path.back());
+		/* Without a route there's no use in searching beyond the current patch; the ship is lost anyway. */
+		if (!reachable) pf.RestrictSearch(high_level_path);
 		/* find best path */
 		path_found = pf.FindPath(v);
 
+		Node *pNode = pf.GetBestNode();
+		if (reachable && !path_found) {
+			/* The search ran out of nodes, for example in a maze of canals. Try again within the regions of the route only. */
+			Tpf pf_restricted;
+			pf_restricted.SetOrigin(src_tile, trackdirs);
+			pf_restricted.SetDestination(v);
+			if (is_intermediate_destination) pf_restricted.SetIntermediateDestination(high_level_path.back());
+			pf_restricted.RestrictSearch(high_level_path);
+			path_found = pf_restricted.FindPath(v);
+			if (path_found) return ExtractShipPath(pf_restricted.GetBestNode(), tile, path_found, path_cache);
+		}
+
+		return ExtractShipPath(pNode, tile, path_found, path_cache);
+	}
+
+	/**
+	 * Turn the result of a search into the trackdir to take next, and fill the path cache.
+	 * @param pNode Best node of the search, or nullptr.
+	 * @param tile Tile the ship is about to enter.
+	 * @param path_found Whether the node is at the destination.
+	 * @param path_cache [out] Trackdirs to follow after the next one.
+	 * @return The trackdir to take on \a tile, or INVALID_TRACKDIR if there is none.
+	 */
+	static Trackdir ExtractShipPath(Node *pNode, TileIndex tile, bool path_found, ShipPathCache &path_cache)
+	{
 		Trackdir next_trackdir = INVALID_TRACKDIR; // this would mean "path not found"
 
-		Node *pNode = pf.GetBestNode();
 		if (pNode != nullptr) {
 			uint steps = 0;
 			for (Node *n = pNode; n->m_parent != nullptr; n = n->m_parent) steps++;
@@ -347,9 +431,15 @@ static inline bool RequireTrackdirKey()
 	return _settings_game.pf.yapf.ship_curve45_penalty != _settings_game.pf.yapf.ship_curve90_penalty;
 }
 
+/** Probe for profiling YapfShipChooseTrack. */
+static ProfileProbe _probe_yapf_ship_choose_track("YapfShipChooseTrack");
+
 /** Ship controller helper - path finder invoker */
 Track YapfShipChooseTrack(const Ship *v, TileIndex tile, DiagDirection enterdir, TrackBits tracks, bool &path_found, ShipPathCache &path_cache)
 {
+	ProfileScope profile(_probe_yapf_ship_choose_track);
+	PathfinderQueryLog log(PFQ_YAPF_SHIP, v, tile);
+
 	/* default is YAPF type 2 */
 	typedef Trackdir (*PfnChooseShipTrack)(const Ship*, TileIndex, DiagDirection, TrackBits, bool &path_found, ShipPathCache &path_cache);
 	PfnChooseShipTrack pfnChooseShipTrack = CYapfShip2::ChooseShipTrack; // default: ExitDir
@@ -360,7 +450,9 @@ Track YapfShipChooseTrack(const Ship *v, TileIndex tile, DiagDirection enterdir,
 	}
 
 	Trackdir td_ret = pfnChooseShipTrack(v, tile, enterdir, tracks, path_found, path_cache);
-	return (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : INVALID_TRACK;
+	Track track = (td_ret != INVALID_TRACKDIR) ? TrackdirToTrack(td_ret) : INVALID_TRACK;
+	log.SetResult(track, path_found);
+	return track;
 }
 
 bool YapfShipCheckReverse(const Ship *v)
@@ -0,0 +1,334 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file yapf_ship_regions.cpp Implementation of YAPF for water regions, which are used for finding intermediate ship destinations. */
+
+#include "../../stdafx.h"
+#include "../../ship.h"
+#include "../../station_base.h"
+
+#include "yapf.hpp"
+#include "yapf_ship_regions.h"
+
+#include "../../safeguards.h"
+
+static const int DIRECT_NEIGHBOUR_COST = 100; ///< Cost of moving from a water region to one next to it.
+static const uint NODES_PER_REGION = 4;       ///< Number of nodes per water region the search may visit; most regions have just one or two patches.
+
+/** Yapf Node Key that represents a single patch of connected water tiles within a water region. */
+struct CYapfRegionPatchNodeKey {
+	WaterRegionPatchDesc m_water_region_patch;
+
+	inline void Set(const WaterRegionPatchDesc &water_region_patch)
+	{
+		m_water_region_patch = water_region_patch;
+	}
+
+	inline int CalcHash() const
+	{
+		return m_water_region_patch.label | GetWaterRegionIndex(m_water_region_patch) << 8;
+	}
+
+	inline bool operator==(const CYapfRegionPatchNodeKey &other) const
+	{
+		return m_water_region_patch == other.m_water_region_patch;
+	}
+};
+
+/**
+ * Get the cost of moving directly between two water region patches.
+ * @param a The first patch.
+ * @param b The second patch.
+ * @return The Manhattan distance between the regions, in cost units.
+ */
+static inline int ManhattanDistance(const CYapfRegionPatchNodeKey &a, const CYapfRegionPatchNodeKey &b)
+{
+	return (abs(a.m_water_region_patch.x - b.m_water_region_patch.x) + abs(a.m_water_region_patch.y - b.m_water_region_patch.y)) * DIRECT_NEIGHBOUR_COST;
+}
+
+/** Yapf Node for water regions. */
+template <class Tkey_>
+struct CYapfRegionNodeT {
+	typedef Tkey_ Key;
+	typedef CYapfRegionNodeT<Tkey_> Node;
+
+	Tkey_  m_key;
+	Node  *m_hash_next;
+	Node  *m_parent;
+	int    m_cost;
+	int    m_estimate;
+
+	inline void Set(Node *parent, const WaterRegionPatchDesc &water_region_patch)
+	{
+		m_key.Set(water_region_patch);
+		m_hash_next = nullptr;
+		m_parent = parent;
+		m_cost = 0;
+		m_estimate = 0;
+	}
+
+	inline Node *GetHashNext()
+	{
+		return m_hash_next;
+	}
+
+	inline void SetHashNext(Node *pNext)
+	{
+		m_hash_next = pNext;
+	}
+
+	inline const Tkey_ &GetKey() const
+	{
+		return m_key;
+	}
+
+	inline int GetCost() const
+	{
+		return m_cost;
+	}
+
+	inline int GetCostEstimate() const
+	{
+		return m_estimate;
+	}
+
+	inline bool operator<(const Node &other) const
+	{
+		return m_estimate < other.m_estimate;
+	}
+};
+
+/** YAPF origin provider for water regions; any of several patches can be the origin. */
+template <class Types>
+class CYapfOriginRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;              ///< the pathfinder class (derived from THIS class)
+	typedef typename Types::NodeList::Titem Node; ///< this will be our node type
+	typedef typename Node::Key Key;               ///< key to hash tables
+
+protected:
+	std::vector<CYapfRegionPatchNodeKey> m_origin_keys; ///< origin patches
+
+	/** to access inherited path finder */
+	inline Tpf& Yapf()
+	{
+		return *static_cast<Tpf *>(this);
+	}
+
+public:
+	/** Add a patch to the origins, ignoring duplicates and tiles without water. */
+	void AddOrigin(const WaterRegionPatchDesc &water_region_patch)
+	{
+		if (water_region_patch.label == INVALID_WATER_REGION_PATCH) return;
+		if (!HasOrigin(water_region_patch)) m_origin_keys.push_back(CYapfRegionPatchNodeKey{ water_region_patch });
+	}
+
+	/** Check whether a patch is one of the origins. */
+	bool HasOrigin(const WaterRegionPatchDesc &water_region_patch)
+	{
+		return std::find(m_origin_keys.begin(), m_origin_keys.end(), CYapfRegionPatchNodeKey{ water_region_patch }) != m_origin_keys.end();
+	}
+
+	/** Check whether there is any origin at all. */
+	bool HasAnyOrigin() const
+	{
+		return !m_origin_keys.empty();
+	}
+
+	/** Called when YAPF needs to place origin nodes into open list */
+	void PfSetStartupNodes()
+	{
+		for (const CYapfRegionPatchNodeKey &origin_key : m_origin_keys) {
+			Node &node = Yapf().CreateNewNode();
+			node.Set(nullptr, origin_key.m_water_region_patch);
+			Yapf().AddStartupNode(node);
+		}
+	}
+};
+
+/** YAPF destination provider for water regions. */
+template <class Types>
+class CYapfDestinationRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;              ///< the pathfinder class (derived from THIS class)
+	typedef typename Types::NodeList::Titem Node; ///< this will be our node type
+	typedef typename Node::Key Key;               ///< key to hash tables
+
+protected:
+	Key m_dest; ///< destination patch
+
+public:
+	void SetDestination(const WaterRegionPatchDesc &water_region_patch)
+	{
+		m_dest.Set(water_region_patch);
+	}
+
+	/** Called by YAPF to detect if node ends in the desired destination */
+	inline bool PfDetectDestination(Node &n) const
+	{
+		return n.m_key == m_dest;
+	}
+
+	/**
+	 * Called by YAPF to calculate cost estimate. Calculates distance to the destination
+	 *  adds it to the actual cost from origin and stores the sum to the Node::m_estimate
+	 */
+	inline bool PfCalcEstimate(Node &n)
+	{
+		n.m_estimate = n.m_cost + ManhattanDistance(n.m_key, m_dest);
+		return true;
+	}
+};
+
+/** Node Follower module of YAPF for water regions. */
+template <class Types>
+class CYapfFollowRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;                     ///< the pathfinder class (derived from THIS class)
+	typedef typename Types::TrackFollower TrackFollower;
+	typedef typename Types::NodeList::Titem Node;        ///< this will be our node type
+	typedef typename Node::Key Key;                      ///< key to hash tables
+
+protected:
+	/** to access inherited path finder */
+	inline Tpf& Yapf()
+	{
+		return *static_cast<Tpf *>(this);
+	}
+
+public:
+	/** Called by YAPF to create a node for every patch that can be reached directly from the given one. */
+	inline void PfFollowNode(Node &old_node)
+	{
+		VisitWaterRegionPatchCallback visit = [&](const WaterRegionPatchDesc &water_region_patch) {
+			Node &node = Yapf().CreateNewNode();
+			node.Set(&old_node, water_region_patch);
+			Yapf().AddNewNode(node, TrackFollower{});
+		};
+		VisitWaterRegionPatchNeighbours(old_node.m_key.m_water_region_patch, visit);
+	}
+
+	/** return debug report character to identify the transportation type */
+	inline char TransportTypeChar() const
+	{
+		return '^';
+	}
+
+	/**
+	 * Find a route over the water regions from a tile to the destination of a ship.
+	 * The search runs from the destination towards the ship, so a ship heading for a
+	 * station with docking tiles in several regions still only needs a single search.
+	 * @param v The ship.
+	 * @param start_tile Tile the route starts at.
+	 * @param max_returned_path_length Maximum number of patches to return.
+	 * @return The patches along the route, starting with the patch of \a start_tile; empty if there is no route.
+	 */
+	static std::vector<WaterRegionPatchDesc> FindWaterRegionPath(const Ship *v, TileIndex start_tile, uint max_returned_path_length)
+	{
+		const WaterRegionPatchDesc start_water_region_patch = GetWaterRegionPatchInfo(start_tile);
+
+		Tpf pf(GetNumberOfWaterRegions() * NODES_PER_REGION);
+		pf.SetDestination(start_water_region_patch);
+		if (v->current_order.IsType(OT_GOTO_STATION)) {
+			StationID station_id = v->current_order.GetDestination();
+			for (TileIndex tile : Station::Get(station_id)->docking_station) {
+				if (IsDockingTile(tile) && IsShipDestinationTile(tile, station_id)) pf.AddOrigin(GetWaterRegionPatchInfo(tile));
+			}
+		} else {
+			pf.AddOrigin(GetWaterRegionPatchInfo(v->dest_tile));
+		}
+
+		if (!pf.HasAnyOrigin()) return {};
+
+		std::vector<WaterRegionPatchDesc> path = { start_water_region_patch };
+		if (pf.HasOrigin(start_water_region_patch)) return path;
+
+		if (!pf.FindPath(v)) return {};
+
+		for (Node *node = pf.GetBestNode()->m_parent; node != nullptr && path.size() < max_returned_path_length; node = node->m_parent) {
+			path.push_back(node->m_key.m_water_region_patch);
+		}
+		return path;
+	}
+};
+
+/** Cost Provider module of YAPF for water regions. */
+template <class Types>
+class CYapfCostRegionT
+{
+public:
+	typedef typename Types::Tpf Tpf;              ///< the pathfinder class (derived from THIS class)
+	typedef typename Types::TrackFollower TrackFollower;
+	typedef typename Types::NodeList::Titem Node; ///< this will be our node type
+	typedef typename Node::Key Key;               ///< key to hash tables
+
+	/**
+	 * Called by YAPF to calculate the cost from the origin to the given node.
+	 *  Aqueducts can skip regions, so the cost is the distance between the regions.
+	 */
+	inline bool PfCalcCost(Node &n, const TrackFollower *tf)
+	{
+		n.m_cost = n.m_parent->m_cost + ManhattanDistance(n.m_key, n.m_parent->m_key);
+		return true;
+	}
+};
+
+/** Dummy track follower; the water regions know their neighbours themselves. */
+struct DummyFollower {
+};
+
+/**
+ * Config struct of YAPF for water regions.
+ *  Defines all 6 base YAPF modules as classes providing services for CYapfBaseT.
+ */
+template <class Tpf_, class Tnode_list>
+struct CYapfRegion_TypesT
+{
+	/** Types - shortcut for this struct type */
+	typedef CYapfRegion_TypesT<Tpf_, Tnode_list> Types;
+
+	/** Tpf - pathfinder type */
+	typedef Tpf_                               Tpf;
+	/** track follower helper class */
+	typedef DummyFollower                      TrackFollower;
+	/** node list type */
+	typedef Tnode_list                         NodeList;
+	typedef Ship                               VehicleType;
+	/** pathfinder components (modules) */
+	typedef CYapfBaseT<Types>                  PfBase;        // base pathfinder class
+	typedef CYapfFollowRegionT<Types>          PfFollow;      // node follower
+	typedef CYapfOriginRegionT<Types>          PfOrigin;      // origin provider
+	typedef CYapfDestinationRegionT<Types>     PfDestination; // destination/distance provider
+	typedef CYapfSegmentCostCacheNoneT<Types>  PfCache;       // segment cost cache provider
+	typedef CYapfCostRegionT<Types>            PfCost;        // cost provider
+};
+
+typedef CNodeList_HashTableT<CYapfRegionNodeT<CYapfRegionPatchNodeKey>, 12, 12> CRegionNodeListWater;
+
+/** YAPF for water regions; the node limit depends on the map size instead of the settings. */
+struct CYapfRegionWater : CYapfT<CYapfRegion_TypesT<CYapfRegionWater, CRegionNodeListWater> >
+{
+	explicit CYapfRegionWater(int max_nodes)
+	{
+		m_max_search_nodes = max_nodes;
+	}
+};
+
+/**
+ * Find a route over the water regions from a tile to the destination of a ship.
+ * @param v The ship.
+ * @param start_tile Tile the route starts at.
+ * @param max_returned_path_length Maximum number of patches to return.
+ * @return The patches along the route, starting with the patch of \a start_tile; empty if there is no route.
+ */
+std::vector<WaterRegionPatchDesc> YapfShipFindWaterRegionPath(const Ship *v, TileIndex start_tile, uint max_returned_path_length)
+{
+	return CYapfRegionWater::FindWaterRegionPath(v, start_tile, max_returned_path_length);
+}
@@ -15,6 +15,19 @@
 
 #include "safeguards.h"
 
+uint64 _reservation_generation = 0; ///< Incremented whenever a reservation or the track layout changes.
+
+/** The last reservation end found by FollowTrainReservation. */
+static struct {
+	uint64 generation;    ///< #_reservation_generation when the end was found.
+	Owner owner;          ///< Owner of the train.
+	RailTypes railtypes;  ///< Rail types the train can use.
+	bool forbid_90deg;    ///< Whether 90 degree turns were forbidden.
+	TileIndex tile;       ///< Tile the reservation was followed from.
+	Trackdir trackdir;    ///< Trackdir the reservation was followed from.
+	PBSTileInfo res;      ///< The end of the reservation.
+} _last_reservation_end = { UINT64_MAX, INVALID_OWNER, RAILTYPES_NONE, false, INVALID_TILE, INVALID_TRACKDIR, PBSTileInfo() };
+
 /**
  * Get the reserved trackbits for any tile, regardless of type.
  * @param t the tile
@@ -295,9 +308,20 @@ PBSTileInfo FollowTrainReservation(const Train *v, Vehicle **train_on_res)
 
 	if (IsRailDepotTile(tile) && !GetDepotReservationTrackBits(tile)) return PBSTileInfo(tile, trackdir, false);
 
+	/* Trains often look for the end of their reservation several times in a row
+	 * while deciding where to go; the result only changes with the reservations or the track layout. */
+	RailTypes rts = GetRailTypeInfo(v->railtype)->compatible_railtypes;
+	bool forbid_90deg = _settings_game.pf.forbid_90_deg;
+
 	FindTrainOnTrackInfo ftoti;
-	ftoti.res = FollowReservation(v->owner, GetRailTypeInfo(v->railtype)->compatible_railtypes, tile, trackdir);
-	ftoti.res.okay = IsSafeWaitingPosition(v, ftoti.res.tile, ftoti.res.trackdir, true, _settings_game.pf.forbid_90_deg);
+	if (_last_reservation_end.generation == _reservation_generation && _last_reservation_end.tile == tile && _last_reservation_end.trackdir == trackdir &&
+			_last_reservation_end.owner == v->owner && _last_reservation_end.railtypes == rts && _last_reservation_end.forbid_90deg == forbid_90deg) {
+		ftoti.res = _last_reservation_end.res;
+	} else {
+		ftoti.res = FollowReservation(v->owner, rts, tile, trackdir);
+		ftoti.res.okay = IsSafeWaitingPosition(v, ftoti.res.tile, ftoti.res.trackdir, true, forbid_90deg);
+		_last_reservation_end = { _reservation_generation, v->owner, rts, forbid_90deg, tile, trackdir, ftoti.res };
+	}
 	if (train_on_res != nullptr) {
 		FindVehicleOnPos(ftoti.res.tile, &ftoti, FindTrainOnTrackEnum);
 		if (ftoti.best != nullptr) *train_on_res = ftoti.best->First();
@@ -15,6 +15,17 @@
 #include "track_type.h"
 #include "vehicle_type.h"
 
+extern uint64 _reservation_generation;
+
+/**
+ * Forget the cached ends of reserved paths.
+ * Call this whenever a reservation, or the track layout, changes.
+ */
+static inline void InvalidateReservationCache()
+{
+	_reservation_generation++;
+}
+
 TrackBits GetReservedTrackbits(TileIndex t);
 
 void SetRailStationPlatformReservation(TileIndex start, DiagDirection dir, bool b);
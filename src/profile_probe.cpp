@@ -0,0 +1,191 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file profile_probe.cpp Fine grained profiling of game logic. */
+
+#include "stdafx.h"
+#include "profile_probe.h"
+#include "console_func.h"
+#include "console_type.h"
+#include "fileio_func.h"
+#include "fios.h"
+#include "string_func.h"
+#include "walltime_func.h"
+#include "3rdparty/fmt/format.h"
+
+#include <chrono>
+#include <vector>
+
+#include "safeguards.h"
+
+bool _profiling = false; ///< Whether probes are collecting data.
+
+/** First probe in the list of registered probes. */
+static ProfileProbe *_first_probe = nullptr;
+
+/** A node in the call tree of probed blocks. */
+struct ProfileNode {
+	const ProfileProbe *probe; ///< Probe of the block, nullptr for the root.
+	uint32 parent;             ///< Node of the enclosing block.
+	uint32 first_child;        ///< First node of a block entered from this one, or 0.
+	uint32 next_sibling;       ///< Next node with the same parent, or 0.
+	uint64 calls;              ///< Number of times the block was run.
+	uint64 time;               ///< Total time spent in the block, including nested blocks, in nanoseconds.
+};
+
+/** The call tree; the first node is the root. */
+static std::vector<ProfileNode> _profile_nodes;
+/** Node of the innermost block currently running. */
+static uint32 _profile_current_node = 0;
+
+/**
+ * Get the current time for profiling.
+ * @return Time in nanoseconds, from an arbitrary starting point.
+ */
+static uint64 GetProfileTimer()
+{
+	using namespace std::chrono;
+	return (uint64)duration_cast<nanoseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+/**
+ * Register a probe. Only call this for probes with a static lifetime.
+ * @param name Name of the probe.
+ */
+ProfileProbe::ProfileProbe(const char *name) : name(name), next(_first_probe), count(0)
+{
+	_first_probe = this;
+}
+
+/**
+ * Enter the node for a probe within the current node.
+ * @param probe Probe of the block being entered.
+ */
+void ProfileScope::Begin(const ProfileProbe &probe)
+{
+	uint32 *link = &_profile_nodes[_profile_current_node].first_child;
+	while (*link != 0 && _profile_nodes[*link].probe != &probe) link = &_profile_nodes[*link].next_sibling;
+
+	this->node = *link;
+	if (this->node == 0) {
+		this->node = *link = (uint32)_profile_nodes.size();
+		_profile_nodes.push_back({ &probe, _profile_current_node, 0, 0, 0, 0 });
+	}
+
+	_profile_current_node = this->node;
+	this->start_time = GetProfileTimer();
+}
+
+/** Leave the node again, and account for the time spent. */
+void ProfileScope::End()
+{
+	ProfileNode &node = _profile_nodes[this->node];
+	node.time += GetProfileTimer() - this->start_time;
+	node.calls++;
+	_profile_current_node = node.parent;
+}
+
+/** Throw away all data collected so far, and start collecting. */
+void StartProfiling()
+{
+	_profile_nodes.clear();
+	_profile_nodes.push_back({ nullptr, 0, 0, 0, 0, 0 });
+	_profile_current_node = 0;
+	for (ProfileProbe *probe = _first_probe; probe != nullptr; probe = probe->next) probe->count = 0;
+
+	_profiling = true;
+}
+
+/** Stop collecting data; the data collected so far is kept. */
+void StopProfiling()
+{
+	_profiling = false;
+}
+
+/**
+ * Get the time spent in a node itself, not counting nested blocks.
+ * @param index Node to get the time of.
+ * @return Time in nanoseconds.
+ */
+static uint64 GetSelfTime(uint32 index)
+{
+	uint64 time = _profile_nodes[index].time;
+	for (uint32 child = _profile_nodes[index].first_child; child != 0; child = _profile_nodes[child].next_sibling) {
+		time -= std::min(time, _profile_nodes[child].time);
+	}
+	return time;
+}
+
+/**
+ * Print a node and all nodes below it to the console.
+ * @param index Node to print.
+ * @param depth Nesting depth of the node.
+ */
+static void PrintProfileNode(uint32 index, int depth)
+{
+	const ProfileNode &node = _profile_nodes[index];
+	IConsolePrint(CC_DEFAULT, "{:{}}{}: {} calls, {:.3f} ms total, {:.3f} ms self", "", depth * 2, node.probe->name, node.calls, node.time / 1e6, GetSelfTime(index) / 1e6);
+
+	for (uint32 child = node.first_child; child != 0; child = _profile_nodes[child].next_sibling) {
+		PrintProfileNode(child, depth + 1);
+	}
+}
+
+/** Print the call tree and counters collected so far to the console. */
+void PrintProfile()
+{
+	if (_profile_nodes.empty() || _profile_nodes[0].first_child == 0) {
+		IConsolePrint(CC_INFO, "No profiling data collected.");
+	} else {
+		for (uint32 child = _profile_nodes[0].first_child; child != 0; child = _profile_nodes[child].next_sibling) {
+			PrintProfileNode(child, 0);
+		}
+	}
+
+	for (const ProfileProbe *probe = _first_probe; probe != nullptr; probe = probe->next) {
+		if (probe->count != 0) IConsolePrint(CC_DEFAULT, "{}: counted {}", probe->name, probe->count);
+	}
+}
+
+/**
+ * Get a default name for the file to write the profile to.
+ * @return File name in the screenshot directory.
+ */
+std::string GetProfileFilename()
+{
+	char timestamp[16] = {};
+	LocalTime::Format(timestamp, lastof(timestamp), "%Y%m%d-%H%M");
+
+	char filepath[MAX_PATH] = {};
+	seprintf(filepath, lastof(filepath), "%sprofile-%s.folded", FiosGetScreenshotDir(), timestamp);
+
+	return std::string(filepath);
+}
+
+/**
+ * Write the call tree collected so far in the "folded stacks" format used by flame graph tools.
+ * Every line holds the names of a node and its ancestors separated by semicolons,
+ * followed by the time spent in the node itself in nanoseconds.
+ * @param filename File to write to.
+ * @return True if the file was written.
+ */
+bool WriteProfile(const std::string &filename)
+{
+	FILE *f = FioFOpenFile(filename, "wt", Subdirectory::NO_DIRECTORY);
+	if (f == nullptr) return false;
+	FileCloser fcloser(f);
+
+	for (uint32 index = 1; index < _profile_nodes.size(); index++) {
+		std::string stack = _profile_nodes[index].probe->name;
+		for (uint32 parent = _profile_nodes[index].parent; parent != 0; parent = _profile_nodes[parent].parent) {
+			stack = std::string(_profile_nodes[parent].probe->name) + ";" + stack;
+		}
+		fputs(fmt::format("{} {}\n", stack, GetSelfTime(index)).c_str(), f);
+	}
+
+	return true;
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file profile_probe.h
+ * Fine grained profiling of game logic.
+ *
+ * @par Adding a probe
+ * Define a #ProfileProbe with a static lifetime next to the code to measure, and
+ * construct a #ProfileScope with it at the beginning of the block to measure.
+ * Probes register themselves on startup, there is no list to update.
+ * Scopes nest, so the measurements form a call tree that follows the actual
+ * nesting of the probed blocks at run time.
+ *
+ * @par
+ * While profiling is not running, a scope only tests a global flag. Probes
+ * are therefore fine to leave in place in hot code. Only use probes on the
+ * main thread.
+ *
+ * @see the \c profile console command for collecting and writing the data.
+ */
+
+#ifndef PROFILE_PROBE_H
+#define PROFILE_PROBE_H
+
+#include <string>
+
+extern bool _profiling;
+
+/** A measured block of code, or a counted event. */
+struct ProfileProbe {
+	const char *name;   ///< Name of the probe, shown in the output.
+	ProfileProbe *next; ///< Next registered probe.
+	uint64 count;       ///< Amount counted with Count() since profiling was started.
+
+	ProfileProbe(const char *name);
+
+	/**
+	 * Count some amount of something related to the probe, e.g. the cargo handled.
+	 * @param amount Amount to add.
+	 */
+	inline void Count(uint64 amount)
+	{
+		if (_profiling) this->count += amount;
+	}
+};
+
+/**
+ * RAII class measuring a block of code for a probe.
+ * Construct it at the beginning of the block; the time is taken when it goes out of scope.
+ */
+class ProfileScope {
+	uint32 node;       ///< Node of the call tree being measured, or 0 if not profiling.
+	uint64 start_time; ///< Time the block was entered.
+
+	void Begin(const ProfileProbe &probe);
+	void End();
+
+public:
+	/**
+	 * Begin measuring a block of code.
+	 * @param probe Probe to attribute the time to.
+	 */
+	inline ProfileScope(const ProfileProbe &probe) : node(0)
+	{
+		if (_profiling) this->Begin(probe);
+	}
+
+	/** Finish measuring the block of code. */
+	inline ~ProfileScope()
+	{
+		if (this->node != 0) this->End();
+	}
+};
+
+void StartProfiling();
+void StopProfiling();
+void PrintProfile();
+bool WriteProfile(const std::string &filename);
+std::string GetProfileFilename();
+
+#endif /* PROFILE_PROBE_H */
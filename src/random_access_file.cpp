@@ -23,12 +23,15 @@
  */
 RandomAccessFile::RandomAccessFile(const std::string &filename, Subdirectory subdir) : filename(filename)
 {
-	this->file_handle = FioFOpenFile(filename, "rb", subdir);
+	size_t file_size;
+	this->file_handle = FioFOpenFile(filename, "rb", subdir, &file_size);
 	if (this->file_handle == nullptr) usererror("Cannot open file '%s'", filename.c_str());
 
 	/* When files are in a tar-file, the begin of the file might not be at 0. */
 	long pos = ftell(this->file_handle);
 	if (pos < 0) usererror("Cannot read file '%s'", filename.c_str());
+	this->start_pos = (size_t)pos;
+	this->end_pos = this->start_pos + file_size;
 
 	/* Store the filename without path and extension */
 	auto t = filename.rfind(PATHSEPCHAR);
@@ -66,6 +69,25 @@ const std::string &RandomAccessFile::GetSimplifiedFilename() const
 	return this->simplified_filename;
 }
 
+/**
+ * Get the position in the file at which the file's data begins.
+ * For files within a tar-file this is not 0.
+ * @return Position of the begin of the file.
+ */
+size_t RandomAccessFile::GetStartPos() const
+{
+	return this->start_pos;
+}
+
+/**
+ * Get the position in the file just after the file's data.
+ * @return Position of the end of the file.
+ */
+size_t RandomAccessFile::GetEndPos() const
+{
+	return this->end_pos;
+}
+
 /**
  * Get position in the file.
  * @return Position in the file.
@@ -28,6 +28,8 @@ class RandomAccessFile {
 	std::string simplified_filename; ///< Simplified lowecase name of the file; only the name, no path or extension.
 
 	FILE *file_handle;               ///< File handle of the open file.
+	size_t start_pos;                ///< Position in the file handle of the begin of the file.
+	size_t end_pos;                  ///< Position in the file handle of the end of the file.
 	size_t pos;                      ///< Position in the file of the end of the read buffer.
 
 	byte *buffer;                    ///< Current position within the local buffer.
@@ -44,6 +46,9 @@ public:
 	const std::string &GetFilename() const;
 	const std::string &GetSimplifiedFilename() const;
 
+	size_t GetStartPos() const;
+	size_t GetEndPos() const;
+
 	size_t GetPos() const;
 	void SeekTo(size_t pos, int mode);
 
@@ -15,6 +15,7 @@
 #include "rail_type.h"
 #include "road_func.h"
 #include "tile_map.h"
+#include "pbs.h"
 
 
 /** The different types of road tiles. */
@@ -157,6 +158,7 @@ static inline void SetRoadBits(TileIndex t, RoadBits r, RoadTramType rtt)
 	} else {
 		SB(_m[t].m5, 0, 4, r);
 	}
+	InvalidateRoadRegion(t);
 }
 
 static inline RoadType GetRoadTypeRoad(TileIndex t)
@@ -314,6 +316,7 @@ static inline void SetDisallowedRoadDirections(TileIndex t, DisallowedRoadDirect
 	assert(IsNormalRoad(t));
 	assert(drd < DRD_END);
 	SB(_m[t].m5, 4, 2, drd);
+	InvalidateRoadRegion(t);
 }
 
 /**
@@ -394,6 +397,7 @@ static inline void SetCrossingReservation(TileIndex t, bool b)
 {
 	assert(IsLevelCrossingTile(t));
 	SB(_m[t].m5, 4, 1, b ? 1 : 0);
+	InvalidateReservationCache();
 }
 
 /**
@@ -502,6 +506,8 @@ static inline Roadside GetRoadside(TileIndex tile)
  */
 static inline void SetRoadside(TileIndex tile, Roadside s)
 {
+	/* Road vehicles can't drive over road works. */
+	if ((GetRoadside(tile) >= ROADSIDE_GRASS_ROAD_WORKS) != (s >= ROADSIDE_GRASS_ROAD_WORKS)) InvalidateRoadRegion(tile);
 	SB(_me[tile].m6, 3, 3, s);
 }
 
@@ -581,6 +587,7 @@ static inline void SetRoadTypeRoad(TileIndex t, RoadType rt)
 	assert(MayHaveRoad(t));
 	assert(rt == INVALID_ROADTYPE || RoadTypeIsRoad(rt));
 	SB(_m[t].m4, 0, 6, rt);
+	InvalidateRoadRegion(t);
 }
 
 /**
@@ -593,6 +600,7 @@ static inline void SetRoadTypeTram(TileIndex t, RoadType rt)
 	assert(MayHaveRoad(t));
 	assert(rt == INVALID_ROADTYPE || RoadTypeIsTram(rt));
 	SB(_me[t].m8, 6, 6, rt);
+	InvalidateRoadRegion(t);
 }
 
 /**
@@ -795,6 +795,9 @@ bool AfterLoadGame()
 		}
 	}
 
+	/* The vehicle tile hash was set up before the map size was known. */
+	ResetVehicleHash();
+
 	/* Update all vehicles */
 	AfterLoadVehicles(true);
 
@@ -2619,8 +2622,7 @@ bool AfterLoadGame()
 					ClrBit(t->flags, 2);
 
 					/* Clear both bits first. */
-					ClrBit(t->gv_flags, GVF_GOINGUP_BIT);
-					ClrBit(t->gv_flags, GVF_GOINGDOWN_BIT);
+					t->SetSlopeFlags(0);
 
 					/* Crashed vehicles can't be going up/down. */
 					if (t->vehstatus & VS_CRASHED) break;
@@ -2628,13 +2630,12 @@ bool AfterLoadGame()
 					/* Only X/Y tracks can be sloped. */
 					if (t->track != TRACK_BIT_X && t->track != TRACK_BIT_Y) break;
 
-					t->gv_flags |= FixVehicleInclination(t, t->direction);
+					t->SetSlopeFlags(FixVehicleInclination(t, t->direction));
 					break;
 				}
 				case VEH_ROAD: {
 					RoadVehicle *rv = RoadVehicle::From(v);
-					ClrBit(rv->gv_flags, GVF_GOINGUP_BIT);
-					ClrBit(rv->gv_flags, GVF_GOINGDOWN_BIT);
+					rv->SetSlopeFlags(0);
 
 					/* Crashed vehicles can't be going up/down. */
 					if (rv->vehstatus & VS_CRASHED) break;
@@ -2658,7 +2659,7 @@ bool AfterLoadGame()
 						dir = INVALID_DIR;
 					}
 
-					rv->gv_flags |= FixVehicleInclination(rv, dir);
+					rv->SetSlopeFlags(FixVehicleInclination(rv, dir));
 					break;
 				}
 				case VEH_SHIP:
@@ -3147,9 +3148,19 @@ bool AfterLoadGame()
 		}
 	}
 
+	/* The map may have a different size than when the catchment coverage index was set up. */
+	_station_coverage.Reset();
+
 	/* Compute station catchment areas. This is needed here in case UpdateStationAcceptance is called below. */
 	Station::RecomputeCatchmentForAll();
 
+	/* The schedule of station rating updates and the set of loading stations aren't saved. */
+	RebuildStationSchedules();
+
+	/* Neither are the schedules of town growth and industry production. */
+	RebuildTownGrowthSchedule();
+	RebuildIndustrySchedule();
+
 	/* Station acceptance is some kind of cache */
 	if (IsSavegameVersionBefore(SLV_127)) {
 		for (Station *st : Station::Iterate()) UpdateStationAcceptance(st, false);
@@ -3192,6 +3203,9 @@ void ReloadNewGRFData()
 	GroupStatistics::UpdateAfterLoad();
 	/* update station graphics */
 	AfterLoadStations();
+	/* Blocked station tiles might have changed */
+	InvalidateSignalSegmentCache();
+	InvalidateReservationCache();
 	/* Update company statistics. */
 	AfterLoadCompanyStats();
 	/* Check and update house and town values */
@@ -58,7 +58,10 @@
 	if (IsSavegameVersionBefore(SLV_120)) {
 		/* CargoPacket's source should be either INVALID_STATION or a valid station */
 		for (CargoPacket *cp : CargoPacket::Iterate()) {
-			if (!Station::IsValidID(cp->source)) cp->source = INVALID_STATION;
+			if (!Station::IsValidID(cp->source)) {
+				cp->RemoveFromSourceIndex();
+				cp->source = INVALID_STATION;
+			}
 		}
 	}
 
@@ -106,6 +109,9 @@ SaveLoadTable GetCargoPacketDesc()
  */
 static void Save_CAPA()
 {
+	/* Vehicles age their cargo lazily; make sure the packets are up to date. */
+	for (Vehicle *v : Vehicle::Iterate()) v->cargo.UpdateAge();
+
 	for (CargoPacket *cp : CargoPacket::Iterate()) {
 		SlSetArrayIndex(cp->index);
 		SlObject(cp, GetCargoPacketDesc());
@@ -122,6 +128,7 @@ static void Load_CAPA()
 	while ((index = SlIterateArray()) != -1) {
 		CargoPacket *cp = new (index) CargoPacket();
 		SlObject(cp, GetCargoPacketDesc());
+		cp->AddToSourceIndex();
 	}
 }
 
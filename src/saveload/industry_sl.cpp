@@ -79,6 +79,8 @@ static const SaveLoad _industry_desc[] = {
 
 static void Save_INDY()
 {
+	SyncIndustryCounters();
+
 	/* Write the industries */
 	for (Industry *ind : Industry::Iterate()) {
 		SlSetArrayIndex(ind->index);
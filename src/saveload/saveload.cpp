@@ -1356,6 +1356,33 @@ static void SlRefList(void *list, VarType conv)
 	SlStorageHelper<std::list, void *>::SlSaveLoad(list, conv, SL_REF);
 }
 
+/**
+ * Return the size in bytes of a deque of references.
+ * @param deque The std::deque to find the size of.
+ * @param conv VarType type of variable that is used for calculating the size.
+ */
+static inline size_t SlCalcRefDequeLen(const void *deque, VarType conv)
+{
+	return SlStorageHelper<std::deque, void *>::SlCalcLen(deque, conv, SL_REF);
+}
+
+/**
+ * Save/Load a deque of references.
+ * @param deque The deque being manipulated.
+ * @param conv VarType type of variable that is used for calculating the size.
+ */
+static void SlRefDeque(void *deque, VarType conv)
+{
+	/* Automatically calculate the length? */
+	if (_sl.need_length != NL_NONE) {
+		SlSetLength(SlCalcRefDequeLen(deque, conv));
+		/* Determine length only? */
+		if (_sl.need_length == NL_CALCLENGTH) return;
+	}
+
+	SlStorageHelper<std::deque, void *>::SlSaveLoad(deque, conv, SL_REF);
+}
+
 /**
  * Return the size in bytes of a std::deque.
  * @param deque The std::deque to find the size of
@@ -1433,6 +1460,7 @@ size_t SlCalcObjMemberLength(const void *object, const SaveLoad &sld)
 		case SL_REFLIST:
 		case SL_DEQUE:
 		case SL_STDSTR:
+		case SL_REFDEQUE:
 			/* CONDITIONAL saveload types depend on the savegame version */
 			if (!SlIsObjectValidInSavegame(sld)) break;
 
@@ -1443,6 +1471,7 @@ size_t SlCalcObjMemberLength(const void *object, const SaveLoad &sld)
 				case SL_STR: return SlCalcStringLen(GetVariableAddress(object, sld), sld.length, sld.conv);
 				case SL_REFLIST: return SlCalcRefListLen(GetVariableAddress(object, sld), sld.conv);
 				case SL_DEQUE: return SlCalcDequeLen(GetVariableAddress(object, sld), sld.conv);
+				case SL_REFDEQUE: return SlCalcRefDequeLen(GetVariableAddress(object, sld), sld.conv);
 				case SL_STDSTR: return SlCalcStdStringLen(GetVariableAddress(object, sld));
 				default: NOT_REACHED();
 			}
@@ -1518,6 +1547,7 @@ static bool SlObjectMember(void *object, const SaveLoad &sld)
 		case SL_REFLIST:
 		case SL_DEQUE:
 		case SL_STDSTR:
+		case SL_REFDEQUE:
 			/* CONDITIONAL saveload types depend on the savegame version */
 			if (!SlIsObjectValidInSavegame(sld)) return false;
 
@@ -1528,6 +1558,7 @@ static bool SlObjectMember(void *object, const SaveLoad &sld)
 				case SL_STR: SlString(ptr, sld.length, sld.conv); break;
 				case SL_REFLIST: SlRefList(ptr, conv); break;
 				case SL_DEQUE: SlDeque(ptr, conv); break;
+				case SL_REFDEQUE: SlRefDeque(ptr, conv); break;
 				case SL_STDSTR: SlStdString(ptr, sld.conv); break;
 				default: NOT_REACHED();
 			}
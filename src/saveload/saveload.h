@@ -501,6 +501,7 @@ enum SaveLoadType : byte {
 	SL_REFLIST     =  4, ///< Save/load a list of #SL_REF elements.
 	SL_DEQUE       =  5, ///< Save/load a deque of #SL_VAR elements.
 	SL_STDSTR      =  6, ///< Save/load a \c std::string.
+	SL_REFDEQUE    =  7, ///< Save/load a deque of #SL_REF elements.
 	/* non-normal save-load types */
 	SL_WRITEBYTE   =  8,
 	SL_VEH_INCLUDE =  9,
@@ -609,6 +610,17 @@ using SaveLoadTable = span<const SaveLoad>;
  */
 #define SLE_CONDDEQUE(base, variable, type, from, to) SLE_GENERAL(SL_DEQUE, base, variable, type, 0, from, to, 0)
 
+/**
+ * Storage of a deque of #SL_REF elements in some savegame versions.
+ * In the savegame it is stored the same way as a list of #SL_REF elements.
+ * @param base     Name of the class or struct containing the deque.
+ * @param variable Name of the variable in the class or struct referenced by \a base.
+ * @param type     Storage of the data in memory and in the savegame.
+ * @param from     First savegame version that has the deque.
+ * @param to       Last savegame version that has the deque.
+ */
+#define SLE_CONDREFDEQUE(base, variable, type, from, to) SLE_GENERAL(SL_REFDEQUE, base, variable, type, 0, from, to, 0)
+
 /**
  * Storage of a variable in every version of a savegame.
  * @param base     Name of the class or struct containing the variable.
@@ -659,6 +671,14 @@ using SaveLoadTable = span<const SaveLoad>;
  */
 #define SLE_REFLIST(base, variable, type) SLE_CONDREFLIST(base, variable, type, SL_MIN_VERSION, SL_MAX_VERSION)
 
+/**
+ * Storage of a deque of #SL_REF elements in every savegame version.
+ * @param base     Name of the class or struct containing the deque.
+ * @param variable Name of the variable in the class or struct referenced by \a base.
+ * @param type     Storage of the data in memory and in the savegame.
+ */
+#define SLE_REFDEQUE(base, variable, type) SLE_CONDREFDEQUE(base, variable, type, SL_MIN_VERSION, SL_MAX_VERSION)
+
 /**
  * Empty space in every savegame version.
  * @param length Length of the empty space.
@@ -747,6 +767,15 @@ using SaveLoadTable = span<const SaveLoad>;
  */
 #define SLEG_CONDREFLIST(variable, type, from, to) SLEG_GENERAL(SL_REFLIST, variable, type, 0, from, to, 0)
 
+/**
+ * Storage of a global reference deque in some savegame versions.
+ * @param variable Name of the global variable.
+ * @param type     Storage of the data in memory and in the savegame.
+ * @param from     First savegame version that has the deque.
+ * @param to       Last savegame version that has the deque.
+ */
+#define SLEG_CONDREFDEQUE(variable, type, from, to) SLEG_GENERAL(SL_REFDEQUE, variable, type, 0, from, to, 0)
+
 /**
  * Storage of a global variable in every savegame version.
  * @param variable Name of the global variable.
@@ -225,7 +225,7 @@ static const SaveLoad _station_speclist_desc[] = {
 	SLE_CONDVAR(StationSpecList, localidx, SLE_UINT8,  SLV_27, SL_MAX_VERSION),
 };
 
-std::list<CargoPacket *> _packets;
+std::deque<CargoPacket *> _packets;
 uint32 _num_dests;
 
 struct FlowSaveLoad {
@@ -265,7 +265,7 @@ SaveLoadTable GetGoodsDesc()
 		SLEG_CONDVAR(            _cargo_feeder_share,  SLE_FILE_U32 | SLE_VAR_I64, SLV_14, SLV_65),
 		SLEG_CONDVAR(            _cargo_feeder_share,  SLE_INT64,                  SLV_65, SLV_68),
 		 SLE_CONDVAR(GoodsEntry, amount_fract,         SLE_UINT8,                 SLV_150, SL_MAX_VERSION),
-		SLEG_CONDREFLIST(        _packets,             REF_CARGO_PACKET,           SLV_68, SLV_183),
+		SLEG_CONDREFDEQUE(       _packets,             REF_CARGO_PACKET,           SLV_68, SLV_183),
 		SLEG_CONDVAR(            _num_dests,           SLE_UINT32,                SLV_183, SL_MAX_VERSION),
 		 SLE_CONDVAR(GoodsEntry, cargo.reserved_count, SLE_UINT,                  SLV_181, SL_MAX_VERSION),
 		 SLE_CONDVAR(GoodsEntry, link_graph,           SLE_UINT16,                SLV_183, SL_MAX_VERSION),
@@ -277,11 +277,11 @@ SaveLoadTable GetGoodsDesc()
 	return goods_desc;
 }
 
-typedef std::pair<const StationID, std::list<CargoPacket *> > StationCargoPair;
+typedef std::pair<const StationID, StationCargoPacketMap::List> StationCargoPair;
 
 static const SaveLoad _cargo_list_desc[] = {
 	SLE_VAR(StationCargoPair, first,  SLE_UINT16),
-	SLE_REFLIST(StationCargoPair, second, REF_CARGO_PACKET),
+	SLE_REFDEQUE(StationCargoPair, second, REF_CARGO_PACKET),
 };
 
 /**
@@ -294,7 +294,7 @@ static void SwapPackets(GoodsEntry *ge)
 	StationCargoPacketMap &ge_packets = const_cast<StationCargoPacketMap &>(*ge->cargo.Packets());
 
 	if (_packets.empty()) {
-		std::map<StationID, std::list<CargoPacket *> >::iterator it(ge_packets.find(INVALID_STATION));
+		StationCargoPacketMap::MapIterator it(ge_packets.find(INVALID_STATION));
 		if (it == ge_packets.end()) {
 			return;
 		} else {
@@ -492,6 +492,8 @@ static void RealSave_STNN(BaseStation *bst)
 
 static void Save_STNN()
 {
+	SyncStationDeleteCounters();
+
 	/* Write the stations */
 	for (BaseStation *st : BaseStation::Iterate()) {
 		SlSetArrayIndex(st->index);
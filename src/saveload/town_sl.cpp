@@ -246,6 +246,8 @@ static void RealSave_Town(Town *t)
 
 static void Save_TOWN()
 {
+	SyncTownGrowCounters();
+
 	for (Town *t : Town::Iterate()) {
 		SlSetArrayIndex(t->index);
 		SlAutolength((AutolengthProc*)RealSave_Town, t);
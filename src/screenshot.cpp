@@ -26,6 +26,11 @@
 #include "tile_map.h"
 #include "landscape.h"
 #include "video/video_driver.hpp"
+#include "thread.h"
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
 
 #include "table/strings.h"
 
@@ -227,6 +232,79 @@ static bool MakeBMPImage(const char *name, ScreenshotCallback *callb, void *user
 #if defined(WITH_PNG)
 #include <png.h>
 
+/**
+ * Queue handing buffers of rendered lines from the thread rendering them to
+ * the thread writing them, and the written buffers back again.
+ */
+class ScreenshotLineQueue {
+	std::mutex lock;                            ///< Lock for all members.
+	std::condition_variable changed;            ///< Signalled whenever a buffer is handed over.
+	std::deque<std::pair<uint8 *, uint>> lines; ///< Buffers with rendered lines, and their number of lines.
+	std::vector<uint8 *> free;                  ///< Buffers that can be rendered into.
+	bool finished = false;                      ///< Whether no more lines will be rendered.
+
+public:
+	/**
+	 * Get a buffer to render into, waiting for one to be written if needed.
+	 * @return The buffer.
+	 */
+	uint8 *AcquireBuffer()
+	{
+		std::unique_lock<std::mutex> lock(this->lock);
+		this->changed.wait(lock, [this] { return !this->free.empty(); });
+		uint8 *buf = this->free.back();
+		this->free.pop_back();
+		return buf;
+	}
+
+	/**
+	 * Hand a buffer back after its lines were written, or add a new buffer.
+	 * @param buf The buffer.
+	 */
+	void ReleaseBuffer(uint8 *buf)
+	{
+		std::lock_guard<std::mutex> lock(this->lock);
+		this->free.push_back(buf);
+		this->changed.notify_all();
+	}
+
+	/**
+	 * Queue rendered lines for writing.
+	 * @param buf The buffer with the lines.
+	 * @param n The number of lines.
+	 */
+	void PushLines(uint8 *buf, uint n)
+	{
+		std::lock_guard<std::mutex> lock(this->lock);
+		this->lines.emplace_back(buf, n);
+		this->changed.notify_all();
+	}
+
+	/**
+	 * Get the next rendered lines, waiting for them to be rendered if needed.
+	 * @param[out] buf The buffer with the lines.
+	 * @param[out] n The number of lines.
+	 * @return False when all lines have been handed out.
+	 */
+	bool PopLines(uint8 *&buf, uint &n)
+	{
+		std::unique_lock<std::mutex> lock(this->lock);
+		this->changed.wait(lock, [this] { return !this->lines.empty() || this->finished; });
+		if (this->lines.empty()) return false;
+		std::tie(buf, n) = this->lines.front();
+		this->lines.pop_front();
+		return true;
+	}
+
+	/** Signal that no more lines will be rendered. */
+	void Finish()
+	{
+		std::lock_guard<std::mutex> lock(this->lock);
+		this->finished = true;
+		this->changed.notify_all();
+	}
+};
+
 #ifdef PNG_TEXT_SUPPORTED
 #include "rev.h"
 #include "newgrf_config.h"
@@ -246,6 +324,33 @@ static void PNGAPI png_my_warning(png_structp png_ptr, png_const_charp message)
 	Debug(misc, 1, "[libpng] warning: {} - {}", message, (const char *)png_get_error_ptr(png_ptr));
 }
 
+/**
+ * Thread writing rendered lines of a PNG image.
+ * @param png_ptr The PNG to write to.
+ * @param queue The queue with the rendered lines.
+ * @param line_size The size of a single line in bytes.
+ * @param[out] failed Set when writing failed.
+ */
+static void PNGWriteLinesThread(png_structp png_ptr, ScreenshotLineQueue *queue, uint line_size, bool *failed)
+{
+	uint8 *buf;
+	uint n;
+
+	if (setjmp(png_jmpbuf(png_ptr))) {
+		/* Writing failed; keep handing back the buffers so the rendering thread does not block. */
+		*failed = true;
+		while (queue->PopLines(buf, n)) queue->ReleaseBuffer(buf);
+		return;
+	}
+
+	while (queue->PopLines(buf, n)) {
+		for (uint i = 0; i != n; i++) {
+			png_write_row(png_ptr, (png_bytep)buf + i * line_size);
+		}
+		queue->ReleaseBuffer(buf);
+	}
+}
+
 /**
  * Generic .PNG file image writer.
  * @param name        Filename, including extension.
@@ -268,6 +373,12 @@ static bool MakePNGImage(const char *name, ScreenshotCallback *callb, void *user
 	png_structp png_ptr;
 	png_infop info_ptr;
 
+	/* Declared before any setjmp, so no destructors are skipped when libpng bails out. */
+	std::unique_ptr<uint8[]> buffers[2];
+	ScreenshotLineQueue queue;
+	std::thread writer;
+	bool write_failed = false;
+
 	/* only implemented for 8bit and 32bit images so far. */
 	if (pixelformat != 8 && pixelformat != 32) return false;
 
@@ -371,28 +482,57 @@ static bool MakePNGImage(const char *name, ScreenshotCallback *callb, void *user
 	/* use by default 64k temp memory */
 	maxlines = Clamp(65536 / w, 16, 128);
 
-	/* now generate the bitmap bits */
-	void *buff = CallocT<uint8>(w * maxlines * bpp); // by default generate 128 lines at a time.
+	/* now generate the bitmap bits; by default generate 128 lines at a time. */
+	for (auto &buff : buffers) {
+		buff.reset(new uint8[(size_t)w * maxlines * bpp]());
+		queue.ReleaseBuffer(buff.get());
+	}
 
-	y = 0;
-	do {
-		/* determine # lines to write */
-		n = std::min(h - y, maxlines);
+	/* Compress large images on another thread, while the next lines are being rendered. */
+	if (h > maxlines * 4 && StartNewThread(&writer, "ottd:screenshot", &PNGWriteLinesThread, png_structp(png_ptr), &queue, w * bpp, &write_failed)) {
+		y = 0;
+		do {
+			/* determine # lines to write */
+			n = std::min(h - y, maxlines);
+
+			/* render the pixels into a buffer, and hand it over for writing */
+			uint8 *buff = queue.AcquireBuffer();
+			callb(userdata, buff, y, w, n);
+			queue.PushLines(buff, n);
+			y += n;
+		} while (y != h);
+
+		queue.Finish();
+		writer.join();
+
+		/* The writer thread changed the error handler of png_ptr. */
+		if (write_failed || setjmp(png_jmpbuf(png_ptr))) {
+			png_destroy_write_struct(&png_ptr, &info_ptr);
+			fclose(f);
+			return false;
+		}
+	} else {
+		uint8 *buff = buffers[0].get();
 
-		/* render the pixels into the buffer */
-		callb(userdata, buff, y, w, n);
-		y += n;
+		y = 0;
+		do {
+			/* determine # lines to write */
+			n = std::min(h - y, maxlines);
 
-		/* write them to png */
-		for (i = 0; i != n; i++) {
-			png_write_row(png_ptr, (png_bytep)buff + i * w * bpp);
-		}
-	} while (y != h);
+			/* render the pixels into the buffer */
+			callb(userdata, buff, y, w, n);
+			y += n;
+
+			/* write them to png */
+			for (i = 0; i != n; i++) {
+				png_write_row(png_ptr, (png_bytep)buff + i * w * bpp);
+			}
+		} while (y != h);
+	}
 
 	png_write_end(png_ptr, info_ptr);
 	png_destroy_write_struct(&png_ptr, &info_ptr);
 
-	free(buff);
 	fclose(f);
 	return true;
 }
@@ -605,16 +745,17 @@ static void CurrentScreenCallback(void *userdata, void *buf, uint y, uint pitch,
 }
 
 /**
- * generate a large piece of the world
- * @param userdata Viewport area to draw
- * @param buf Videobuffer with same bitdepth as current blitter
- * @param y First line to render
- * @param pitch Pitch of the videobuffer
- * @param n Number of lines to render
+ * Draw an area of a viewport into a buffer.
+ * @param vp Viewport to draw.
+ * @param buf Videobuffer with same bitdepth as current blitter.
+ * @param pitch Pitch of the videobuffer.
+ * @param x Left edge of the area in viewport pixels.
+ * @param y Top edge of the area in viewport pixels.
+ * @param width Width of the area.
+ * @param height Height of the area.
  */
-static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
+static void DrawScreenshotArea(const Viewport *vp, void *buf, uint pitch, int x, int y, int width, int height)
 {
-	Viewport *vp = (Viewport *)userdata;
 	DrawPixelInfo dpi, *old_dpi;
 	int wx, left;
 
@@ -624,7 +765,7 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 
 	_screen.dst_ptr = buf;
 	_screen.width = pitch;
-	_screen.height = n;
+	_screen.height = height;
 	_screen.pitch = pitch;
 	_screen_disable_anim = true;
 
@@ -632,24 +773,24 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 	_cur_dpi = &dpi;
 
 	dpi.dst_ptr = buf;
-	dpi.height = n;
-	dpi.width = vp->width;
+	dpi.height = height;
+	dpi.width = width;
 	dpi.pitch = pitch;
 	dpi.zoom = ZOOM_LVL_WORLD_SCREENSHOT;
-	dpi.left = 0;
+	dpi.left = x;
 	dpi.top = y;
 
 	/* Render viewport in blocks of 1600 pixels width */
-	left = 0;
-	while (vp->width - left != 0) {
-		wx = std::min(vp->width - left, 1600);
+	left = x;
+	while (x + width - left != 0) {
+		wx = std::min(x + width - left, 1600);
 		left += wx;
 
 		ViewportDoDraw(vp,
 			ScaleByZoom(left - wx - vp->left, vp->zoom) + vp->virtual_left,
 			ScaleByZoom(y - vp->top, vp->zoom) + vp->virtual_top,
 			ScaleByZoom(left - vp->left, vp->zoom) + vp->virtual_left,
-			ScaleByZoom((y + n) - vp->top, vp->zoom) + vp->virtual_top
+			ScaleByZoom((y + height) - vp->top, vp->zoom) + vp->virtual_top
 		);
 	}
 
@@ -660,6 +801,20 @@ static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, ui
 	_screen_disable_anim = old_disable_anim;
 }
 
+/**
+ * generate a large piece of the world
+ * @param userdata Viewport area to draw
+ * @param buf Videobuffer with same bitdepth as current blitter
+ * @param y First line to render
+ * @param pitch Pitch of the videobuffer
+ * @param n Number of lines to render
+ */
+static void LargeWorldCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
+{
+	Viewport *vp = (Viewport *)userdata;
+	DrawScreenshotArea(vp, buf, pitch, 0, y, vp->width, n);
+}
+
 /**
  * Construct a pathname for a screenshot file.
  * @param default_fn Default filename.
@@ -736,7 +891,8 @@ void SetupScreenshotViewport(ScreenshotType t, Viewport *vp, uint32 width, uint3
 			vp->overlay = w->viewport->overlay;
 			break;
 		}
-		case SC_WORLD: {
+		case SC_WORLD:
+		case SC_WORLD_TILES: {
 			assert(width == 0 && height == 0);
 
 			/* Determine world coordinates of screenshot */
@@ -806,6 +962,122 @@ static bool MakeLargeWorldScreenshot(ScreenshotType t, uint32 width = 0, uint32
 			BlitterFactory::GetCurrentBlitter()->GetScreenDepth(), _cur_palette.palette);
 }
 
+#if defined(WITH_PNG)
+/** Size of the square tiles of a tiled world screenshot. */
+static const uint SCREENSHOT_TILE_SIZE = 256;
+
+/** State of making a tiled world screenshot. */
+struct WorldTilesScreenshot {
+	Viewport vp;           ///< Viewport of the whole world.
+	std::string directory; ///< Directory to write the tiles to.
+	uint max_z;            ///< Zoom level of the tiles at full resolution; at zoom level 0 a single tile covers the whole world.
+	std::vector<uint8> buffer; ///< Buffer to render the tiles at full resolution into.
+};
+
+/**
+ * Callback of the screenshot generator to write a tile of a tiled world screenshot.
+ * @see ScreenshotCallback
+ */
+static void WorldTileCallback(void *userdata, void *buf, uint y, uint pitch, uint n)
+{
+	const Colour *tile = (const Colour *)userdata;
+	MemCpyT((Colour *)buf, tile + y * pitch, pitch * n);
+}
+
+/**
+ * Make a tile of a tiled world screenshot, and all tiles at higher zoom levels covering the same area.
+ * Tiles at full resolution are rendered, the other tiles are made by scaling down the four tiles of the next zoom level.
+ * @param data State of the tiled screenshot.
+ * @param z Zoom level of the tile.
+ * @param x Column of the tile.
+ * @param y Row of the tile.
+ * @param[out] tile The pixels of the tile.
+ * @return False iff writing a tile failed.
+ */
+static bool MakeWorldTile(WorldTilesScreenshot &data, uint z, uint x, uint y, Colour *tile)
+{
+	std::fill(tile, tile + SCREENSHOT_TILE_SIZE * SCREENSHOT_TILE_SIZE, Colour(0));
+
+	/* Skip tiles that are completely outside of the world. */
+	uint64 tile_span = (uint64)SCREENSHOT_TILE_SIZE << (data.max_z - z);
+	if (x * tile_span >= (uint64)data.vp.width || y * tile_span >= (uint64)data.vp.height) return true;
+
+	if (z == data.max_z) {
+		int left = x * SCREENSHOT_TILE_SIZE;
+		int top = y * SCREENSHOT_TILE_SIZE;
+		int width = std::min<int>(SCREENSHOT_TILE_SIZE, data.vp.width - left);
+		int height = std::min<int>(SCREENSHOT_TILE_SIZE, data.vp.height - top);
+
+		std::fill(data.buffer.begin(), data.buffer.end(), 0);
+		DrawScreenshotArea(&data.vp, data.buffer.data(), SCREENSHOT_TILE_SIZE, left, top, width, height);
+
+		if (BlitterFactory::GetCurrentBlitter()->GetScreenDepth() == 8) {
+			for (uint i = 0; i < SCREENSHOT_TILE_SIZE * SCREENSHOT_TILE_SIZE; i++) tile[i] = _cur_palette.palette[data.buffer[i]];
+		} else {
+			MemCpyT(tile, (const Colour *)data.buffer.data(), SCREENSHOT_TILE_SIZE * SCREENSHOT_TILE_SIZE);
+		}
+	} else {
+		std::vector<Colour> child(SCREENSHOT_TILE_SIZE * SCREENSHOT_TILE_SIZE);
+		const uint half = SCREENSHOT_TILE_SIZE / 2;
+
+		for (uint dy = 0; dy < 2; dy++) {
+			for (uint dx = 0; dx < 2; dx++) {
+				if (!MakeWorldTile(data, z + 1, x * 2 + dx, y * 2 + dy, child.data())) return false;
+
+				/* Average each block of 2x2 pixels into one pixel of the matching quarter of this tile. */
+				for (uint py = 0; py < half; py++) {
+					Colour *dst = tile + (dy * half + py) * SCREENSHOT_TILE_SIZE + dx * half;
+					const Colour *src = child.data() + py * 2 * SCREENSHOT_TILE_SIZE;
+					for (uint px = 0; px < half; px++, src += 2) {
+						const Colour *below = src + SCREENSHOT_TILE_SIZE;
+						dst[px] = Colour(
+								(src[0].r + src[1].r + below[0].r + below[1].r + 2) / 4,
+								(src[0].g + src[1].g + below[0].g + below[1].g + 2) / 4,
+								(src[0].b + src[1].b + below[0].b + below[1].b + 2) / 4);
+					}
+				}
+			}
+		}
+	}
+
+	std::string dir = data.directory + std::to_string(z) + PATHSEP + std::to_string(x) + PATHSEP;
+	FioCreateDirectory(data.directory + std::to_string(z) + PATHSEP);
+	FioCreateDirectory(dir);
+	std::string filename = dir + std::to_string(y) + ".png";
+	return MakePNGImage(filename.c_str(), WorldTileCallback, tile, SCREENSHOT_TILE_SIZE, SCREENSHOT_TILE_SIZE, 32, _cur_palette.palette);
+}
+#endif /* WITH_PNG */
+
+/**
+ * Make a screenshot of the whole world as a pyramid of tiles for zoomable maps.
+ * The tiles are written as PNGs to "<zoom level>/<column>/<row>.png" in a new directory.
+ * @return true on success
+ */
+static bool MakeWorldTilesScreenshot()
+{
+#if defined(WITH_PNG)
+	int depth = BlitterFactory::GetCurrentBlitter()->GetScreenDepth();
+	if (depth != 8 && depth != 32) return false;
+
+	WorldTilesScreenshot data;
+	SetupScreenshotViewport(SC_WORLD_TILES, &data.vp);
+
+	data.max_z = 0;
+	while (((uint64)SCREENSHOT_TILE_SIZE << data.max_z) < (uint64)std::max(data.vp.width, data.vp.height)) data.max_z++;
+
+	data.directory = MakeScreenshotName(SCREENSHOT_NAME, "tiles");
+	data.directory += PATHSEP;
+	FioCreateDirectory(data.directory);
+
+	data.buffer.resize(SCREENSHOT_TILE_SIZE * SCREENSHOT_TILE_SIZE * depth / 8);
+
+	std::vector<Colour> tile(SCREENSHOT_TILE_SIZE * SCREENSHOT_TILE_SIZE);
+	return MakeWorldTile(data, 0, 0, 0, tile.data());
+#else
+	return false;
+#endif /* WITH_PNG */
+}
+
 /**
  * Callback for generating a heightmap. Supports 8bpp grayscale only.
  * @param userdata Pointer to user data.
@@ -935,6 +1207,10 @@ static bool RealMakeScreenshot(ScreenshotType t, std::string name, uint32 width,
 			ret = MakeLargeWorldScreenshot(t);
 			break;
 
+		case SC_WORLD_TILES:
+			ret = MakeWorldTilesScreenshot();
+			break;
+
 		case SC_HEIGHTMAP: {
 			const ScreenshotFormat *sf = _screenshot_formats + _cur_screenshot_format;
 			ret = MakeHeightmapScreenshot(MakeScreenshotName(HEIGHTMAP_NAME, sf->extension));
@@ -807,7 +807,7 @@ static void RedrawSmallmap(int32 new_value)
 {
 	BuildLandLegend();
 	BuildOwnerLegend();
-	SetWindowClassesDirty(WC_SMALLMAP);
+	InvalidateWindowClassesData(WC_SMALLMAP, 3);
 }
 
 static void StationSpreadChanged(int32 p1)
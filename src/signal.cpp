@@ -16,6 +16,9 @@
 #include "train.h"
 #include "company_base.h"
 
+#include <unordered_map>
+#include <vector>
+
 #include "safeguards.h"
 
 
@@ -187,6 +190,56 @@ static SmallSet<DiagDirection, SIG_TBD_SIZE> _tbdset("_tbdset");    ///< set of
 static SmallSet<DiagDirection, SIG_GLOB_SIZE> _globset("_globset"); ///< set of places to be updated in following runs
 
 
+/**
+ * Everything ExploreSegment learns about a signal block that only depends on the track layout.
+ * Replaying it gives the same result as searching the block again, as long as the layout did not change.
+ */
+struct SignalSegment {
+	/** A tile to check for trains. */
+	struct TrainCheck {
+		TileIndex tile;   ///< Tile to check.
+		TrackBits tracks; ///< Tracks to check, or INVALID_TRACK_BIT to check the whole tile.
+	};
+
+	/** A tile side, or a signal on a tile. */
+	template <typename Tdir>
+	struct TileDir {
+		TileIndex tile; ///< The tile.
+		Tdir dir;       ///< Side of the tile, or trackdir of the signal.
+	};
+
+	std::vector<TrainCheck> train_checks;               ///< Tiles to check for trains, in search order.
+	std::vector<TileDir<Trackdir>> signals;             ///< Signals at the border facing into the block, in search order.
+	std::vector<TileDir<Trackdir>> exits;               ///< Pre-signal exits leaving the block, in search order.
+	std::vector<TileDir<DiagDirection>> globset_removals; ///< Tile sides removed from _globset while searching, in search order.
+	bool pbs = false;                                   ///< Whether the block has path signals or two-way signals.
+};
+
+/** Signal blocks found by earlier searches, by the tile side, owner and direction the search started from. */
+static std::unordered_map<uint64, SignalSegment> _signal_segment_cache;
+
+/**
+ * Get the key of a search start in the signal segment cache.
+ * @param tile Tile the search started from.
+ * @param dir Side of the tile the search started from.
+ * @param owner Owner whose signals are updated.
+ * @return The key.
+ */
+static inline uint64 GetSignalSegmentKey(TileIndex tile, DiagDirection dir, Owner owner)
+{
+	return (uint64)tile | ((uint64)(byte)dir << 32) | ((uint64)(byte)owner << 40);
+}
+
+/**
+ * Forget all cached signal blocks.
+ * Call this whenever the track layout, or the ownership of tracks, changes.
+ */
+void InvalidateSignalSegmentCache()
+{
+	_signal_segment_cache.clear();
+}
+
+
 /** Check whether there is a train on rail, not in a depot */
 static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
 {
@@ -203,16 +256,19 @@ static Vehicle *TrainOnTileEnum(Vehicle *v, void *)
  * Also, remove reverse direction from _tbdset
  * This is the 'core' part so the graph searching won't enter any tile twice
  *
+ * @param segment segment to record the removals from the Global set in
  * @param t1 tile we are entering
  * @param d1 direction (tile side) we are entering
  * @param t2 tile we are leaving
  * @param d2 direction (tile side) we are leaving
  * @return false iff reverse direction was in Todo set
  */
-static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
+static inline bool CheckAddToTodoSet(SignalSegment &segment, TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
 {
 	_globset.Remove(t1, d1); // it can be in Global but not in Todo
 	_globset.Remove(t2, d2); // remove in all cases
+	segment.globset_removals.push_back({ t1, d1 });
+	segment.globset_removals.push_back({ t2, d2 });
 
 	assert(!_tbdset.IsIn(t1, d1)); // it really shouldn't be there already
 
@@ -229,15 +285,16 @@ static inline bool CheckAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t
  * Also, remove reverse direction from Todo set
  * This is the 'core' part so the graph searching won't enter any tile twice
  *
+ * @param segment segment to record the removals from the Global set in
  * @param t1 tile we are entering
  * @param d1 direction (tile side) we are entering
  * @param t2 tile we are leaving
  * @param d2 direction (tile side) we are leaving
  * @return false iff the Todo buffer would be overrun
  */
-static inline bool MaybeAddToTodoSet(TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
+static inline bool MaybeAddToTodoSet(SignalSegment &segment, TileIndex t1, DiagDirection d1, TileIndex t2, DiagDirection d2)
 {
-	if (!CheckAddToTodoSet(t1, d1, t2, d2)) return true;
+	if (!CheckAddToTodoSet(segment, t1, d1, t2, d2)) return true;
 
 	return _tbdset.Add(t1, d1);
 }
@@ -258,13 +315,31 @@ enum SigFlags {
 DECLARE_ENUM_AS_BIT_SET(SigFlags)
 
 
+/**
+ * Check for a train on a tile, unless a train was found in the segment already.
+ * The check is recorded in the segment in both cases.
+ *
+ * @param segment segment to record the check in
+ * @param flags flags of the segment so far
+ * @param tile tile to check
+ * @param tracks tracks to check, or INVALID_TRACK_BIT to check the whole tile
+ */
+static inline void CheckTrainOnTile(SignalSegment &segment, SigFlags &flags, TileIndex tile, TrackBits tracks)
+{
+	segment.train_checks.push_back({ tile, tracks });
+	if (flags & SF_TRAIN) return;
+
+	if (tracks == INVALID_TRACK_BIT ? HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum) : EnsureNoTrainOnTrackBits(tile, tracks).Failed()) flags |= SF_TRAIN;
+}
+
 /**
  * Search signal block
  *
  * @param owner owner whose signals we are updating
+ * @param segment segment to record the parts of the block that only depend on the track layout in
  * @return SigFlags
  */
-static SigFlags ExploreSegment(Owner owner)
+static SigFlags ExploreSegment(Owner owner, SignalSegment &segment)
 {
 	SigFlags flags = SF_NONE;
 
@@ -281,13 +356,13 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (IsRailDepot(tile)) {
 					if (enterdir == INVALID_DIAGDIR) { // from 'inside' - train just entered or left the depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						CheckTrainOnTile(segment, flags, tile, INVALID_TRACK_BIT);
 						exitdir = GetRailDepotDirection(tile);
 						tile += TileOffsByDiagDir(exitdir);
 						enterdir = ReverseDiagDir(exitdir);
 						break;
 					} else if (enterdir == GetRailDepotDirection(tile)) { // entered a depot
-						if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+						CheckTrainOnTile(segment, flags, tile, INVALID_TRACK_BIT);
 						continue;
 					} else {
 						continue;
@@ -300,11 +375,10 @@ static SigFlags ExploreSegment(Owner owner)
 
 				if (tracks == TRACK_BIT_HORZ || tracks == TRACK_BIT_VERT) { // there is exactly one incidating track, no need to check
 					tracks = tracks_masked;
-					/* If no train detected yet, and there is not no train -> there is a train -> set the flag */
-					if (!(flags & SF_TRAIN) && EnsureNoTrainOnTrackBits(tile, tracks).Failed()) flags |= SF_TRAIN;
+					CheckTrainOnTile(segment, flags, tile, tracks);
 				} else {
 					if (tracks_masked == TRACK_BIT_NONE) continue; // no incidating track
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					CheckTrainOnTile(segment, flags, tile, INVALID_TRACK_BIT);
 				}
 
 				if (HasSignals(tile)) { // there is exactly one track - not zero, because there is exit from this tile
@@ -321,10 +395,14 @@ static SigFlags ExploreSegment(Owner owner)
 								flags |= SF_PBS;
 							} else if (!_tbuset.Add(tile, reversedir)) {
 								return flags | SF_FULL;
+							} else {
+								segment.signals.push_back({ tile, reversedir });
 							}
 						}
 						if (HasSignalOnTrackdir(tile, trackdir) && !IsOnewaySignal(tile, track)) flags |= SF_PBS;
 
+						if (IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) segment.exits.push_back({ tile, trackdir });
+
 						/* if it is a presignal EXIT in OUR direction and we haven't found 2 green exits yes, do special check */
 						if (!(flags & SF_GREEN2) && IsPresignalExit(tile, track) && HasSignalOnTrackdir(tile, trackdir)) { // found presignal exit
 							if (flags & SF_EXIT) flags |= SF_EXIT2; // found two (or more) exits
@@ -343,7 +421,7 @@ static SigFlags ExploreSegment(Owner owner)
 					if (dir != enterdir && (tracks & _enterdir_to_trackbits[dir])) { // any track incidating?
 						TileIndex newtile = tile + TileOffsByDiagDir(dir);  // new tile to check
 						DiagDirection newdir = ReverseDiagDir(dir); // direction we are entering from
-						if (!MaybeAddToTodoSet(newtile, newdir, tile, dir)) return flags | SF_FULL;
+						if (!MaybeAddToTodoSet(segment, newtile, newdir, tile, dir)) return flags | SF_FULL;
 					}
 				}
 
@@ -356,7 +434,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (DiagDirToAxis(enterdir) != GetRailStationAxis(tile)) continue; // different axis
 				if (IsStationTileBlocked(tile)) continue; // 'eye-candy' station tile
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				CheckTrainOnTile(segment, flags, tile, INVALID_TRACK_BIT);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -365,7 +443,7 @@ static SigFlags ExploreSegment(Owner owner)
 				if (GetTileOwner(tile) != owner) continue;
 				if (DiagDirToAxis(enterdir) == GetCrossingRoadAxis(tile)) continue; // different axis
 
-				if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+				CheckTrainOnTile(segment, flags, tile, INVALID_TRACK_BIT);
 				tile += TileOffsByDiagDir(exitdir);
 				break;
 
@@ -375,13 +453,13 @@ static SigFlags ExploreSegment(Owner owner)
 				DiagDirection dir = GetTunnelBridgeDirection(tile);
 
 				if (enterdir == INVALID_DIAGDIR) { // incoming from the wormhole
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					CheckTrainOnTile(segment, flags, tile, INVALID_TRACK_BIT);
 					enterdir = dir;
 					exitdir = ReverseDiagDir(dir);
 					tile += TileOffsByDiagDir(exitdir); // just skip to next tile
 				} else { // NOT incoming from the wormhole!
 					if (ReverseDiagDir(enterdir) != dir) continue;
-					if (!(flags & SF_TRAIN) && HasVehicleOnPos(tile, nullptr, &TrainOnTileEnum)) flags |= SF_TRAIN;
+					CheckTrainOnTile(segment, flags, tile, INVALID_TRACK_BIT);
 					tile = GetOtherTunnelBridgeEnd(tile); // just skip to exit tile
 					enterdir = INVALID_DIAGDIR;
 					exitdir = INVALID_DIAGDIR;
@@ -393,7 +471,48 @@ static SigFlags ExploreSegment(Owner owner)
 				continue; // continue the while() loop
 		}
 
-		if (!MaybeAddToTodoSet(tile, enterdir, oldtile, exitdir)) return flags | SF_FULL;
+		if (!MaybeAddToTodoSet(segment, tile, enterdir, oldtile, exitdir)) return flags | SF_FULL;
+	}
+
+	segment.pbs = (flags & SF_PBS) != 0;
+	return flags;
+}
+
+
+/**
+ * Get the state of a signal block that was searched before, without searching it again.
+ * Does the same to _tbuset and _globset as ExploreSegment would, in the same order.
+ *
+ * @param segment the cached signal block
+ * @return SigFlags
+ */
+static SigFlags ReplaySegment(const SignalSegment &segment)
+{
+	SigFlags flags = segment.pbs ? SF_PBS : SF_NONE;
+
+	for (const SignalSegment::TrainCheck &check : segment.train_checks) {
+		if (check.tracks == INVALID_TRACK_BIT ? HasVehicleOnPos(check.tile, nullptr, &TrainOnTileEnum) : EnsureNoTrainOnTrackBits(check.tile, check.tracks).Failed()) {
+			flags |= SF_TRAIN;
+			break;
+		}
+	}
+
+	for (const SignalSegment::TileDir<Trackdir> &exit : segment.exits) {
+		if (flags & SF_GREEN2) break;
+		if (flags & SF_EXIT) flags |= SF_EXIT2; // found two (or more) exits
+		flags |= SF_EXIT;
+		if (GetSignalStateByTrackdir(exit.tile, exit.dir) == SIGNAL_STATE_GREEN) { // found green presignal exit
+			if (flags & SF_GREEN) flags |= SF_GREEN2;
+			flags |= SF_GREEN;
+		}
+	}
+
+	for (const SignalSegment::TileDir<Trackdir> &signal : segment.signals) {
+		_tbuset.Add(signal.tile, signal.dir);
+	}
+
+	for (const SignalSegment::TileDir<DiagDirection> &side : segment.globset_removals) {
+		_globset.Remove(side.tile, side.dir);
 	}
 
 	return flags;
@@ -481,6 +600,10 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 		assert(_tbuset.IsEmpty());
 		assert(_tbdset.IsEmpty());
 
+		/* Where the search starts only depends on the track layout, so this is how the block is found in the cache. */
+		TileIndex start_tile = tile;
+		DiagDirection start_dir = dir;
+
 		/* After updating signal, data stored are always MP_RAILWAY with signals.
 		 * Other situations happen when data are from outside functions -
 		 * modification of railbits (including both rail building and removal),
@@ -529,7 +652,18 @@ static SigSegState UpdateSignalsInBuffer(Owner owner)
 		assert(!_tbdset.Overflowed()); // it really shouldn't overflow by these one or two items
 		assert(!_tbdset.IsEmpty()); // it wouldn't hurt anyone, but shouldn't happen too
 
-		SigFlags flags = ExploreSegment(owner);
+		SigFlags flags;
+		uint64 key = GetSignalSegmentKey(start_tile, start_dir, owner);
+		auto cached = _signal_segment_cache.find(key);
+		if (cached != _signal_segment_cache.end()) {
+			_tbdset.Reset();
+			flags = ReplaySegment(cached->second);
+		} else {
+			SignalSegment segment;
+			flags = ExploreSegment(owner, segment);
+			/* Blocks that did not fit in the buffers are not complete, so do not remember them. */
+			if (!(flags & SF_FULL)) _signal_segment_cache.emplace(key, std::move(segment));
+		}
 
 		if (first) {
 			first = false;
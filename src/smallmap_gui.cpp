@@ -23,6 +23,7 @@
 #include "company_base.h"
 #include "guitimer_func.h"
 #include "zoom_func.h"
+#include "thread.h"
 
 #include "smallmap_gui.h"
 
@@ -160,6 +161,26 @@ static bool _smallmap_show_heightmap = false;
 static IndustryType _smallmap_industry_highlight = INVALID_INDUSTRYTYPE;
 /** State of highlight blinking */
 static bool _smallmap_industry_highlight_state;
+
+static bool _smallmap_track_dirty = false;          ///< Whether a smallmap with a colour plane is open, so dirty tiles need to be recorded.
+static std::vector<TileIndex> _smallmap_dirty_tiles; ///< Tiles that changed since the colour plane was last updated.
+static bool _smallmap_dirty_overflow = false;        ///< Too many tiles changed, rebuild the whole colour plane instead.
+
+/**
+ * Record that a tile changed, so its colour in the smallmap gets recomputed.
+ * @param tile The tile that changed.
+ */
+void MarkSmallMapTileDirty(TileIndex tile)
+{
+	if (!_smallmap_track_dirty || _smallmap_dirty_overflow) return;
+
+	if (_smallmap_dirty_tiles.size() >= MapSize() / 16) {
+		_smallmap_dirty_overflow = true;
+		_smallmap_dirty_tiles.clear();
+		return;
+	}
+	_smallmap_dirty_tiles.push_back(tile);
+}
 /** For connecting company ID to position in owner list (small map legend) */
 static uint _company_to_list_pos[MAX_COMPANIES];
 
@@ -740,86 +761,205 @@ void SmallMapWindow::SetZoomLevel(ZoomLevelChange change, const Point *zoom_pt)
 }
 
 /**
- * Decide which colours to show to the user for a group of tiles.
- * @param ta Tile area to investigate.
- * @return Colours to display.
+ * Compute the colour of a single tile in the current map type.
+ * @param tile Tile to investigate.
+ * @param[out] importance Importance of the tile when deciding which tile of a group is displayed, #PLANE_INDUSTRY for industries that are shown in colour.
+ * @return Colour of the tile.
  */
-inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
+inline uint32 SmallMapWindow::GetTileColour(TileIndex tile, uint8 *importance) const
 {
-	int importance = 0;
-	TileIndex tile = INVALID_TILE; // Position of the most important tile.
-	TileType et = MP_VOID;         // Effective tile type at that position.
-
-	for (TileIndex ti : ta) {
-		TileType ttype = GetTileType(ti);
+	TileType ttype = GetTileType(tile);
 
-		switch (ttype) {
-			case MP_TUNNELBRIDGE: {
-				TransportType tt = GetTunnelBridgeTransportType(ti);
+	switch (ttype) {
+		case MP_TUNNELBRIDGE: {
+			TransportType tt = GetTunnelBridgeTransportType(tile);
 
-				switch (tt) {
-					case TRANSPORT_RAIL: ttype = MP_RAILWAY; break;
-					case TRANSPORT_ROAD: ttype = MP_ROAD;    break;
-					default:             ttype = MP_WATER;   break;
-				}
-				break;
+			switch (tt) {
+				case TRANSPORT_RAIL: ttype = MP_RAILWAY; break;
+				case TRANSPORT_ROAD: ttype = MP_ROAD;    break;
+				default:             ttype = MP_WATER;   break;
 			}
+			break;
+		}
 
-			case MP_INDUSTRY:
-				/* Special handling of industries while in "Industries" smallmap view. */
-				if (this->map_type == SMT_INDUSTRY) {
-					/* If industry is allowed to be seen, use its colour on the map.
-					 * This has the highest priority above any value in _tiletype_importance. */
-					IndustryType type = Industry::GetByTile(ti)->type;
-					if (_legend_from_industries[_industry_to_list_pos[type]].show_on_map) {
-						if (type == _smallmap_industry_highlight) {
-							if (_smallmap_industry_highlight_state) return MKCOLOUR_XXXX(PC_WHITE);
-						} else {
-							return GetIndustrySpec(type)->map_colour * 0x01010101;
-						}
-					}
-					/* Otherwise make it disappear */
-					ttype = IsTileOnWater(ti) ? MP_WATER : MP_CLEAR;
+		case MP_INDUSTRY:
+			/* Special handling of industries while in "Industries" smallmap view. */
+			if (this->map_type == SMT_INDUSTRY) {
+				/* If industry is allowed to be seen, use its colour on the map.
+				 * This has the highest priority above any value in _tiletype_importance. */
+				IndustryType type = Industry::GetByTile(tile)->type;
+				if (_legend_from_industries[_industry_to_list_pos[type]].show_on_map) {
+					*importance = PLANE_INDUSTRY;
+					return GetIndustrySpec(type)->map_colour * 0x01010101;
 				}
-				break;
-
-			default:
-				break;
-		}
+				/* Otherwise make it disappear */
+				ttype = IsTileOnWater(tile) ? MP_WATER : MP_CLEAR;
+			}
+			break;
 
-		if (_tiletype_importance[ttype] > importance) {
-			importance = _tiletype_importance[ttype];
-			tile = ti;
-			et = ttype;
-		}
+		default:
+			break;
 	}
 
+	*importance = _tiletype_importance[ttype];
+
 	switch (this->map_type) {
 		case SMT_CONTOUR:
-			return GetSmallMapContoursPixels(tile, et);
+			return GetSmallMapContoursPixels(tile, ttype);
 
 		case SMT_VEHICLES:
-			return GetSmallMapVehiclesPixels(tile, et);
+			return GetSmallMapVehiclesPixels(tile, ttype);
 
 		case SMT_INDUSTRY:
-			return GetSmallMapIndustriesPixels(tile, et);
+			return GetSmallMapIndustriesPixels(tile, ttype);
 
 		case SMT_LINKSTATS:
-			return GetSmallMapLinkStatsPixels(tile, et);
+			return GetSmallMapLinkStatsPixels(tile, ttype);
 
 		case SMT_ROUTES:
-			return GetSmallMapRoutesPixels(tile, et);
+			return GetSmallMapRoutesPixels(tile, ttype);
 
 		case SMT_VEGETATION:
-			return GetSmallMapVegetationPixels(tile, et);
+			return GetSmallMapVegetationPixels(tile, ttype);
 
 		case SMT_OWNER:
-			return GetSmallMapOwnerPixels(tile, et);
+			return GetSmallMapOwnerPixels(tile, ttype);
 
 		default: NOT_REACHED();
 	}
 }
 
+/**
+ * Decide which colours to show to the user for a group of tiles.
+ * The colours are taken from the colour plane, which must be up to date.
+ * @param ta Tile area to investigate.
+ * @return Colours to display.
+ */
+inline uint32 SmallMapWindow::GetTileColours(const TileArea &ta) const
+{
+	uint8 importance = 0;
+	uint32 colour = 0;
+
+	for (TileIndex ti : ta) {
+		uint8 tile_importance = this->plane_importance[ti];
+		uint32 tile_colour = this->plane_colours[ti];
+
+		if (tile_importance == PLANE_INDUSTRY) {
+			/* The highlighted industry type blinks; that changes too often to be worth caching. */
+			if (!IsTileType(ti, MP_INDUSTRY)) {
+				tile_colour = this->GetTileColour(ti, &tile_importance);
+			} else if (Industry::GetByTile(ti)->type != _smallmap_industry_highlight) {
+				return tile_colour;
+			} else if (_smallmap_industry_highlight_state) {
+				return MKCOLOUR_XXXX(PC_WHITE);
+			} else {
+				TileType ttype = IsTileOnWater(ti) ? MP_WATER : MP_CLEAR;
+				tile_importance = _tiletype_importance[ttype];
+				tile_colour = GetSmallMapIndustriesPixels(ti, ttype);
+			}
+			if (tile_importance == PLANE_INDUSTRY) return tile_colour;
+		}
+
+		if (tile_importance > importance) {
+			importance = tile_importance;
+			colour = tile_colour;
+		}
+	}
+
+	return colour;
+}
+
+/**
+ * Recompute a range of rows of the colour plane.
+ * Only reads the map, so multiple ranges can be computed at the same time while the game is not running.
+ * @param w Smallmap window owning the colour plane.
+ * @param first_row First row to compute.
+ * @param last_row Row after the last row to compute.
+ */
+/* static */ void SmallMapWindow::RebuildColourPlaneRows(SmallMapWindow *w, uint first_row, uint last_row)
+{
+	for (TileIndex tile = TileXY(0, first_row); tile < TileXY(0, last_row); tile++) {
+		w->plane_colours[tile] = w->GetTileColour(tile, &w->plane_importance[tile]);
+	}
+}
+
+/**
+ * Recompute the whole colour plane.
+ * Large maps are split into bands of rows that are computed by worker threads.
+ */
+void SmallMapWindow::RebuildColourPlane()
+{
+	this->plane_colours.resize(MapSize());
+	this->plane_importance.resize(MapSize());
+
+	uint threads = Clamp<uint>(std::thread::hardware_concurrency(), 1, 8);
+	threads = std::min(threads, std::max(1U, MapSizeY() / PLANE_MIN_THREAD_ROWS));
+	uint rows = CeilDiv(MapSizeY(), threads);
+
+	std::vector<std::thread> workers;
+	uint first_row = rows;
+	for (; first_row < MapSizeY(); first_row += rows) {
+		uint last_row = std::min(first_row + rows, MapSizeY());
+		std::thread worker;
+		if (!StartNewThread(&worker, "ottd:smallmap", &SmallMapWindow::RebuildColourPlaneRows, this, uint(first_row), uint(last_row))) break;
+		workers.push_back(std::move(worker));
+	}
+
+	/* The first band, and whatever could not be handed to a worker, is computed here. */
+	SmallMapWindow::RebuildColourPlaneRows(this, 0, std::min(rows, MapSizeY()));
+	if (first_row < MapSizeY()) SmallMapWindow::RebuildColourPlaneRows(this, first_row, MapSizeY());
+
+	for (std::thread &worker : workers) worker.join();
+
+	this->plane_valid = true;
+	this->plane_refresh_row = 0;
+}
+
+/**
+ * Bring the colour plane up to date before drawing.
+ * Tiles that were marked dirty since the previous update are recomputed,
+ * everything is recomputed when the plane was invalidated.
+ */
+void SmallMapWindow::UpdateColourPlane()
+{
+	if (_smallmap_dirty_overflow || this->plane_colours.size() != MapSize()) this->plane_valid = false;
+
+	if (!this->plane_valid) {
+		this->RebuildColourPlane();
+	} else {
+		for (TileIndex tile : _smallmap_dirty_tiles) {
+			this->plane_colours[tile] = this->GetTileColour(tile, &this->plane_importance[tile]);
+		}
+	}
+
+	_smallmap_dirty_tiles.clear();
+	_smallmap_dirty_overflow = false;
+}
+
+/**
+ * Get the tiles that are (partly) shown in the smallmap.
+ * @return The smallest area containing all shown tiles, limited to the map.
+ */
+OrthogonalTileArea SmallMapWindow::GetVisibleTileArea() const
+{
+	const NWidgetBase *wi = this->GetWidget<NWidgetBase>(WID_SM_MAP);
+	int sub;
+	/* Tile x is smallest at the top right and largest at the bottom left; tile y is smallest at the top left and largest at the bottom right. */
+	Point top_left = this->PixelToTile(0, 0, &sub);
+	Point top_right = this->PixelToTile(wi->current_x, 0, &sub);
+	Point bottom_left = this->PixelToTile(0, wi->current_y, &sub);
+	Point bottom_right = this->PixelToTile(wi->current_x, wi->current_y, &sub);
+
+	/* Allow for the partly shown tiles at the edges, and for a zoomed out pixel covering several tiles. */
+	int base_x = this->scroll_x / (int)TILE_SIZE;
+	int base_y = this->scroll_y / (int)TILE_SIZE;
+	uint min_x = Clamp(base_x + top_right.x - this->zoom, 0, (int)MapMaxX());
+	uint max_x = Clamp(base_x + bottom_left.x + 2 * this->zoom, 0, (int)MapMaxX());
+	uint min_y = Clamp(base_y + top_left.y - this->zoom, 0, (int)MapMaxY());
+	uint max_y = Clamp(base_y + bottom_right.y + 2 * this->zoom, 0, (int)MapMaxY());
+	return OrthogonalTileArea(TileXY(min_x, min_y), TileXY(max_x, max_y));
+}
+
 /**
  * Draws one column of tiles of the small map in a certain mode onto the screen buffer, skipping the shifted rows in between.
  *
@@ -1072,9 +1212,10 @@ void SmallMapWindow::SetupWidgetData()
 	this->GetWidget<NWidgetStacked>(WID_SM_SELECT_BUTTONS)->SetDisplayedPlane(plane);
 }
 
-SmallMapWindow::SmallMapWindow(WindowDesc *desc, int window_number) : Window(desc), refresh(GUITimer(FORCE_REFRESH_PERIOD))
+SmallMapWindow::SmallMapWindow(WindowDesc *desc, int window_number) : Window(desc), refresh(GUITimer(FORCE_REFRESH_PERIOD)), plane_valid(false), plane_refresh_row(0)
 {
 	_smallmap_industry_highlight = INVALID_INDUSTRYTYPE;
+	_smallmap_track_dirty = true;
 	this->overlay = new LinkGraphOverlay(this, WID_SM_MAP, 0, this->GetOverlayCompanyMask(), 1);
 	this->InitNested(window_number);
 	this->LowerWidget(this->map_type + WID_SM_CONTOUR);
@@ -1095,6 +1236,10 @@ SmallMapWindow::SmallMapWindow(WindowDesc *desc, int window_number) : Window(des
 SmallMapWindow::~SmallMapWindow()
 {
 	delete this->overlay;
+
+	_smallmap_track_dirty = false;
+	_smallmap_dirty_tiles.clear();
+	_smallmap_dirty_tiles.shrink_to_fit();
 }
 
 /* virtual */ void SmallMapWindow::Close()
@@ -1203,6 +1348,7 @@ void SmallMapWindow::RebuildColourIndexIfNecessary()
 		}
 	}
 
+	this->UpdateColourPlane();
 	this->DrawWidgets();
 }
 
@@ -1314,6 +1460,7 @@ void SmallMapWindow::SwitchMapType(SmallMapType map_type)
 	this->LowerWidget(this->map_type + WID_SM_CONTOUR);
 
 	this->SetupWidgetData();
+	this->InvalidateColourPlane();
 
 	if (map_type == SMT_LINKSTATS) this->overlay->SetDirty();
 	if (map_type != SMT_INDUSTRY) this->BreakIndustryChainLink();
@@ -1493,6 +1640,7 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 						this->SelectLegendItem(click_pos, _legend_land_owners, _smallmap_company_count, NUM_NO_COMPANY_ENTRIES);
 					}
 				}
+				this->InvalidateColourPlane();
 				this->SetDirty();
 			}
 			break;
@@ -1518,6 +1666,7 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 				tbl->show_on_map = (widget == WID_SM_ENABLE_ALL);
 			}
 			if (this->map_type == SMT_LINKSTATS) this->SetOverlayCargoMask();
+			this->InvalidateColourPlane();
 			this->SetDirty();
 			break;
 		}
@@ -1525,6 +1674,7 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 		case WID_SM_SHOW_HEIGHT: // Enable/disable showing of heightmap.
 			_smallmap_show_heightmap = !_smallmap_show_heightmap;
 			this->SetWidgetLoweredState(WID_SM_SHOW_HEIGHT, _smallmap_show_heightmap);
+			this->InvalidateColourPlane();
 			this->SetDirty();
 			break;
 	}
@@ -1536,6 +1686,7 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
  * - data = 0: Displayed industries at the industry chain window have changed.
  * - data = 1: Companies have changed.
  * - data = 2: Cheat changing the maximum heightlevel has been used, rebuild our heightlevel-to-colour index
+ * - data = 3: The colour scheme of the map has changed.
  * @param gui_scope Whether the call is done from GUI scope. You may not do everything when not in GUI scope. See #InvalidateWindowData() for details.
  */
 /* virtual */ void SmallMapWindow::OnInvalidateData(int data, bool gui_scope)
@@ -1562,8 +1713,12 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 			this->RebuildColourIndexIfNecessary();
 			break;
 
+		case 3:
+			break;
+
 		default: NOT_REACHED();
 	}
+	this->InvalidateColourPlane();
 	this->SetDirty();
 }
 
@@ -1603,6 +1758,22 @@ int SmallMapWindow::GetPositionOnLegend(Point pt)
 	}
 	_smallmap_industry_highlight_state = !_smallmap_industry_highlight_state;
 
+	/* Not every change of the map marks its tiles dirty (e.g. changing owners), so slowly walk over the shown part of the colour plane. */
+	if (this->plane_valid && this->plane_colours.size() == MapSize()) {
+		OrthogonalTileArea visible = this->GetVisibleTileArea();
+		uint first_row = TileY(visible.tile);
+		uint end_row = first_row + visible.h;
+		if (this->plane_refresh_row < first_row || this->plane_refresh_row >= end_row) this->plane_refresh_row = first_row;
+
+		uint rows = CeilDiv(visible.h, PLANE_REFRESH_SLICES);
+		uint last_row = std::min(this->plane_refresh_row + rows, end_row);
+		OrthogonalTileArea slice(TileXY(TileX(visible.tile), this->plane_refresh_row), TileXY(TileX(visible.tile) + visible.w - 1, last_row - 1));
+		for (TileIndex tile : slice) {
+			this->plane_colours[tile] = this->GetTileColour(tile, &this->plane_importance[tile]);
+		}
+		this->plane_refresh_row = (last_row == end_row) ? first_row : last_row;
+	}
+
 	this->refresh.SetInterval(_smallmap_industry_highlight != INVALID_INDUSTRYTYPE ? BLINK_PERIOD : FORCE_REFRESH_PERIOD);
 	this->SetDirty();
 }
@@ -18,6 +18,7 @@
 #include "linkgraph/linkgraph_gui.h"
 #include "widgets/smallmap_widget.h"
 #include "guitimer_func.h"
+#include "tilearea_type.h"
 
 /* set up the cargos to be displayed in the smallmap's route legend */
 void BuildLinkStatsLegend();
@@ -26,6 +27,7 @@ void BuildIndustriesLegend();
 void ShowSmallMap();
 void BuildLandLegend();
 void BuildOwnerLegend();
+void MarkSmallMapTileDirty(TileIndex tile);
 
 /** Structure for holding relevant data for legends in small map */
 struct LegendAndColour {
@@ -67,6 +69,9 @@ protected:
 	static const uint INDUSTRY_MIN_NUMBER_OF_COLUMNS = 2; ///< Minimal number of columns in the #WID_SM_LEGEND widget for the #SMT_INDUSTRY legend.
 	static const uint FORCE_REFRESH_PERIOD = 930; ///< map is redrawn after that many milliseconds.
 	static const uint BLINK_PERIOD         = 450; ///< highlight blinking interval in milliseconds.
+	static const uint PLANE_REFRESH_SLICES = 32;  ///< Number of refresh periods it takes to recompute the visible part of the colour plane.
+	static const uint PLANE_MIN_THREAD_ROWS = 128; ///< Minimal number of map rows a worker thread recomputes when rebuilding the colour plane.
+	static const uint8 PLANE_INDUSTRY = 0xFF;     ///< Importance value of a visible industry tile in #SMT_INDUSTRY, it overrides everything else.
 
 	uint min_number_of_columns;    ///< Minimal number of columns in legends.
 	uint min_number_of_fixed_rows; ///< Minimal number of rows in the legends for the fixed layouts only (all except #SMT_INDUSTRY).
@@ -81,6 +86,11 @@ protected:
 	GUITimer refresh; ///< Refresh timer.
 	LinkGraphOverlay *overlay;
 
+	std::vector<uint32> plane_colours;   ///< Cached colour of every tile of the map in the current map type.
+	std::vector<uint8> plane_importance; ///< Cached importance of every tile of the map, see #_tiletype_importance.
+	bool plane_valid;                    ///< Whether the colour plane matches the current map type and legends.
+	uint plane_refresh_row;              ///< First map row to recompute at the next periodic refresh of the visible part of the colour plane.
+
 	static void BreakIndustryChainLink();
 	Point SmallmapRemapCoords(int x, int y) const;
 
@@ -165,8 +175,20 @@ protected:
 	void SetZoomLevel(ZoomLevelChange change, const Point *zoom_pt);
 	void SetOverlayCargoMask();
 	void SetupWidgetData();
+	uint32 GetTileColour(TileIndex tile, uint8 *importance) const;
 	uint32 GetTileColours(const TileArea &ta) const;
 
+	static void RebuildColourPlaneRows(SmallMapWindow *w, uint first_row, uint last_row);
+	void RebuildColourPlane();
+	void UpdateColourPlane();
+	OrthogonalTileArea GetVisibleTileArea() const;
+
+	/** Throw away the colour plane, it is rebuilt on the next redraw. */
+	inline void InvalidateColourPlane()
+	{
+		this->plane_valid = false;
+	}
+
 	int GetPositionOnLegend(Point pt);
 
 public:
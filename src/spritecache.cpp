@@ -10,6 +10,7 @@
 #include "stdafx.h"
 #include "random_access_file_type.h"
 #include "spriteloader/grf.hpp"
+#include "spritecache_disk.h"
 #include "gfx_func.h"
 #include "error.h"
 #include "zoom_func.h"
@@ -33,7 +34,9 @@ struct SpriteCache {
 	size_t file_pos;
 	SpriteFile *file;    ///< The file the sprite in this entry can be found in.
 	uint32 id;
-	int16 lru;
+	uint32 lru;          ///< Moment the sprite was last used, to compare the least recently used entries of the size classes.
+	SpriteID lru_prev;   ///< More recently used entry of the same size class, or #SPRITE_LRU_NONE.
+	SpriteID lru_next;   ///< Less recently used entry of the same size class, or #SPRITE_LRU_NONE.
 	SpriteType type;     ///< In some cases a single sprite is misused by two NewGRFs. Once as real sprite and once as recolour sprite. If the recolour sprite gets into the cache it might be drawn as real sprite which causes enormous trouble.
 	bool warned;         ///< True iff the user has been warned about incorrect use of this sprite
 };
@@ -103,19 +106,77 @@ SpriteFile &OpenCachedSpriteFile(const std::string &filename, Subdirectory subdi
 	return *file;
 }
 
-struct MemBlock {
-	size_t size;
+/**
+ * Header in front of every block of sprite data handed out by the sprite cache.
+ * Its size also defines the alignment of the sprite data.
+ */
+struct SpriteBlock {
+	struct SpriteSlab *slab; ///< Slab this block is part of, or \c nullptr when the block has its own allocation.
+	uint32 size;             ///< Size of the block, including this header.
+	SpriteID sprite;         ///< Sprite cache entry using this block and that may be evicted, or #SPRITE_LRU_NONE.
 	byte data[];
 };
 
-static uint _sprite_lru_counter;
-static MemBlock *_spritecache_ptr;
-static uint _allocated_sprite_cache_size = 0;
-static int _compact_cache_counter;
+/** Entries of a single size class that may be evicted, from most to least recently used. */
+struct SpriteLRUList {
+	SpriteID head; ///< Most recently used entry, or #SPRITE_LRU_NONE.
+	SpriteID tail; ///< Least recently used entry, or #SPRITE_LRU_NONE.
+};
+
+/**
+ * A fixed size chunk of memory that is split into equally sized blocks of a single size class.
+ * As blocks of one class are interchangeable, a released block can always be reused as-is;
+ * fragmentation can thus not build up and the cache never needs to be compacted.
+ */
+struct SpriteSlab {
+	SpriteSlab *prev;  ///< Previous slab of the same size class with free blocks.
+	SpriteSlab *next;  ///< Next slab of the same size class with free blocks.
+	SpriteBlock *free; ///< Chain of released blocks of this slab.
+	uint16 used;       ///< Number of blocks currently in use.
+	uint16 bumped;     ///< Number of blocks that were ever handed out from the start of the slab.
+	uint8 size_class;  ///< Size class of the blocks in this slab.
+};
+
+/** Size of a single slab, including its header. */
+static const size_t SPRITE_SLAB_SIZE = 64 * 1024;
+/** Offset of the first block within a slab. */
+static const size_t SPRITE_SLAB_HEADER_SIZE = (sizeof(SpriteSlab) + sizeof(SpriteBlock) - 1) / sizeof(SpriteBlock) * sizeof(SpriteBlock);
+/** Block sizes, including the block header, of the size classes served from slabs. Larger blocks get their own allocation. */
+static constexpr size_t _sprite_size_classes[] = {
+	32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096, 6144, 8192, 12288, 16384,
+};
+/** Size class of blocks that do not fit in any slab. */
+static const uint8 SPRITE_SIZE_CLASS_LARGE = lengthof(_sprite_size_classes);
+
+static_assert(sizeof(SpriteBlock) % sizeof(size_t) == 0);
+static_assert(_sprite_size_classes[SPRITE_SIZE_CLASS_LARGE - 1] * 2 <= SPRITE_SLAB_SIZE - SPRITE_SLAB_HEADER_SIZE);
+
+/** Marker for the end of a #SpriteLRUList, and for blocks that are not in one. */
+static const SpriteID SPRITE_LRU_NONE = UINT32_MAX;
+
+static uint32 _sprite_lru_counter;
+static SpriteSlab *_sprite_partial_slabs[SPRITE_SIZE_CLASS_LARGE]; ///< Per size class the slabs that still have free blocks.
+static SpriteLRUList _sprite_lru_lists[SPRITE_SIZE_CLASS_LARGE + 1]; ///< Per size class, including the large blocks, the entries that may be evicted.
+static size_t _sprite_cache_budget = 0;          ///< Maximum number of bytes the sprite cache may allocate.
+static size_t _sprite_cache_slab_allocated = 0;  ///< Number of bytes allocated for slabs.
+static size_t _sprite_cache_large_allocated = 0; ///< Number of bytes allocated for large blocks.
+static size_t _sprite_cache_inuse = 0;           ///< Number of bytes of blocks that are in use.
 
-static void CompactSpriteCache();
 static void *AllocSprite(size_t mem_req);
 
+static size_t _encoded_sprite_size; ///< Size of the last sprite allocated by #AllocEncodedSprite.
+
+/**
+ * Sprite cache allocator that remembers the size of the allocation, so the encoded sprite can be stored in the disk cache.
+ * @param mem_req Size of the sprite.
+ * @return Memory for the sprite.
+ */
+static void *AllocEncodedSprite(size_t mem_req)
+{
+	_encoded_sprite_size = mem_req;
+	return AllocSprite(mem_req);
+}
+
 /**
  * Skip the given amount of sprite graphics data.
  * @param type the type of sprite (compressed etc)
@@ -464,6 +525,13 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 
 	Debug(sprite, 9, "Load sprite {}", id);
 
+	/* Sprites for the sprite cache are encoded by the current blitter, so they can come from the disk cache. */
+	bool use_disk_cache = _sprite_disk_cache && allocator == AllocSprite && sprite_type != ST_MAPGEN;
+	if (use_disk_cache) {
+		void *cached = LoadSpriteFromDiskCache(file, file_pos, sprite_type, allocator);
+		if (cached != nullptr) return cached;
+	}
+
 	SpriteLoader::Sprite sprite[ZOOM_LVL_COUNT];
 	uint8 sprite_avail = 0;
 	sprite[ZOOM_LVL_NORMAL].type = sprite_type;
@@ -526,7 +594,11 @@ static void *ReadSprite(const SpriteCache *sc, SpriteID id, SpriteType sprite_ty
 		sprite[ZOOM_LVL_NORMAL].colours = sprite[ZOOM_LVL_FONT].colours;
 	}
 
-	return encoder->Encode(sprite, allocator);
+	if (!use_disk_cache) return encoder->Encode(sprite, allocator);
+
+	Sprite *s = encoder->Encode(sprite, AllocEncodedSprite);
+	StoreSpriteInDiskCache(file, file_pos, sprite_type, s, _encoded_sprite_size);
+	return s;
 }
 
 
@@ -655,106 +727,226 @@ void DupSprite(SpriteID old_spr, SpriteID new_spr)
 	scnew->warned = false;
 }
 
-/**
- * S_FREE_MASK is used to mask-out lower bits of MemBlock::size
- * If they are non-zero, the block is free.
- * S_FREE_MASK has to ensure MemBlock is correctly aligned -
- * it means 8B (S_FREE_MASK == 7) on 64bit systems!
- */
-static const size_t S_FREE_MASK = sizeof(size_t) - 1;
+static size_t GetSpriteCacheUsage()
+{
+	return _sprite_cache_inuse;
+}
 
-/* to make sure nobody adds things to MemBlock without checking S_FREE_MASK first */
-static_assert(sizeof(MemBlock) == sizeof(size_t));
-/* make sure it's a power of two */
-static_assert((sizeof(size_t) & (sizeof(size_t) - 1)) == 0);
 
-static inline MemBlock *NextBlock(MemBlock *block)
+void IncreaseSpriteLRU()
 {
-	return (MemBlock*)((byte*)block + (block->size & ~S_FREE_MASK));
+	/* Halve all LRU values before the counter can wrap; this keeps the order of the entries. */
+	if (_sprite_lru_counter > (1U << 31)) {
+		Debug(sprite, 3, "Fixing lru {}, inuse={}", _sprite_lru_counter, GetSpriteCacheUsage());
+
+		for (SpriteID i = 0; i != _spritecache_items; i++) {
+			SpriteCache *sc = GetSpriteCache(i);
+			if (sc->ptr != nullptr) sc->lru >>= 1;
+		}
+		_sprite_lru_counter >>= 1;
+	}
 }
 
-static size_t GetSpriteCacheUsage()
+/**
+ * Get the size class for a block of the given size.
+ * @param size Size of the block, including its header.
+ * @return The smallest size class the block fits in, or #SPRITE_SIZE_CLASS_LARGE.
+ */
+static uint8 GetSpriteSizeClass(size_t size)
 {
-	size_t tot_size = 0;
-	MemBlock *s;
-
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (!(s->size & S_FREE_MASK)) tot_size += s->size;
+	for (uint8 i = 0; i != SPRITE_SIZE_CLASS_LARGE; i++) {
+		if (size <= _sprite_size_classes[i]) return i;
 	}
+	return SPRITE_SIZE_CLASS_LARGE;
+}
 
-	return tot_size;
+/**
+ * Get the number of blocks that fit in a slab of the given size class.
+ * @param size_class The size class of the slab.
+ * @return The number of blocks.
+ */
+static inline uint GetSpriteSlabCapacity(uint8 size_class)
+{
+	return (uint)((SPRITE_SLAB_SIZE - SPRITE_SLAB_HEADER_SIZE) / _sprite_size_classes[size_class]);
 }
 
+/**
+ * Get a block of a slab.
+ * @param slab The slab.
+ * @param index Index of the block within the slab.
+ * @return The block.
+ */
+static inline SpriteBlock *GetSpriteSlabBlock(SpriteSlab *slab, uint index)
+{
+	return reinterpret_cast<SpriteBlock *>(reinterpret_cast<byte *>(slab) + SPRITE_SLAB_HEADER_SIZE + index * _sprite_size_classes[slab->size_class]);
+}
 
-void IncreaseSpriteLRU()
+/**
+ * Get the header of a block of sprite data.
+ * @param ptr The sprite data, as returned by #AllocSprite.
+ * @return The header of the block.
+ */
+static inline SpriteBlock *GetSpriteBlock(void *ptr)
 {
-	/* Increase all LRU values */
-	if (_sprite_lru_counter > 16384) {
-		SpriteID i;
+	return reinterpret_cast<SpriteBlock *>(ptr) - 1;
+}
 
-		Debug(sprite, 3, "Fixing lru {}, inuse={}", _sprite_lru_counter, GetSpriteCacheUsage());
+/**
+ * Get the size class of a block.
+ * @param block The block.
+ * @return The size class of its slab, or #SPRITE_SIZE_CLASS_LARGE.
+ */
+static inline uint8 GetSpriteBlockSizeClass(const SpriteBlock *block)
+{
+	return block->slab != nullptr ? block->slab->size_class : SPRITE_SIZE_CLASS_LARGE;
+}
 
-		for (i = 0; i != _spritecache_items; i++) {
-			SpriteCache *sc = GetSpriteCache(i);
-			if (sc->ptr != nullptr) {
-				if (sc->lru >= 0) {
-					sc->lru = -1;
-				} else if (sc->lru != -32768) {
-					sc->lru--;
-				}
-			}
-		}
-		_sprite_lru_counter = 0;
+/**
+ * Add a sprite cache entry as most recently used entry to the list of its size class, so it may be evicted.
+ * @param item The entry, which must have its sprite loaded.
+ */
+static void LinkSpriteLRU(SpriteID item)
+{
+	SpriteCache *sc = GetSpriteCache(item);
+	SpriteBlock *block = GetSpriteBlock(sc->ptr);
+	SpriteLRUList &list = _sprite_lru_lists[GetSpriteBlockSizeClass(block)];
+
+	block->sprite = item;
+	sc->lru_prev = SPRITE_LRU_NONE;
+	sc->lru_next = list.head;
+	if (list.head != SPRITE_LRU_NONE) {
+		GetSpriteCache(list.head)->lru_prev = item;
+	} else {
+		list.tail = item;
 	}
+	list.head = item;
+}
+
+/**
+ * Remove a sprite cache entry from the list of its size class.
+ * @param item The entry, which must be in the list.
+ */
+static void UnlinkSpriteLRU(SpriteID item)
+{
+	SpriteCache *sc = GetSpriteCache(item);
+	SpriteBlock *block = GetSpriteBlock(sc->ptr);
+	SpriteLRUList &list = _sprite_lru_lists[GetSpriteBlockSizeClass(block)];
 
-	/* Compact sprite cache every now and then. */
-	if (++_compact_cache_counter >= 740) {
-		CompactSpriteCache();
-		_compact_cache_counter = 0;
+	if (sc->lru_prev != SPRITE_LRU_NONE) {
+		GetSpriteCache(sc->lru_prev)->lru_next = sc->lru_next;
+	} else {
+		list.head = sc->lru_next;
+	}
+	if (sc->lru_next != SPRITE_LRU_NONE) {
+		GetSpriteCache(sc->lru_next)->lru_prev = sc->lru_prev;
+	} else {
+		list.tail = sc->lru_prev;
+	}
+	block->sprite = SPRITE_LRU_NONE;
+}
+
+/** Empty the lists of entries that may be evicted. */
+static void ResetSpriteLRU()
+{
+	for (SpriteLRUList &list : _sprite_lru_lists) {
+		list.head = SPRITE_LRU_NONE;
+		list.tail = SPRITE_LRU_NONE;
 	}
 }
 
 /**
- * Called when holes in the sprite cache should be removed.
- * That is accomplished by moving the cached data.
+ * Add a slab to the list of slabs with free blocks of its size class.
+ * @param slab The slab to add.
  */
-static void CompactSpriteCache()
+static void LinkSpriteSlab(SpriteSlab *slab)
 {
-	MemBlock *s;
+	SpriteSlab *&head = _sprite_partial_slabs[slab->size_class];
+	slab->prev = nullptr;
+	slab->next = head;
+	if (head != nullptr) head->prev = slab;
+	head = slab;
+}
 
-	Debug(sprite, 3, "Compacting sprite cache, inuse={}", GetSpriteCacheUsage());
+/**
+ * Remove a slab from the list of slabs with free blocks of its size class.
+ * @param slab The slab to remove.
+ */
+static void UnlinkSpriteSlab(SpriteSlab *slab)
+{
+	if (slab->prev != nullptr) {
+		slab->prev->next = slab->next;
+	} else {
+		_sprite_partial_slabs[slab->size_class] = slab->next;
+	}
+	if (slab->next != nullptr) slab->next->prev = slab->prev;
+	slab->prev = nullptr;
+	slab->next = nullptr;
+}
 
-	for (s = _spritecache_ptr; s->size != 0;) {
-		if (s->size & S_FREE_MASK) {
-			MemBlock *next = NextBlock(s);
-			MemBlock temp;
-			SpriteID i;
+/**
+ * Take a block from a slab of the given size class, allocating a new slab when none has free blocks.
+ * @param size_class The size class to get a block of.
+ * @return The block.
+ */
+static SpriteBlock *AllocSpriteSlabBlock(uint8 size_class)
+{
+	SpriteSlab *slab = _sprite_partial_slabs[size_class];
+	if (slab == nullptr) {
+		slab = reinterpret_cast<SpriteSlab *>(MallocT<byte>(SPRITE_SLAB_SIZE));
+		slab->free = nullptr;
+		slab->used = 0;
+		slab->bumped = 0;
+		slab->size_class = size_class;
+		LinkSpriteSlab(slab);
+		_sprite_cache_slab_allocated += SPRITE_SLAB_SIZE;
+	}
 
-			/* Since free blocks are automatically coalesced, this should hold true. */
-			assert(!(next->size & S_FREE_MASK));
+	SpriteBlock *block;
+	if (slab->free != nullptr) {
+		/* Reuse a released block; free blocks store the next free block in their data. */
+		block = slab->free;
+		slab->free = *reinterpret_cast<SpriteBlock **>(block->data);
+	} else {
+		block = GetSpriteSlabBlock(slab, slab->bumped);
+		slab->bumped++;
+	}
 
-			/* If the next block is the sentinel block, we can safely return */
-			if (next->size == 0) break;
+	if (++slab->used == GetSpriteSlabCapacity(size_class)) UnlinkSpriteSlab(slab);
 
-			/* Locate the sprite belonging to the next pointer. */
-			for (i = 0; GetSpriteCache(i)->ptr != next->data; i++) {
-				assert(i != _spritecache_items);
-			}
+	block->slab = slab;
+	block->size = (uint32)_sprite_size_classes[size_class];
+	return block;
+}
 
-			GetSpriteCache(i)->ptr = s->data; // Adjust sprite array entry
-			/* Swap this and the next block */
-			temp = *s;
-			memmove(s, next, next->size);
-			s = NextBlock(s);
-			*s = temp;
+/**
+ * Release the block of sprite data back to the sprite cache.
+ * Slabs that become empty are returned to the system.
+ * @param ptr The sprite data, as returned by #AllocSprite.
+ */
+static void FreeSprite(void *ptr)
+{
+	SpriteBlock *block = GetSpriteBlock(ptr);
+	_sprite_cache_inuse -= block->size;
+
+	SpriteSlab *slab = block->slab;
+	if (slab == nullptr) {
+		_sprite_cache_large_allocated -= block->size;
+		free(block);
+		return;
+	}
 
-			/* Coalesce free blocks */
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
-		} else {
-			s = NextBlock(s);
-		}
+	bool was_full = slab->used == GetSpriteSlabCapacity(slab->size_class);
+	block->sprite = SPRITE_LRU_NONE;
+	*reinterpret_cast<SpriteBlock **>(block->data) = slab->free;
+	slab->free = block;
+	slab->used--;
+
+	if (slab->used == 0) {
+		if (!was_full) UnlinkSpriteSlab(slab);
+		_sprite_cache_slab_allocated -= SPRITE_SLAB_SIZE;
+		free(slab);
+	} else if (was_full) {
+		LinkSpriteSlab(slab);
 	}
 }
 
@@ -764,80 +956,73 @@ static void CompactSpriteCache()
  */
 static void DeleteEntryFromSpriteCache(uint item)
 {
-	/* Mark the block as free (the block must be in use) */
-	MemBlock *s = (MemBlock*)GetSpriteCache(item)->ptr - 1;
-	assert(!(s->size & S_FREE_MASK));
-	s->size |= S_FREE_MASK;
-	GetSpriteCache(item)->ptr = nullptr;
-
-	/* And coalesce adjacent free blocks */
-	for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-		if (s->size & S_FREE_MASK) {
-			while (NextBlock(s)->size & S_FREE_MASK) {
-				s->size += NextBlock(s)->size & ~S_FREE_MASK;
-			}
-		}
-	}
+	/* The block must be in use */
+	SpriteCache *sc = GetSpriteCache(item);
+	assert(sc->ptr != nullptr);
+	if (GetSpriteBlock(sc->ptr)->sprite == item) UnlinkSpriteLRU(item);
+	FreeSprite(sc->ptr);
+	sc->ptr = nullptr;
 }
 
-static void DeleteEntryFromSpriteCache()
+/**
+ * Free memory in the sprite cache by deleting the least recently used entry of all size classes.
+ * When that entry is of the requested size class, deleting it immediately yields a usable block.
+ * Otherwise the memory only becomes available once its slab has no blocks in use anymore, so the
+ * caller keeps deleting entries in least recently used order until some slab is returned to the system.
+ * @param size_class The size class memory is needed for, which wins ties.
+ */
+static void DeleteEntryFromSpriteCache(uint8 size_class)
 {
-	uint best = UINT_MAX;
-	int cur_lru;
-
-	Debug(sprite, 3, "DeleteEntryFromSpriteCache, inuse={}", GetSpriteCacheUsage());
-
-	cur_lru = 0xffff;
-	for (SpriteID i = 0; i != _spritecache_items; i++) {
-		SpriteCache *sc = GetSpriteCache(i);
-		if (sc->type != ST_RECOLOUR && sc->ptr != nullptr && sc->lru < cur_lru) {
-			cur_lru = sc->lru;
-			best = i;
+	Debug(sprite, 3, "DeleteEntryFromSpriteCache, inuse={}, slabs={}, large={}", GetSpriteCacheUsage(), _sprite_cache_slab_allocated, _sprite_cache_large_allocated);
+
+	uint8 best_class = SPRITE_SIZE_CLASS_LARGE + 1;
+	uint32 best_lru = UINT32_MAX;
+	for (uint8 i = 0; i <= SPRITE_SIZE_CLASS_LARGE; i++) {
+		SpriteID tail = _sprite_lru_lists[i].tail;
+		if (tail == SPRITE_LRU_NONE) continue;
+
+		/* On a tie prefer the requested size class, as that yields a usable block straight away. */
+		uint32 lru = GetSpriteCache(tail)->lru;
+		if (lru < best_lru || (lru == best_lru && i == size_class)) {
+			best_lru = lru;
+			best_class = i;
 		}
 	}
 
 	/* Display an error message and die, in case we found no sprite at all.
 	 * This shouldn't really happen, unless all sprites are locked. */
-	if (best == UINT_MAX) error("Out of sprite memory");
+	if (best_class > SPRITE_SIZE_CLASS_LARGE) error("Out of sprite memory");
 
-	DeleteEntryFromSpriteCache(best);
+	DeleteEntryFromSpriteCache(_sprite_lru_lists[best_class].tail);
 }
 
 static void *AllocSprite(size_t mem_req)
 {
-	mem_req += sizeof(MemBlock);
-
-	/* Align this to correct boundary. This also makes sure at least one
-	 * bit is not used, so we can use it for other things. */
-	mem_req = Align(mem_req, S_FREE_MASK + 1);
-
-	for (;;) {
-		MemBlock *s;
-
-		for (s = _spritecache_ptr; s->size != 0; s = NextBlock(s)) {
-			if (s->size & S_FREE_MASK) {
-				size_t cur_size = s->size & ~S_FREE_MASK;
+	mem_req = Align(mem_req + sizeof(SpriteBlock), sizeof(size_t));
 
-				/* Is the block exactly the size we need or
-				 * big enough for an additional free block? */
-				if (cur_size == mem_req ||
-						cur_size >= mem_req + sizeof(MemBlock)) {
-					/* Set size and in use */
-					s->size = mem_req;
+	uint8 size_class = GetSpriteSizeClass(mem_req);
+	size_t alloc_size = size_class == SPRITE_SIZE_CLASS_LARGE ? mem_req : SPRITE_SLAB_SIZE;
 
-					/* Do we need to inject a free block too? */
-					if (cur_size != mem_req) {
-						NextBlock(s)->size = (cur_size - mem_req) | S_FREE_MASK;
-					}
-
-					return s->data;
-				}
-			}
-		}
+	/* Free some old entries until there is either a free block of the right size or room for a new allocation. */
+	while ((size_class == SPRITE_SIZE_CLASS_LARGE || _sprite_partial_slabs[size_class] == nullptr) &&
+			_sprite_cache_slab_allocated + _sprite_cache_large_allocated + alloc_size > _sprite_cache_budget) {
+		DeleteEntryFromSpriteCache(size_class);
+	}
 
-		/* Reached sentinel, but no block found yet. Delete some old entry. */
-		DeleteEntryFromSpriteCache();
+	SpriteBlock *block;
+	if (size_class == SPRITE_SIZE_CLASS_LARGE) {
+		block = reinterpret_cast<SpriteBlock *>(MallocT<byte>(mem_req));
+		block->slab = nullptr;
+		block->size = (uint32)mem_req;
+		_sprite_cache_large_allocated += mem_req;
+	} else {
+		block = AllocSpriteSlabBlock(size_class);
 	}
+
+	/* The entry using the block is only known, and added to the list of its size class, once the sprite is loaded. */
+	block->sprite = SPRITE_LRU_NONE;
+	_sprite_cache_inuse += block->size;
+	return block->data;
 }
 
 /**
@@ -924,8 +1109,15 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator, S
 		/* Update LRU */
 		sc->lru = ++_sprite_lru_counter;
 
-		/* Load the sprite, if it is not loaded, yet */
-		if (sc->ptr == nullptr) sc->ptr = ReadSprite(sc, sprite, type, AllocSprite, nullptr);
+		if (sc->ptr == nullptr) {
+			/* Load the sprite, if it is not loaded, yet */
+			sc->ptr = ReadSprite(sc, sprite, type, AllocSprite, nullptr);
+			/* Recolour sprites are never evicted. */
+			if (sc->ptr != nullptr && type != ST_RECOLOUR) LinkSpriteLRU(sprite);
+		} else if (GetSpriteBlock(sc->ptr)->sprite == sprite) {
+			UnlinkSpriteLRU(sprite);
+			LinkSpriteLRU(sprite);
+		}
 
 		return sc->ptr;
 	} else {
@@ -937,57 +1129,54 @@ void *GetRawSprite(SpriteID sprite, SpriteType type, AllocatorProc *allocator, S
 
 static void GfxInitSpriteCache()
 {
-	/* initialize sprite cache heap */
+	/* Release all sprites of the previous sprite set. */
+	for (uint i = 0; i != _spritecache_items; i++) {
+		SpriteCache *sc = GetSpriteCache(i);
+		if (sc->ptr != nullptr) DeleteEntryFromSpriteCache(i);
+	}
+	assert(_sprite_cache_slab_allocated == 0 && _sprite_cache_large_allocated == 0);
+	ResetSpriteLRU();
+
 	int bpp = BlitterFactory::GetCurrentBlitter()->GetScreenDepth();
-	uint target_size = (bpp > 0 ? _sprite_cache_size * bpp / 8 : 1) * 1024 * 1024;
+	size_t target_size = (bpp > 0 ? _sprite_cache_size * bpp / 8 : 1) * 1024 * 1024;
 
 	/* Remember 'target_size' from the previous allocation attempt, so we do not try to reach the target_size multiple times in case of failure. */
-	static uint last_alloc_attempt = 0;
-
-	if (_spritecache_ptr == nullptr || (_allocated_sprite_cache_size != target_size && target_size != last_alloc_attempt)) {
-		delete[] reinterpret_cast<byte *>(_spritecache_ptr);
+	static size_t last_alloc_attempt = 0;
 
+	if (_sprite_cache_budget == 0 || (_sprite_cache_budget != target_size && target_size != last_alloc_attempt)) {
 		last_alloc_attempt = target_size;
-		_allocated_sprite_cache_size = target_size;
+		_sprite_cache_budget = target_size;
 
+		/* Slabs are allocated on demand, so check up front that the whole sprite cache can be allocated. */
+		byte *probe;
 		do {
-			try {
-				/* Try to allocate 50% more to make sure we do not allocate almost all available. */
-				_spritecache_ptr = reinterpret_cast<MemBlock *>(new byte[_allocated_sprite_cache_size + _allocated_sprite_cache_size / 2]);
-			} catch (std::bad_alloc &) {
-				_spritecache_ptr = nullptr;
-			}
+			/* Try to allocate 50% more to make sure we do not allocate almost all available. */
+			probe = new (std::nothrow) byte[_sprite_cache_budget + _sprite_cache_budget / 2];
 
-			if (_spritecache_ptr != nullptr) {
-				/* Allocation succeeded, but we wanted less. */
-				delete[] reinterpret_cast<byte *>(_spritecache_ptr);
-				_spritecache_ptr = reinterpret_cast<MemBlock *>(new byte[_allocated_sprite_cache_size]);
-			} else if (_allocated_sprite_cache_size < 2 * 1024 * 1024) {
+			if (probe != nullptr) {
+				delete[] probe;
+			} else if (_sprite_cache_budget < 2 * 1024 * 1024) {
 				usererror("Cannot allocate spritecache");
 			} else {
 				/* Try again to allocate half. */
-				_allocated_sprite_cache_size >>= 1;
+				_sprite_cache_budget >>= 1;
 			}
-		} while (_spritecache_ptr == nullptr);
+		} while (probe == nullptr);
 
-		if (_allocated_sprite_cache_size != target_size) {
-			Debug(misc, 0, "Not enough memory to allocate {} MiB of spritecache. Spritecache was reduced to {} MiB.", target_size / 1024 / 1024, _allocated_sprite_cache_size / 1024 / 1024);
+		if (_sprite_cache_budget != target_size) {
+			Debug(misc, 0, "Not enough memory to allocate {} MiB of spritecache. Spritecache was reduced to {} MiB.", target_size / 1024 / 1024, _sprite_cache_budget / 1024 / 1024);
 
 			ErrorMessageData msg(STR_CONFIG_ERROR_OUT_OF_MEMORY, STR_CONFIG_ERROR_SPRITECACHE_TOO_BIG);
 			msg.SetDParam(0, target_size);
-			msg.SetDParam(1, _allocated_sprite_cache_size);
+			msg.SetDParam(1, _sprite_cache_budget);
 			ScheduleErrorMessage(msg);
 		}
 	}
-
-	/* A big free block */
-	_spritecache_ptr->size = (_allocated_sprite_cache_size - sizeof(MemBlock)) | S_FREE_MASK;
-	/* Sentinel block (identified by size == 0) */
-	NextBlock(_spritecache_ptr)->size = 0;
 }
 
 void GfxInitSpriteMem()
 {
+	CloseSpriteDiskCaches();
 	GfxInitSpriteCache();
 
 	/* Reset the spritecache 'pool' */
@@ -995,7 +1184,6 @@ void GfxInitSpriteMem()
 	_spritecache_items = 0;
 	_spritecache = nullptr;
 
-	_compact_cache_counter = 0;
 	_sprite_files.clear();
 }
 
@@ -1011,6 +1199,9 @@ void GfxClearSpriteCache()
 		if (sc->type != ST_RECOLOUR && sc->ptr != nullptr) DeleteEntryFromSpriteCache(i);
 	}
 
+	/* Sprites will be encoded differently, so the disk caches need to be reopened. */
+	CloseSpriteDiskCaches();
+
 	VideoDriver::GetInstance()->ClearSystemSprites();
 }
 
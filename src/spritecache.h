@@ -23,6 +23,7 @@ struct Sprite {
 };
 
 extern uint _sprite_cache_size;
+extern bool _sprite_disk_cache;
 
 typedef void *AllocatorProc(size_t size);
 
@@ -0,0 +1,562 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * @file spritecache_disk.cpp Persistent cache of blitter-encoded sprites.
+ *
+ * Decoding GRF sprites and encoding them for the blitter is costly, and has to
+ * be done again for every sprite after each start. When enabled, this cache
+ * stores the encoded sprites on disk, one cache file per sprite file and
+ * "context". The context contains everything besides the sprite file that
+ * affects the encoded sprite, e.g. the blitter and the zoom levels.
+ *
+ * Cache files are memory-mapped read-only, so multiple processes can share
+ * them. Newly encoded sprites are collected in memory and written to a new
+ * cache file that atomically replaces the old one.
+ */
+
+#include "stdafx.h"
+#include "spritecache_disk.h"
+#include "blitter/factory.hpp"
+#include "settings_type.h"
+#include "fileio_func.h"
+#include "string_func.h"
+#include "debug.h"
+#include "rev.h"
+#include "newgrf_config.h"
+#include "3rdparty/md5/md5.h"
+
+#if defined(_WIN32)
+#	include <windows.h>
+#elif defined(UNIX)
+#	include <sys/mman.h>
+#	include <sys/stat.h>
+#	include <fcntl.h>
+#	include <unistd.h>
+#endif
+
+#include "safeguards.h"
+
+bool _sprite_disk_cache = false; ///< Whether to use the persistent cache of encoded sprites.
+
+/** Magic at the begin of each sprite disk cache file. */
+static const char SPRITE_DISK_CACHE_MAGIC[8] = { 'O', 'T', 'T', 'D', 'S', 'P', 'R', 'C' };
+/** Version of the sprite disk cache file format. Written in native byte order, so it also rejects files of another endianness. */
+static const uint32 SPRITE_DISK_CACHE_VERSION = 0x00010001;
+/** Amount of newly encoded sprite data of all sprite files together after which cache files are rewritten. */
+static const size_t SPRITE_DISK_CACHE_PENDING_LIMIT = 32 * 1024 * 1024;
+
+static size_t _sprite_disk_cache_pending_size = 0; ///< Total size of the pending sprites of all disk caches.
+
+/** Header of a sprite disk cache file. It is followed by the index and the sprite data. */
+struct SpriteDiskCacheHeader {
+	char magic[8];     ///< Always #SPRITE_DISK_CACHE_MAGIC.
+	uint32 version;    ///< Always #SPRITE_DISK_CACHE_VERSION.
+	uint32 count;      ///< Number of entries in the index.
+	uint8 context[16]; ///< Checksum of the context the sprites were encoded in.
+};
+
+/** Index entry of a sprite in a sprite disk cache file. The index is sorted by position and type. */
+struct SpriteDiskCacheEntry {
+	uint64 file_pos; ///< Position of the sprite, relative to the begin of the sprite file.
+	uint64 offset;   ///< Position of the encoded sprite in the cache file.
+	uint32 size;     ///< Size of the encoded sprite.
+	uint32 type;     ///< SpriteType of the sprite.
+
+	/** Key the index is sorted by. */
+	std::pair<uint64, uint32> Key() const { return { this->file_pos, this->type }; }
+};
+
+static_assert(sizeof(SpriteDiskCacheHeader) == 32);
+static_assert(sizeof(SpriteDiskCacheEntry) == 24);
+
+/** Read-only view of a file; memory-mapped where the platform supports it. */
+class MappedFile {
+	const byte *data = nullptr; ///< Contents of the file.
+	size_t size = 0;            ///< Size of the file.
+#if defined(_WIN32)
+	HANDLE file = INVALID_HANDLE_VALUE; ///< Handle of the opened file.
+	HANDLE mapping = nullptr;           ///< Handle of the file mapping.
+#elif !defined(UNIX)
+	std::unique_ptr<byte[]> buffer;     ///< Copy of the file, if it cannot be mapped.
+#endif
+
+public:
+	~MappedFile()
+	{
+		this->Close();
+	}
+
+	bool Open(const std::string &filename);
+	void Close();
+
+	/**
+	 * Get the contents of the file.
+	 * @return The contents, or \c nullptr when nothing is mapped.
+	 */
+	const byte *GetData() const { return this->data; }
+
+	/**
+	 * Get the size of the file.
+	 * @return The size in bytes.
+	 */
+	size_t GetSize() const { return this->size; }
+};
+
+/**
+ * Map a file into memory.
+ * @param filename Full path of the file.
+ * @return True iff the file could be mapped.
+ */
+bool MappedFile::Open(const std::string &filename)
+{
+	this->Close();
+
+#if defined(_WIN32)
+	this->file = CreateFileW(OTTD2FS(filename).c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (this->file == INVALID_HANDLE_VALUE) return false;
+
+	LARGE_INTEGER size;
+	if (GetFileSizeEx(this->file, &size) && size.QuadPart > 0) {
+		this->mapping = CreateFileMappingW(this->file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (this->mapping != nullptr) {
+			this->data = static_cast<const byte *>(MapViewOfFile(this->mapping, FILE_MAP_READ, 0, 0, 0));
+			this->size = (size_t)size.QuadPart;
+		}
+	}
+#elif defined(UNIX)
+	int fd = open(OTTD2FS(filename).c_str(), O_RDONLY);
+	if (fd < 0) return false;
+
+	struct stat st;
+	if (fstat(fd, &st) == 0 && st.st_size > 0) {
+		void *p = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+		if (p != MAP_FAILED) {
+			this->data = static_cast<const byte *>(p);
+			this->size = (size_t)st.st_size;
+		}
+	}
+	/* The mapping stays valid after closing the file descriptor. */
+	close(fd);
+#else
+	size_t size;
+	FILE *f = FioFOpenFile(filename, "rb", NO_DIRECTORY, &size);
+	if (f == nullptr) return false;
+
+	this->buffer.reset(new byte[size]);
+	if (size > 0 && fread(this->buffer.get(), 1, size, f) == size) {
+		this->data = this->buffer.get();
+		this->size = size;
+	}
+	FioFCloseFile(f);
+#endif
+
+	if (this->data == nullptr) this->Close();
+	return this->data != nullptr;
+}
+
+/** Unmap the file, if any. */
+void MappedFile::Close()
+{
+#if defined(_WIN32)
+	if (this->data != nullptr) UnmapViewOfFile(this->data);
+	if (this->mapping != nullptr) CloseHandle(this->mapping);
+	if (this->file != INVALID_HANDLE_VALUE) CloseHandle(this->file);
+	this->mapping = nullptr;
+	this->file = INVALID_HANDLE_VALUE;
+#elif defined(UNIX)
+	if (this->data != nullptr) munmap(const_cast<byte *>(this->data), this->size);
+#else
+	this->buffer.reset();
+#endif
+	this->data = nullptr;
+	this->size = 0;
+}
+
+/**
+ * Get an identifier of this process, to create unique temporary files.
+ * @return The process identifier.
+ */
+static uint GetProcessIdentifier()
+{
+#if defined(_WIN32)
+	return (uint)GetCurrentProcessId();
+#elif defined(UNIX)
+	return (uint)getpid();
+#else
+	return 0;
+#endif
+}
+
+/**
+ * Replace a file with another one, as atomically as the platform allows.
+ * @param from The file to move.
+ * @param to The file to replace.
+ * @return True iff the file was replaced.
+ */
+static bool ReplaceFile(const std::string &from, const std::string &to)
+{
+#if defined(_WIN32)
+	return MoveFileExW(OTTD2FS(from).c_str(), OTTD2FS(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+	return rename(OTTD2FS(from).c_str(), OTTD2FS(to).c_str()) == 0;
+#endif
+}
+
+/**
+ * Remove a file.
+ * @param filename The file to remove.
+ */
+static void RemoveFile(const std::string &filename)
+{
+#if defined(_WIN32)
+	DeleteFileW(OTTD2FS(filename).c_str());
+#else
+	remove(OTTD2FS(filename).c_str());
+#endif
+}
+
+/**
+ * Get the MD5 sum of a sprite file. For NewGRFs the MD5 sum calculated when
+ * scanning them is used, other files are read completely.
+ * @param file The file to get the MD5 sum of; its position is kept.
+ * @param[out] md5sum The MD5 sum.
+ */
+static void CalcSpriteFileMD5Sum(SpriteFile &file, uint8 md5sum[16])
+{
+	for (const GRFConfig *c = _grfconfig; c != nullptr; c = c->next) {
+		if (c->filename != nullptr && file.GetFilename() == c->filename) {
+			MemCpyT(md5sum, c->ident.md5sum, lengthof(c->ident.md5sum));
+			return;
+		}
+	}
+
+	size_t old_pos = file.GetPos();
+
+	Md5 checksum;
+	std::vector<byte> buffer(64 * 1024);
+	file.SeekTo(file.GetStartPos(), SEEK_SET);
+	for (size_t left = file.GetEndPos() - file.GetStartPos(); left > 0;) {
+		size_t len = std::min(left, buffer.size());
+		file.ReadBlock(buffer.data(), len);
+		checksum.Append(buffer.data(), len);
+		left -= len;
+	}
+	checksum.Finish(md5sum);
+
+	file.SeekTo(old_pos, SEEK_SET);
+}
+
+/**
+ * Calculate the checksum of everything besides the sprite file's contents that affects the encoded sprites.
+ * @param file The sprite file the sprites are loaded from.
+ * @param[out] context The checksum.
+ */
+static void CalcSpriteDiskCacheContext(const SpriteFile &file, uint8 context[16])
+{
+	Md5 checksum;
+	checksum.Append(_openttd_revision, strlen(_openttd_revision));
+	checksum.Append(_openttd_build_date, strlen(_openttd_build_date));
+
+	const char *blitter = BlitterFactory::GetCurrentBlitter()->GetName();
+	checksum.Append(blitter, strlen(blitter));
+
+	uint8 settings[] = {
+		(uint8)_settings_client.gui.zoom_min,
+		(uint8)_settings_client.gui.zoom_max,
+		(uint8)_settings_client.gui.sprite_zoom_min,
+		(uint8)file.NeedsPaletteRemap(),
+	};
+	checksum.Append(settings, sizeof(settings));
+
+	checksum.Finish(context);
+}
+
+/** The disk cache of the encoded sprites of a single sprite file. */
+class SpriteDiskCache {
+	using Key = std::pair<uint64, uint32>;
+
+	std::string directory;           ///< Full path of the directory of the cache file.
+	std::string filename;            ///< Full path of the cache file.
+	const char *blitter;             ///< Name of the blitter the sprites are encoded for.
+	uint8 context[16];               ///< Checksum of the context the sprites are encoded in.
+	size_t file_start;               ///< Start of the sprite file, sprite positions are relative to this.
+
+	MappedFile mapping;                         ///< The mapped cache file.
+	const SpriteDiskCacheEntry *index = nullptr; ///< Index in the mapped cache file.
+	uint32 count = 0;                            ///< Number of entries in the index.
+
+	std::map<Key, std::vector<byte>> pending; ///< Encoded sprites that are not yet written to the cache file.
+	size_t pending_size = 0;                  ///< Total size of the pending sprites.
+
+	void OpenMapping();
+	const SpriteDiskCacheEntry *Find(const Key &key) const;
+
+public:
+	SpriteDiskCache(SpriteFile &file);
+
+	/**
+	 * Get the name of the blitter the sprites of this cache are encoded for.
+	 * @return The name of the blitter.
+	 */
+	const char *GetBlitterName() const { return this->blitter; }
+
+	/**
+	 * Get the size of the sprites that are not yet written to the cache file.
+	 * @return The size in bytes.
+	 */
+	size_t GetPendingSize() const { return this->pending_size; }
+
+	void *Load(size_t file_pos, SpriteType type, AllocatorProc *allocator) const;
+	void Store(size_t file_pos, SpriteType type, const void *data, size_t size);
+	void Flush();
+};
+
+/**
+ * Open the cache for the given sprite file in the current context.
+ * @param file The sprite file.
+ */
+SpriteDiskCache::SpriteDiskCache(SpriteFile &file) : blitter(BlitterFactory::GetCurrentBlitter()->GetName()), file_start(file.GetStartPos())
+{
+	uint8 md5sum[16];
+	CalcSpriteFileMD5Sum(file, md5sum);
+	CalcSpriteDiskCacheContext(file, this->context);
+
+	char buf[64];
+	char *p = md5sumToString(buf, lastof(buf), md5sum);
+	seprintf(p, lastof(buf), "-%02X%02X%02X%02X", this->context[0], this->context[1], this->context[2], this->context[3]);
+	this->directory = FioGetPersonalDirectory(CACHE_DIR);
+	this->filename = this->directory + buf + ".dat";
+
+	this->OpenMapping();
+}
+
+/** (Re)open the cache file, ignoring it when it is invalid or for another context. */
+void SpriteDiskCache::OpenMapping()
+{
+	this->index = nullptr;
+	this->count = 0;
+	if (!this->mapping.Open(this->filename)) return;
+
+	const byte *data = this->mapping.GetData();
+	size_t size = this->mapping.GetSize();
+	const SpriteDiskCacheHeader *header = reinterpret_cast<const SpriteDiskCacheHeader *>(data);
+	const SpriteDiskCacheEntry *index = reinterpret_cast<const SpriteDiskCacheEntry *>(header + 1);
+
+	bool valid = size >= sizeof(*header) &&
+			memcmp(header->magic, SPRITE_DISK_CACHE_MAGIC, sizeof(header->magic)) == 0 &&
+			header->version == SPRITE_DISK_CACHE_VERSION &&
+			memcmp(header->context, this->context, sizeof(this->context)) == 0 &&
+			header->count <= (size - sizeof(*header)) / sizeof(*index);
+
+	for (uint32 i = 0; valid && i < header->count; i++) {
+		valid = index[i].offset <= size && index[i].size <= size - index[i].offset && (i == 0 || index[i - 1].Key() < index[i].Key());
+	}
+
+	if (!valid) {
+		Debug(sprite, 1, "Ignoring invalid sprite disk cache {}", this->filename);
+		this->mapping.Close();
+		return;
+	}
+
+	this->index = index;
+	this->count = header->count;
+	Debug(sprite, 3, "Mapped sprite disk cache {} with {} sprites", this->filename, this->count);
+}
+
+/**
+ * Find a sprite in the index of the mapped cache file.
+ * @param key Position and type of the sprite.
+ * @return The entry, or \c nullptr if it is not cached.
+ */
+const SpriteDiskCacheEntry *SpriteDiskCache::Find(const Key &key) const
+{
+	const SpriteDiskCacheEntry *end = this->index + this->count;
+	const SpriteDiskCacheEntry *entry = std::lower_bound(this->index, end, key, [](const SpriteDiskCacheEntry &e, const Key &k) { return e.Key() < k; });
+	return (entry != end && entry->Key() == key) ? entry : nullptr;
+}
+
+/**
+ * Load an encoded sprite from the cache.
+ * @param file_pos Position of the sprite in the sprite file.
+ * @param type Type of the sprite.
+ * @param allocator Allocator for the sprite data.
+ * @return The sprite data, or \c nullptr if the sprite is not cached.
+ */
+void *SpriteDiskCache::Load(size_t file_pos, SpriteType type, AllocatorProc *allocator) const
+{
+	Key key(file_pos - this->file_start, type);
+
+	const void *src;
+	size_t size;
+	const SpriteDiskCacheEntry *entry = this->Find(key);
+	if (entry != nullptr) {
+		src = this->mapping.GetData() + entry->offset;
+		size = entry->size;
+	} else {
+		auto it = this->pending.find(key);
+		if (it == this->pending.end()) return nullptr;
+		src = it->second.data();
+		size = it->second.size();
+	}
+
+	void *dest = allocator(size);
+	memcpy(dest, src, size);
+	return dest;
+}
+
+/**
+ * Add a newly encoded sprite to the cache.
+ * @param file_pos Position of the sprite in the sprite file.
+ * @param type Type of the sprite.
+ * @param data The encoded sprite.
+ * @param size Size of the encoded sprite.
+ */
+void SpriteDiskCache::Store(size_t file_pos, SpriteType type, const void *data, size_t size)
+{
+	Key key(file_pos - this->file_start, type);
+	if (this->Find(key) != nullptr) return;
+
+	const byte *bytes = static_cast<const byte *>(data);
+	if (!this->pending.emplace(key, std::vector<byte>(bytes, bytes + size)).second) return;
+
+	this->pending_size += size;
+	_sprite_disk_cache_pending_size += size;
+}
+
+/** Write the pending sprites, together with the already cached ones, to a new cache file. */
+void SpriteDiskCache::Flush()
+{
+	if (this->pending.empty()) return;
+
+	/* Merge the index of the current cache file with the pending sprites. */
+	std::vector<std::pair<SpriteDiskCacheEntry, const byte *>> sprites;
+	sprites.reserve(this->count + this->pending.size());
+	for (uint32 i = 0; i < this->count; i++) {
+		sprites.emplace_back(this->index[i], this->mapping.GetData() + this->index[i].offset);
+	}
+	for (const auto &it : this->pending) {
+		SpriteDiskCacheEntry entry = { it.first.first, 0, (uint32)it.second.size(), it.first.second };
+		sprites.emplace_back(entry, it.second.data());
+	}
+	std::sort(sprites.begin(), sprites.end(), [](const auto &a, const auto &b) { return a.first.Key() < b.first.Key(); });
+
+	SpriteDiskCacheHeader header;
+	memcpy(header.magic, SPRITE_DISK_CACHE_MAGIC, sizeof(header.magic));
+	header.version = SPRITE_DISK_CACHE_VERSION;
+	header.count = (uint32)sprites.size();
+	memcpy(header.context, this->context, sizeof(header.context));
+
+	uint64 offset = sizeof(header) + sprites.size() * sizeof(SpriteDiskCacheEntry);
+	for (auto &it : sprites) {
+		it.first.offset = offset;
+		offset += Align(it.first.size, sizeof(uint64));
+	}
+
+	/* The directory is only created once there is something to cache. */
+	FioCreateDirectory(this->directory);
+
+	/* Write to a temporary file first, so other processes never see a partially written cache file. */
+	std::string tmp_filename = this->filename + "." + std::to_string(GetProcessIdentifier()) + ".tmp";
+	FILE *f = FioFOpenFile(tmp_filename, "wb", NO_DIRECTORY);
+	bool success = f != nullptr;
+	if (success) {
+		static const byte padding[sizeof(uint64)] = {};
+		success = fwrite(&header, sizeof(header), 1, f) == 1;
+		for (const auto &it : sprites) {
+			if (success) success = fwrite(&it.first, sizeof(it.first), 1, f) == 1;
+		}
+		for (const auto &it : sprites) {
+			if (!success) break;
+			size_t pad = Align(it.first.size, sizeof(uint64)) - it.first.size;
+			success = fwrite(it.second, 1, it.first.size, f) == it.first.size && fwrite(padding, 1, pad, f) == pad;
+		}
+		success = fclose(f) == 0 && success;
+	}
+
+	/* The old cache file must not be mapped while replacing it on some platforms. */
+	this->mapping.Close();
+	this->index = nullptr;
+	this->count = 0;
+
+	if (success && ReplaceFile(tmp_filename, this->filename)) {
+		Debug(sprite, 3, "Wrote sprite disk cache {} with {} sprites", this->filename, sprites.size());
+	} else {
+		Debug(sprite, 1, "Writing sprite disk cache {} failed", this->filename);
+		if (f != nullptr) RemoveFile(tmp_filename);
+	}
+
+	this->pending.clear();
+	_sprite_disk_cache_pending_size -= this->pending_size;
+	this->pending_size = 0;
+	this->OpenMapping();
+}
+
+/** The disk caches of the currently used sprite files. */
+static std::map<const SpriteFile *, std::unique_ptr<SpriteDiskCache>> _sprite_disk_caches;
+
+/**
+ * Get the disk cache for a sprite file, for sprites encoded by the current blitter.
+ * @param file The sprite file.
+ * @return The disk cache.
+ */
+static SpriteDiskCache *GetSpriteDiskCache(SpriteFile &file)
+{
+	std::unique_ptr<SpriteDiskCache> &cache = _sprite_disk_caches[&file];
+	if (cache != nullptr && strcmp(cache->GetBlitterName(), BlitterFactory::GetCurrentBlitter()->GetName()) != 0) {
+		cache->Flush();
+		cache.reset();
+	}
+	if (cache == nullptr) cache.reset(new SpriteDiskCache(file));
+	return cache.get();
+}
+
+/**
+ * Load a sprite, encoded by the current blitter, from the disk cache.
+ * @param file The sprite file the sprite is in.
+ * @param file_pos Position of the sprite in the sprite file.
+ * @param type Type of the sprite.
+ * @param allocator Allocator for the sprite data.
+ * @return The sprite data, or \c nullptr if the sprite is not cached.
+ */
+void *LoadSpriteFromDiskCache(SpriteFile &file, size_t file_pos, SpriteType type, AllocatorProc *allocator)
+{
+	return GetSpriteDiskCache(file)->Load(file_pos, type, allocator);
+}
+
+/**
+ * Store a sprite that was encoded by the current blitter in the disk cache.
+ * All blitters encode sprites without references to data outside of the encoded sprite, so they can be stored as-is.
+ * @param file The sprite file the sprite is in.
+ * @param file_pos Position of the sprite in the sprite file.
+ * @param type Type of the sprite.
+ * @param data The encoded sprite.
+ * @param size Size of the encoded sprite.
+ */
+void StoreSpriteInDiskCache(SpriteFile &file, size_t file_pos, SpriteType type, const void *data, size_t size)
+{
+	GetSpriteDiskCache(file)->Store(file_pos, type, data, size);
+	if (_sprite_disk_cache_pending_size < SPRITE_DISK_CACHE_PENDING_LIMIT) return;
+
+	/* Write the caches with the most pending sprites first, as every write rewrites the whole cache file. */
+	while (_sprite_disk_cache_pending_size >= SPRITE_DISK_CACHE_PENDING_LIMIT / 2) {
+		SpriteDiskCache *largest = nullptr;
+		for (const auto &it : _sprite_disk_caches) {
+			if (largest == nullptr || it.second->GetPendingSize() > largest->GetPendingSize()) largest = it.second.get();
+		}
+		largest->Flush();
+	}
+}
+
+/** Write all pending sprites to disk and close all disk caches. */
+void CloseSpriteDiskCaches()
+{
+	for (auto &it : _sprite_disk_caches) {
+		it.second->Flush();
+	}
+	_sprite_disk_caches.clear();
+}
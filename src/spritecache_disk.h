@@ -0,0 +1,20 @@
+/*
+ * This file is part of OpenTTD.
+ * OpenTTD is free software; you can redistribute it and/or modify it under the terms of the GNU General Public License as published by the Free Software Foundation, version 2.
+ * OpenTTD is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/** @file spritecache_disk.h Functions for the persistent cache of encoded sprites. */
+
+#ifndef SPRITECACHE_DISK_H
+#define SPRITECACHE_DISK_H
+
+#include "spritecache.h"
+#include "spriteloader/sprite_file_type.hpp"
+
+void *LoadSpriteFromDiskCache(SpriteFile &file, size_t file_pos, SpriteType type, AllocatorProc *allocator);
+void StoreSpriteInDiskCache(SpriteFile &file, size_t file_pos, SpriteType type, const void *data, size_t size);
+void CloseSpriteDiskCaches();
+
+#endif /* SPRITECACHE_DISK_H */
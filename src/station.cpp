@@ -38,6 +38,7 @@ INSTANTIATE_POOL_METHODS(Station)
 
 
 StationKdtree _station_kdtree(Kdtree_StationXYFunc);
+StationCoverage _station_coverage;
 
 void RebuildStationKdtree()
 {
@@ -95,6 +96,7 @@ Station::~Station()
 	while (!this->loading_vehicles.empty()) {
 		this->loading_vehicles.front()->LeaveStation();
 	}
+	UnscheduleStationRating(this);
 
 	for (Aircraft *a : Aircraft::Iterate()) {
 		if (!a->IsNormalAircraft()) continue;
@@ -131,6 +133,7 @@ Station::~Station()
 	}
 
 	/* Remove station from industries and towns that reference it. */
+	this->RemoveCatchment();
 	this->RemoveFromAllNearbyLists();
 
 	/* Clear the persistent storage. */
@@ -207,6 +210,7 @@ void Station::AddFacility(StationFacility new_facility_bit, TileIndex facil_xy)
 	this->facilities |= new_facility_bit;
 	this->owner = _current_company;
 	this->build_date = _date;
+	UpdateStationRatingSchedule(this);
 }
 
 /**
@@ -383,6 +387,24 @@ void Station::RemoveFromAllNearbyLists()
 	for (Industry *i : Industry::Iterate()) { i->stations_near.erase(this); }
 }
 
+/**
+ * Remove the current catchment area from the coverage index, and this station
+ * from the nearby stations lists of the towns and industries within it.
+ * A station is only in the list of a town or industry as long as its
+ * catchment covers a house or industry tile of it, so this reaches all of them.
+ */
+void Station::RemoveCatchment()
+{
+	BitmapTileIterator it(this->catchment_tiles);
+	for (TileIndex tile = it; tile != INVALID_TILE; tile = ++it) {
+		_station_coverage.Remove(tile, this->index);
+
+		if (IsTileType(tile, MP_HOUSE)) Town::GetByTile(tile)->stations_near.erase(this);
+		if (IsTileType(tile, MP_INDUSTRY)) Industry::GetByTile(tile)->stations_near.erase(this);
+	}
+	this->catchment_tiles.Reset();
+}
+
 /**
  * Test if the given town ID is covered by our catchment area.
  * This is used when removing a house tile to determine if it was the last house tile
@@ -406,12 +428,9 @@ bool Station::CatchmentCoversTown(TownID t) const
 void Station::RecomputeCatchment()
 {
 	this->industries_near.clear();
-	this->RemoveFromAllNearbyLists();
+	this->RemoveCatchment();
 
-	if (this->rect.IsEmpty()) {
-		this->catchment_tiles.Reset();
-		return;
-	}
+	if (this->rect.IsEmpty()) return;
 
 	if (!_settings_game.station.serve_neutral_industries && this->industry != nullptr) {
 		/* Station is associated with an industry, so we only need to deliver to that industry. */
@@ -419,6 +438,7 @@ void Station::RecomputeCatchment()
 		for (TileIndex tile : this->industry->location) {
 			if (IsTileType(tile, MP_INDUSTRY) && GetIndustryIndex(tile) == this->industry->index) {
 				this->catchment_tiles.SetTile(tile);
+				_station_coverage.Add(tile, this->index);
 			}
 		}
 		/* The industry's stations_near may have been computed before its neutral station was built so clear and re-add here. */
@@ -449,6 +469,8 @@ void Station::RecomputeCatchment()
 	/* Search catchment tiles for towns and industries */
 	BitmapTileIterator it(this->catchment_tiles);
 	for (TileIndex tile = it; tile != INVALID_TILE; tile = ++it) {
+		_station_coverage.Add(tile, this->index);
+
 		if (IsTileType(tile, MP_HOUSE)) {
 			Town *t = Town::GetByTile(tile);
 			t->stations_near.insert(this);
@@ -467,6 +489,52 @@ void Station::RecomputeCatchment()
 	}
 }
 
+/** Empty the coverage index and size it for the current map. */
+void StationCoverage::Reset()
+{
+	this->first.assign(MapSize(), 0);
+	this->entries.clear();
+	this->free_entries = 0;
+}
+
+/**
+ * Add a station to the stations covering a tile.
+ * @param tile Tile that became covered.
+ * @param station Station covering it.
+ */
+void StationCoverage::Add(TileIndex tile, StationID station)
+{
+	uint32 i = this->free_entries;
+	if (i != 0) {
+		this->free_entries = this->entries[i - 1].next;
+	} else {
+		this->entries.emplace_back();
+		i = (uint32)this->entries.size();
+	}
+
+	this->entries[i - 1] = { station, this->first[tile] };
+	this->first[tile] = i;
+}
+
+/**
+ * Remove a station from the stations covering a tile.
+ * @param tile Tile that is no longer covered.
+ * @param station Station that covered it.
+ */
+void StationCoverage::Remove(TileIndex tile, StationID station)
+{
+	for (uint32 *link = &this->first[tile]; *link != 0; link = &this->entries[*link - 1].next) {
+		uint32 i = *link;
+		if (this->entries[i - 1].station != station) continue;
+
+		*link = this->entries[i - 1].next;
+		this->entries[i - 1].next = this->free_entries;
+		this->free_entries = i;
+		return;
+	}
+	NOT_REACHED();
+}
+
 /**
  * Recomputes catchment of all stations.
  * This will additionally recompute nearby stations for all towns and industries.
@@ -18,8 +18,11 @@
 #include "linkgraph/linkgraph_type.h"
 #include "newgrf_storage.h"
 #include "bitmap_type.h"
+#include <list>
 #include <map>
 #include <set>
+#include <vector>
+#include <algorithm>
 
 typedef Pool<BaseStation, StationID, 32, 64000> StationPool;
 extern StationPool _station_pool;
@@ -35,7 +38,12 @@ static const byte INITIAL_STATION_RATING = 175;
  */
 class FlowStat {
 public:
-	typedef std::map<uint32, StationID> SharesMap;
+	/**
+	 * Shares of flow as pairs of cumulative flow and station, sorted by the
+	 * cumulative flow. A flat array is a lot faster to search and copy than a
+	 * map for the handful of next hops a flow usually has.
+	 */
+	typedef std::vector<std::pair<uint32, StationID>> SharesMap;
 
 	static const SharesMap empty_sharesmap;
 
@@ -55,7 +63,7 @@ public:
 	inline FlowStat(StationID st, uint flow, bool restricted = false)
 	{
 		assert(flow > 0);
-		this->shares[flow] = st;
+		this->shares.emplace_back(flow, st);
 		this->unrestricted = restricted ? 0 : flow;
 	}
 
@@ -70,7 +78,7 @@ public:
 	inline void AppendShare(StationID st, uint flow, bool restricted = false)
 	{
 		assert(flow > 0);
-		this->shares[(--this->shares.end())->first + flow] = st;
+		this->shares.emplace_back(this->shares.back().first + flow, st);
 		if (!restricted) this->unrestricted += flow;
 	}
 
@@ -111,7 +119,7 @@ public:
 	/**
 	 * Get a station a package can be routed to. This done by drawing a
 	 * random number between 0 and sum_shares and then looking that up in
-	 * the map with lower_bound. So each share gets selected with a
+	 * the shares with UpperBound. So each share gets selected with a
 	 * probability dependent on its flow. Do include restricted flows here.
 	 * @param is_restricted Output if a restricted flow was chosen.
 	 * @return A station ID from the shares map.
@@ -119,15 +127,15 @@ public:
 	inline StationID GetViaWithRestricted(bool &is_restricted) const
 	{
 		assert(!this->shares.empty());
-		uint rand = RandomRange((--this->shares.end())->first);
+		uint rand = RandomRange(this->shares.back().first);
 		is_restricted = rand >= this->unrestricted;
-		return this->shares.upper_bound(rand)->second;
+		return this->UpperBound(rand)->second;
 	}
 
 	/**
 	 * Get a station a package can be routed to. This done by drawing a
 	 * random number between 0 and sum_shares and then looking that up in
-	 * the map with lower_bound. So each share gets selected with a
+	 * the shares with UpperBound. So each share gets selected with a
 	 * probability dependent on its flow. Don't include restricted flows.
 	 * @return A station ID from the shares map.
 	 */
@@ -135,7 +143,7 @@ public:
 	{
 		assert(!this->shares.empty());
 		return this->unrestricted > 0 ?
-				this->shares.upper_bound(RandomRange(this->unrestricted))->second :
+				this->UpperBound(RandomRange(this->unrestricted))->second :
 				INVALID_STATION;
 	}
 
@@ -144,6 +152,17 @@ public:
 	void Invalidate();
 
 private:
+	/**
+	 * Find the first share with a cumulative flow greater than the given one.
+	 * @param flow Cumulative flow to look up.
+	 * @return Iterator to the share, or end() if there is none.
+	 */
+	inline SharesMap::const_iterator UpperBound(uint32 flow) const
+	{
+		return std::upper_bound(this->shares.begin(), this->shares.end(), flow,
+				[](uint32 flow, const SharesMap::value_type &share) { return flow < share.first; });
+	}
+
 	SharesMap shares;  ///< Shares of flow to be sent via specified station (or consumed locally).
 	uint unrestricted; ///< Limit for unrestricted shares.
 };
@@ -476,6 +495,8 @@ public:
 
 	byte last_vehicle_type;
 	std::list<Vehicle *> loading_vehicles;
+	uint64 rating_due;            ///< NOSAVE: Station tick at which the rating is updated next, or 0 if not scheduled.
+	CargoTypes rating_cargoes;    ///< NOSAVE: Cargo types whose rating may change in the next rating update; a superset of those with a rating or a rating below the initial one.
 	GoodsEntry goods[NUM_CARGO];  ///< Goods at this station
 	CargoTypes always_accepted;       ///< Bitmask of always accepted cargo types (by houses, HQs, industry tiles when industry doesn't accept cargo)
 
@@ -505,6 +526,7 @@ public:
 	bool CatchmentCoversTown(TownID t) const;
 	void AddIndustryToDeliver(Industry *ind);
 	void RemoveFromAllNearbyLists();
+	void RemoveCatchment();
 
 	inline bool TileIsInCatchment(TileIndex tile) const
 	{
@@ -558,6 +580,44 @@ public:
 
 void RebuildStationKdtree();
 
+/**
+ * Map-wide index of the stations whose catchment covers a tile.
+ * It mirrors the catchment_tiles of all stations and is kept up to date by
+ * Station::RecomputeCatchment, so lookups don't need to scan the area
+ * around a tile for stations.
+ */
+class StationCoverage {
+	/** A station covering a tile. */
+	struct Entry {
+		StationID station; ///< Station covering the tile.
+		uint32 next;       ///< Index of the next entry of the same tile plus one, or 0 for the last one.
+	};
+
+	std::vector<uint32> first;  ///< Index of the first entry of each tile plus one, or 0 if no station covers the tile.
+	std::vector<Entry> entries; ///< Entries of all tiles, including unused ones.
+	uint32 free_entries = 0;    ///< Index of the first unused entry plus one, or 0 if there are none.
+
+public:
+	void Reset();
+	void Add(TileIndex tile, StationID station);
+	void Remove(TileIndex tile, StationID station);
+
+	/**
+	 * Call a function for all stations covering a tile, in no particular order.
+	 * @param tile Tile to look up.
+	 * @param func Function to call with the StationID.
+	 */
+	template <typename Func>
+	void Iterate(TileIndex tile, Func func) const
+	{
+		for (uint32 i = this->first[tile]; i != 0; i = this->entries[i - 1].next) {
+			func(this->entries[i - 1].station);
+		}
+	}
+};
+
+extern StationCoverage _station_coverage;
+
 /**
  * Call a function on all stations that have any part of the requested area within their catchment.
  * @tparam Func The type of funcion to call
@@ -568,20 +628,14 @@ void RebuildStationKdtree();
 template<typename Func>
 void ForAllStationsAroundTiles(const TileArea &ta, Func func)
 {
-	/* Not using, or don't have a nearby stations list, so we need to scan. */
+	/* Collect the stations covering any of the tiles, in index order. */
 	std::set<StationID> seen_stations;
-
-	/* Scan an area around the building covering the maximum possible station
-	 * to find the possible nearby stations. */
-	uint max_c = _settings_game.station.modified_catchment ? MAX_CATCHMENT : CA_UNMODIFIED;
-	TileArea ta_ext = TileArea(ta).Expand(max_c);
-	for (TileIndex tile : ta_ext) {
-		if (IsTileType(tile, MP_STATION)) seen_stations.insert(GetStationIndex(tile));
+	for (TileIndex tile : ta) {
+		_station_coverage.Iterate(tile, [&seen_stations](StationID station) { seen_stations.insert(station); });
 	}
 
 	for (StationID stationid : seen_stations) {
-		Station *st = Station::GetIfValid(stationid);
-		if (st == nullptr) continue; /* Waypoint */
+		Station *st = Station::Get(stationid);
 
 		/* Check if station is attached to an industry */
 		if (!_settings_game.station.serve_neutral_industries && st->industry != nullptr) continue;
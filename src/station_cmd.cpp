@@ -56,6 +56,8 @@
 #include "linkgraph/refresh.h"
 #include "widgets/station_widget.h"
 #include "tunnelbridge_map.h"
+#include "core/timer_wheel.hpp"
+#include "profile_probe.h"
 
 #include "table/strings.h"
 
@@ -726,6 +728,7 @@ static CommandCost BuildStationPart(Station **st, DoCommandFlag flags, bool reus
 static void DeleteStationIfEmpty(BaseStation *st)
 {
 	if (!st->IsInUse()) {
+		if (Station::IsExpected(st)) UnscheduleStationRating(Station::From(st));
 		st->delete_ctr = 0;
 		InvalidateWindowData(WC_STATION_LIST, st->owner, 0);
 	}
@@ -3459,15 +3462,35 @@ static void TruncateCargo(const CargoSpec *cs, GoodsEntry *ge, uint amount = UIN
 	}
 }
 
+/** Probe for profiling UpdateStationRating. */
+static ProfileProbe _probe_update_station_rating("UpdateStationRating");
+
 static void UpdateStationRating(Station *st)
 {
+	ProfileScope profile(_probe_update_station_rating);
+
 	bool waiting_changed = false;
 
 	byte_inc_sat(&st->time_since_load);
 	byte_inc_sat(&st->time_since_unload);
 
-	for (const CargoSpec *cs : CargoSpec::Iterate()) {
-		GoodsEntry *ge = &st->goods[cs->Index()];
+	/* These bonuses are the same for all cargo types. */
+	const int statue_rating = (Company::IsValidID(st->owner) && HasBit(st->town->statues, st->owner)) ? 26 : 0;
+	const bool last_vehicle_ship = st->last_vehicle_type == VEH_SHIP;
+
+	/* Only visit the cargo types that can have their rating changed, in the
+	 * same order as iterating all cargo specs would. */
+	CargoID c;
+	FOR_EACH_SET_BIT_EX(CargoID, c, CargoTypes, st->rating_cargoes & _cargo_mask) {
+		const CargoSpec *cs = CargoSpec::Get(c);
+		GoodsEntry *ge = &st->goods[c];
+
+		if (!ge->HasRating() && ge->rating >= INITIAL_STATION_RATING) {
+			/* Nothing changes until the cargo gets a rating again. */
+			ClrBit(st->rating_cargoes, c);
+			continue;
+		}
+
 		/* Slowly increase the rating back to its original level in the case we
 		 *  didn't deliver cargo yet to this station. This happens when a bribe
 		 *  failed while you didn't moved that cargo yet to a station. */
@@ -3530,7 +3553,7 @@ static void UpdateStationRating(Station *st)
 				if (b >= 0) rating += b >> 2;
 
 				byte waittime = ge->time_since_pickup;
-				if (st->last_vehicle_type == VEH_SHIP) waittime >>= 2;
+				if (last_vehicle_ship) waittime >>= 2;
 				if (waittime <= 21) rating += 25;
 				if (waittime <= 12) rating += 25;
 				if (waittime <= 6) rating += 45;
@@ -3544,7 +3567,7 @@ static void UpdateStationRating(Station *st)
 				if (ge->max_waiting_cargo <= 100) rating += 10;
 			}
 
-			if (Company::IsValidID(st->owner) && HasBit(st->town->statues, st->owner)) rating += 26;
+			rating += statue_rating;
 
 			byte age = ge->last_age;
 			if (age < 3) rating += 10;
@@ -3639,6 +3662,9 @@ void RerouteCargo(Station *st, CargoID c, StationID avoid, StationID avoid2)
 	}
 }
 
+/** Probe for profiling DeleteStaleLinks. */
+static ProfileProbe _probe_delete_stale_links("DeleteStaleLinks");
+
 /**
  * Check all next hops of cargo packets in this station for existence of a
  * a valid link they may use to travel on. Reroute any cargo not having a valid
@@ -3649,6 +3675,8 @@ void RerouteCargo(Station *st, CargoID c, StationID avoid, StationID avoid2)
  */
 void DeleteStaleLinks(Station *from)
 {
+	ProfileScope profile(_probe_delete_stale_links);
+
 	for (CargoID c = 0; c < NUM_CARGO; ++c) {
 		const bool auto_distributed = (_settings_game.linkgraph.GetDistributionType(c) != DT_MANUAL);
 		GoodsEntry &ge = from->goods[c];
@@ -3806,24 +3834,144 @@ void IncreaseStats(Station *st, const Vehicle *front, StationID next_station_id)
 	}
 }
 
-/* called for every station each tick */
-static void StationHandleSmallTick(BaseStation *st)
+/**
+ * Stations in use count their delete_ctr up every tick and update their rating
+ * when it wraps. Rather than doing that for every station every tick, the
+ * stations are scheduled for the tick their counter wraps.
+ */
+static TimerWheel<StationID, STATION_RATING_TICKS> _station_rating_wheel;
+/** Stations with vehicles loading or unloading, in index order. */
+std::set<StationID> _loading_stations;
+
+/**
+ * Schedule the rating update of a station based on its delete_ctr.
+ * @param st Station to schedule.
+ */
+static void ScheduleStationRating(Station *st)
+{
+	assert(st->rating_due == 0);
+	/* The counter is incremented before checking for the wrap, so a counter of
+	 * STATION_RATING_TICKS - 1 or higher wraps in the next tick. */
+	st->rating_due = _station_rating_wheel.Now() + std::max(1, STATION_RATING_TICKS - st->delete_ctr);
+	_station_rating_wheel.Schedule(st->index, st->rating_due);
+}
+
+/**
+ * Remove a station from the rating schedule, writing back the delete_ctr it
+ * would have had if it was counted every tick.
+ * @param st Station to unschedule.
+ */
+void UnscheduleStationRating(Station *st)
+{
+	if (st->rating_due == 0) return;
+
+	st->delete_ctr = STATION_RATING_TICKS - (st->rating_due - _station_rating_wheel.Now());
+	_station_rating_wheel.Unschedule(st->index, st->rating_due);
+	st->rating_due = 0;
+}
+
+/**
+ * Make sure a station is scheduled for rating updates if and only if it is in use.
+ * This has to be called whenever facilities are added to or removed from a station.
+ * @param st Station that might have changed.
+ */
+void UpdateStationRatingSchedule(Station *st)
+{
+	if (st->IsInUse()) {
+		if (st->rating_due == 0) ScheduleStationRating(st);
+	} else {
+		UnscheduleStationRating(st);
+	}
+}
+
+/** Write back the delete_ctr of all stations in use, e.g. for saving. */
+void SyncStationDeleteCounters()
+{
+	for (Station *st : Station::Iterate()) {
+		if (st->rating_due != 0) st->delete_ctr = STATION_RATING_TICKS - (st->rating_due - _station_rating_wheel.Now());
+	}
+}
+
+/**
+ * Keep track of whether a station has vehicles loading or unloading.
+ * This has to be called whenever vehicles are added to or removed from its loading_vehicles.
+ * @param st Station that might have changed.
+ */
+void UpdateLoadingStation(Station *st)
+{
+	if (st->loading_vehicles.empty()) {
+		_loading_stations.erase(st->index);
+	} else {
+		_loading_stations.insert(st->index);
+	}
+}
+
+/** Rebuild the rating schedule and the set of loading stations from scratch, e.g. after loading a game. */
+void RebuildStationSchedules()
 {
-	if ((st->facilities & FACIL_WAYPOINT) != 0 || !st->IsInUse()) return;
+	_station_rating_wheel.Clear();
+	_loading_stations.clear();
 
-	byte b = st->delete_ctr + 1;
-	if (b >= STATION_RATING_TICKS) b = 0;
-	st->delete_ctr = b;
+	for (Station *st : Station::Iterate()) {
+		/* Start out pessimistic; the rating update drops the cargo types that don't change. */
+		st->rating_cargoes = ALL_CARGOTYPES;
+		st->rating_due = 0;
+		UpdateStationRatingSchedule(st);
+		UpdateLoadingStation(st);
+	}
+}
 
-	if (b == 0) UpdateStationRating(Station::From(st));
+/** Forget about all scheduled stations and the catchment coverage. */
+void InitializeStations()
+{
+	_station_coverage.Reset();
+	_station_rating_wheel.Clear();
+	_loading_stations.clear();
 }
 
+/**
+ * Add the stations with an index matching the periodic trigger to the list.
+ * @param due List to add the station indices to.
+ * @param period Period of the trigger.
+ */
+static void AddStationsDue(std::vector<StationID> &due, uint period)
+{
+	/* The trigger runs if (_tick_counter + st->index) % period == 0. */
+	for (size_t index = (period - _tick_counter % period) % period; index < BaseStation::GetPoolSize(); index += period) {
+		due.push_back((StationID)index);
+	}
+}
+
+/** Probe for profiling OnTick_Station. */
+static ProfileProbe _probe_on_tick_station("OnTick_Station");
+
 void OnTick_Station()
 {
+	ProfileScope profile(_probe_on_tick_station);
+
 	if (_game_mode == GM_EDITOR) return;
 
-	for (BaseStation *st : BaseStation::Iterate()) {
-		StationHandleSmallTick(st);
+	/* Collect all stations that have something to do in this tick. They are
+	 * handled in index order, like it was done when scanning all of them. */
+	static std::vector<StationID> due;
+	_station_rating_wheel.Advance(due);
+	AddStationsDue(due, STATION_LINKGRAPH_TICKS);
+	AddStationsDue(due, STATION_ACCEPTANCE_TICKS);
+	std::sort(due.begin(), due.end());
+	due.erase(std::unique(due.begin(), due.end()), due.end());
+
+	for (StationID index : due) {
+		BaseStation *st = BaseStation::GetIfValid(index);
+		if (st == nullptr) continue;
+
+		if (Station::IsExpected(st) && Station::From(st)->rating_due == _station_rating_wheel.Now()) {
+			/* The delete counter wrapped; schedule the next round. */
+			Station *station = Station::From(st);
+			station->delete_ctr = 0;
+			station->rating_due += STATION_RATING_TICKS;
+			_station_rating_wheel.Schedule(station->index, station->rating_due);
+			UpdateStationRating(station);
+		}
 
 		/* Clean up the link graph about once a week. */
 		if (Station::IsExpected(st) && (_tick_counter + st->index) % STATION_LINKGRAPH_TICKS == 0) {
@@ -3864,6 +4012,8 @@ void ModifyStationRatingAround(TileIndex tile, Owner owner, int amount, uint rad
 
 				if (ge->status != 0) {
 					ge->rating = Clamp(ge->rating + amount, 0, 255);
+					/* Let the rating drift back from its new value. */
+					SetBit(st->rating_cargoes, i);
 				}
 			}
 		}
@@ -3904,6 +4054,7 @@ static uint UpdateStationWaiting(Station *st, CargoID type, uint amount, SourceT
 	if (!ge.HasRating()) {
 		InvalidateWindowData(WC_STATION_LIST, st->index);
 		SetBit(ge.status, GoodsEntry::GES_RATING);
+		SetBit(st->rating_cargoes, type);
 	}
 
 	TriggerStationRandomisation(st, st->xy, SRT_NEW_CARGO, type);
@@ -3965,9 +4116,10 @@ CommandCost CmdRenameStation(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 
 static void AddNearbyStationsByCatchment(TileIndex tile, StationList *stations, StationList &nearby)
 {
-	for (Station *st : nearby) {
-		if (st->TileIsInCatchment(tile)) stations->insert(st);
-	}
+	_station_coverage.Iterate(tile, [&](StationID station) {
+		Station *st = Station::Get(station);
+		if (nearby.find(st) != nearby.end()) stations->insert(st);
+	});
 }
 
 /**
@@ -4014,11 +4166,17 @@ static bool CanMoveGoodsToStation(const Station *st, CargoID type)
 	return true;
 }
 
+/** Probe for profiling MoveGoodsToStation. */
+static ProfileProbe _probe_move_goods_to_station("MoveGoodsToStation");
+
 uint MoveGoodsToStation(CargoID type, uint amount, SourceType source_type, SourceID source_id, const StationList *all_stations, Owner exclusivity)
 {
+	ProfileScope profile(_probe_move_goods_to_station);
+
 	/* Return if nothing to do. Also the rounding below fails for 0. */
 	if (all_stations->empty()) return 0;
 	if (amount == 0) return 0;
+	_probe_move_goods_to_station.Count(amount);
 
 	Station *first_station = nullptr;
 	typedef std::pair<Station *, uint> StationInfo;
@@ -4151,6 +4309,7 @@ void BuildOilRig(TileIndex tile)
 	st->ship_station.Add(tile);
 	st->facilities = FACIL_AIRPORT | FACIL_DOCK;
 	st->build_date = _date;
+	UpdateStationRatingSchedule(st);
 	UpdateStationDockingTiles(st);
 
 	st->rect.BeforeAddTile(tile, StationRect::ADD_FORCE);
@@ -4394,7 +4553,7 @@ StationID FlowStat::GetVia(StationID excluded, StationID excluded2) const
 {
 	if (this->unrestricted == 0) return INVALID_STATION;
 	assert(!this->shares.empty());
-	SharesMap::const_iterator it = this->shares.upper_bound(RandomRange(this->unrestricted));
+	SharesMap::const_iterator it = this->UpperBound(RandomRange(this->unrestricted));
 	assert(it != this->shares.end() && it->first <= this->unrestricted);
 	if (it->second != excluded && it->second != excluded2) return it->second;
 
@@ -4407,8 +4566,8 @@ StationID FlowStat::GetVia(StationID excluded, StationID excluded2) const
 	if (interval >= this->unrestricted) return INVALID_STATION; // Only one station in the map.
 	uint new_max = this->unrestricted - interval;
 	uint rand = RandomRange(new_max);
-	SharesMap::const_iterator it2 = (rand < begin) ? this->shares.upper_bound(rand) :
-			this->shares.upper_bound(rand + interval);
+	SharesMap::const_iterator it2 = (rand < begin) ? this->UpperBound(rand) :
+			this->UpperBound(rand + interval);
 	assert(it2 != this->shares.end() && it2->first <= this->unrestricted);
 	if (it2->second != excluded && it2->second != excluded2) return it2->second;
 
@@ -4426,13 +4585,13 @@ StationID FlowStat::GetVia(StationID excluded, StationID excluded2) const
 		Swap(interval, interval2);
 	}
 	rand = RandomRange(new_max);
-	SharesMap::const_iterator it3 = this->shares.upper_bound(this->unrestricted);
+	SharesMap::const_iterator it3 = this->UpperBound(this->unrestricted);
 	if (rand < begin) {
-		it3 = this->shares.upper_bound(rand);
+		it3 = this->UpperBound(rand);
 	} else if (rand < begin2 - interval) {
-		it3 = this->shares.upper_bound(rand + interval);
+		it3 = this->UpperBound(rand + interval);
 	} else {
-		it3 = this->shares.upper_bound(rand + interval + interval2);
+		it3 = this->UpperBound(rand + interval + interval2);
 	}
 	assert(it3 != this->shares.end() && it3->first <= this->unrestricted);
 	return it3->second;
@@ -4449,11 +4608,11 @@ void FlowStat::Invalidate()
 	SharesMap new_shares;
 	uint i = 0;
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
-		new_shares[++i] = it->second;
+		new_shares.emplace_back(++i, it->second);
 		if (it->first == this->unrestricted) this->unrestricted = i;
 	}
 	this->shares.swap(new_shares);
-	assert(!this->shares.empty() && this->unrestricted <= (--this->shares.end())->first);
+	assert(!this->shares.empty() && this->unrestricted <= this->shares.back().first);
 }
 
 /**
@@ -4493,11 +4652,11 @@ void FlowStat::ChangeShare(StationID st, int flow)
 			 * removed. */
 			flow = 0;
 		}
-		new_shares[it->first + added_shares - removed_shares] = it->second;
+		new_shares.emplace_back(it->first + added_shares - removed_shares, it->second);
 		last_share = it->first;
 	}
 	if (flow > 0) {
-		new_shares[last_share + (uint)flow] = st;
+		new_shares.emplace_back(last_share + (uint)flow, st);
 		if (this->unrestricted < last_share) {
 			this->ReleaseShare(st);
 		} else {
@@ -4525,15 +4684,15 @@ void FlowStat::RestrictShare(StationID st)
 				flow = it->first - last_share;
 				this->unrestricted -= flow;
 			} else {
-				new_shares[it->first] = it->second;
+				new_shares.emplace_back(it->first, it->second);
 			}
 		} else {
-			new_shares[it->first - flow] = it->second;
+			new_shares.emplace_back(it->first - flow, it->second);
 		}
 		last_share = it->first;
 	}
 	if (flow == 0) return;
-	new_shares[last_share + flow] = st;
+	new_shares.emplace_back(last_share + flow, st);
 	this->shares.swap(new_shares);
 	assert(!this->shares.empty());
 }
@@ -4563,10 +4722,10 @@ void FlowStat::ReleaseShare(StationID st)
 	}
 	if (flow == 0) return;
 	SharesMap new_shares;
-	new_shares[flow] = st;
+	new_shares.emplace_back(flow, st);
 	for (SharesMap::iterator it(this->shares.begin()); it != this->shares.end(); ++it) {
 		if (it->second != st) {
-			new_shares[flow + it->first] = it->second;
+			new_shares.emplace_back(flow + it->first, it->second);
 		} else {
 			flow = 0;
 		}
@@ -4587,7 +4746,7 @@ void FlowStat::ScaleToMonthly(uint runtime)
 	uint share = 0;
 	for (SharesMap::iterator i = this->shares.begin(); i != this->shares.end(); ++i) {
 		share = std::max(share + 1, i->first * 30 / runtime);
-		new_shares[share] = i->second;
+		new_shares.emplace_back(share, i->second);
 		if (this->unrestricted == i->first) this->unrestricted = share;
 	}
 	this->shares.swap(new_shares);
@@ -16,6 +16,7 @@
 #include "object_base.h"
 #include "company_base.h"
 #include "company_func.h"
+#include "map_region_func.h"
 
 #include "table/strings.h"
 
@@ -322,6 +323,8 @@ CommandCost CmdTerraformLand(TileIndex tile, DoCommandFlag flags, uint32 p1, uin
 			int height = it->second;
 
 			SetTileHeight(t, (uint)height);
+			/* The height of a corner changes the slope of all four tiles around it. */
+			InvalidateRoadRegionsAroundCorner(t);
 		}
 
 		if (c != nullptr) c->terraform_limit -= (uint32)ts.tile_to_new_height.size() << 16;
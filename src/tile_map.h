@@ -14,6 +14,7 @@
 #include "map_func.h"
 #include "core/bitmath_func.hpp"
 #include "settings_type.h"
+#include "map_region_func.h"
 
 /**
  * Returns the height of a tile
@@ -135,7 +136,11 @@ static inline void SetTileType(TileIndex tile, TileType type)
 	 * edges of the map. If _settings_game.construction.freeform_edges is true,
 	 * the upper edges of the map are also VOID tiles. */
 	assert(IsInnerTile(tile) == (type != MP_VOID));
+	TileType old_type = GetTileType(tile);
 	SB(_m[tile].type, 4, 4, type);
+	/* Tiles are always rebuilt through here when their water tracks change, which keeps the water regions up to date; see water_map.h. */
+	InvalidateWaterRegion(tile);
+	if (IsRoadRegionTileType(old_type) || IsRoadRegionTileType(type)) InvalidateRoadRegion(tile);
 }
 
 /**
@@ -202,6 +207,8 @@ static inline void SetTileOwner(TileIndex tile, Owner owner)
 	assert(!IsTileType(tile, MP_INDUSTRY));
 
 	SB(_m[tile].m1, 0, 5, owner);
+	/* Road vehicles may not enter depots of other companies. */
+	if (IsRoadRegionTileType(GetTileType(tile))) InvalidateRoadRegion(tile);
 }
 
 /**
@@ -84,8 +84,9 @@ struct Town : TownPool::PoolItem<&_town_pool> {
 
 	uint16 time_until_rebuild;       ///< time until we rebuild a house
 
-	uint16 grow_counter;             ///< counter to count when to grow, value is smaller than or equal to growth_rate
+	uint16 grow_counter;             ///< counter to count when to grow, value is smaller than or equal to growth_rate; only up to date while the town is not scheduled, see GetGrowCounter()
 	uint16 growth_rate;              ///< town growth rate
+	uint64 grow_due;                 ///< NOSAVE: Town tick at which the town grows next, or 0 if not scheduled.
 
 	byte fund_buildings_months;      ///< fund buildings program in action?
 	byte road_build_months;          ///< fund road reconstruction in action?
@@ -122,6 +123,8 @@ struct Town : TownPool::PoolItem<&_town_pool> {
 		return (this->cache.population / _settings_game.economy.town_noise_population[_settings_game.difficulty.town_council_tolerance]) + 3;
 	}
 
+	uint16 GetGrowCounter() const;
+
 	void UpdateVirtCoord();
 
 	inline const char *GetCachedName() const
@@ -151,6 +154,8 @@ void ShowTownViewWindow(TownID town);
 void ExpandTown(Town *t);
 
 void RebuildTownKdtree();
+void SyncTownGrowCounters();
+void RebuildTownGrowthSchedule();
 
 
 /**
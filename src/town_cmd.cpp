@@ -43,6 +43,7 @@
 #include "townname_func.h"
 #include "core/random_func.hpp"
 #include "core/backup_type.hpp"
+#include "core/timer_wheel.hpp"
 #include "depot_base.h"
 #include "object_map.h"
 #include "object_base.h"
@@ -63,6 +64,13 @@ INSTANTIATE_POOL_METHODS(Town)
 
 TownKdtree _town_kdtree(&Kdtree_TownXYFunc);
 
+/**
+ * Growing towns count their grow_counter down every tick and grow when it
+ * runs out. Rather than doing that for every town every tick, the towns are
+ * scheduled for the tick their counter runs out.
+ */
+static TimerWheel<TownID, 256> _town_growth_wheel;
+
 void RebuildTownKdtree()
 {
 	std::vector<TownID> townids;
@@ -102,6 +110,8 @@ Town::~Town()
 {
 	if (CleaningPool()) return;
 
+	if (this->grow_due != 0) _town_growth_wheel.Unschedule(this->index, this->grow_due);
+
 	/* Delete town authority window
 	 * and remove from list of sorted towns */
 	CloseWindowById(WC_TOWN_VIEW, this->index);
@@ -810,28 +820,101 @@ static void ChangeTileOwner_Town(TileIndex tile, Owner old_owner, Owner new_owne
 
 static bool GrowTown(Town *t);
 
+/**
+ * Get the grow counter of a town as if it was counted down every tick.
+ * @return Number of ticks until the town grows next.
+ */
+uint16 Town::GetGrowCounter() const
+{
+	if (this->grow_due == 0) return this->grow_counter;
+	return (uint16)(this->grow_due - _town_growth_wheel.Now() - 1);
+}
+
+/**
+ * Schedule the growth of a town based on its grow_counter, if it is growing.
+ * @param t Town to schedule.
+ */
+static void ScheduleTownGrowth(Town *t)
+{
+	if (t->grow_due != 0 || !HasBit(t->flags, TOWN_IS_GROWING)) return;
+
+	/* The counter is decremented before checking whether it ran out, so
+	 * the town grows in the tick after the counter reaches 0. */
+	t->grow_due = _town_growth_wheel.Now() + t->grow_counter + 1;
+	_town_growth_wheel.Schedule(t->index, t->grow_due);
+}
+
+/**
+ * Remove a town from the growth schedule, writing back the grow_counter it
+ * would have had if it was counted down every tick.
+ * This has to be called before changing the grow_counter or the growing state of a town.
+ * @param t Town to unschedule.
+ */
+static void UnscheduleTownGrowth(Town *t)
+{
+	if (t->grow_due == 0) return;
+
+	t->grow_counter = t->GetGrowCounter();
+	_town_growth_wheel.Unschedule(t->index, t->grow_due);
+	t->grow_due = 0;
+}
+
+/** Write back the grow_counter of all scheduled towns, e.g. for saving. */
+void SyncTownGrowCounters()
+{
+	for (Town *t : Town::Iterate()) {
+		t->grow_counter = t->GetGrowCounter();
+	}
+}
+
+/** Rebuild the growth schedule from scratch, e.g. after loading a game. */
+void RebuildTownGrowthSchedule()
+{
+	_town_growth_wheel.Clear();
+
+	for (Town *t : Town::Iterate()) {
+		t->grow_due = 0;
+		ScheduleTownGrowth(t);
+	}
+}
+
+/** Forget about all scheduled towns. */
+void InitializeTowns()
+{
+	_town_growth_wheel.Clear();
+}
+
 static void TownTickHandler(Town *t)
 {
-	if (HasBit(t->flags, TOWN_IS_GROWING)) {
-		int i = (int)t->grow_counter - 1;
-		if (i < 0) {
-			if (GrowTown(t)) {
-				i = t->growth_rate;
-			} else {
-				/* If growth failed wait a bit before retrying */
-				i = std::min<uint16>(t->growth_rate, TOWN_GROWTH_TICKS - 1);
-			}
-		}
-		t->grow_counter = i;
+	/* The grow counter ran out; the wheel already dropped the town. */
+	t->grow_due = 0;
+	t->grow_counter = 0;
+
+	int i;
+	if (GrowTown(t)) {
+		i = t->growth_rate;
+	} else {
+		/* If growth failed wait a bit before retrying */
+		i = std::min<uint16>(t->growth_rate, TOWN_GROWTH_TICKS - 1);
 	}
+
+	/* Building houses may have rescheduled the town already. */
+	UnscheduleTownGrowth(t);
+	t->grow_counter = i;
+	ScheduleTownGrowth(t);
 }
 
 void OnTick_Town()
 {
 	if (_game_mode == GM_EDITOR) return;
 
-	for (Town *t : Town::Iterate()) {
-		TownTickHandler(t);
+	/* Only growing towns whose counter runs out need attention. They are
+	 * handled in index order, like it was done when scanning all of them. */
+	static std::vector<TownID> due;
+	_town_growth_wheel.Advance(due);
+
+	for (TownID index : due) {
+		TownTickHandler(Town::Get(index));
 	}
 }
 
@@ -2868,6 +2951,7 @@ CommandCost CmdTownGrowthRate(TileIndex tile, DoCommandFlag flags, uint32 p1, ui
 			/* Just clear the flag, UpdateTownGrowth will determine a proper growth rate */
 			ClrBit(t->flags, TOWN_CUSTOM_GROWTH);
 		} else {
+			UnscheduleTownGrowth(t);
 			uint old_rate = t->growth_rate;
 			if (t->grow_counter >= old_rate) {
 				/* This also catches old_rate == 0 */
@@ -3214,7 +3298,9 @@ static CommandCost TownActionFundBuildings(Town *t, DoCommandFlag flags)
 		 * tick-perfect and gives player some time window where they can
 		 * spam funding with the exact same efficiency.
 		 */
+		UnscheduleTownGrowth(t);
 		t->grow_counter = std::min<uint16>(t->grow_counter, 2 * TOWN_GROWTH_TICKS - (t->growth_rate - t->grow_counter) % TOWN_GROWTH_TICKS);
+		ScheduleTownGrowth(t);
 
 		SetWindowDirty(WC_TOWN_VIEW, t->index);
 	}
@@ -3259,6 +3345,7 @@ static CommandCost TownActionBribe(Town *t, DoCommandFlag flags)
 			for (Station *st : Station::Iterate()) {
 				if (st->town == t && st->owner == _current_company) {
 					for (CargoID i = 0; i < NUM_CARGO; i++) st->goods[i].rating = 0;
+					st->rating_cargoes = ALL_CARGOTYPES;
 				}
 			}
 
@@ -3487,9 +3574,11 @@ static uint GetNormalGrowthRate(Town *t)
 static void UpdateTownGrowthRate(Town *t)
 {
 	if (HasBit(t->flags, TOWN_CUSTOM_GROWTH)) return;
+	UnscheduleTownGrowth(t);
 	uint old_rate = t->growth_rate;
 	t->growth_rate = GetNormalGrowthRate(t);
 	UpdateTownGrowCounter(t, old_rate);
+	ScheduleTownGrowth(t);
 	SetWindowDirty(WC_TOWN_VIEW, t->index);
 }
 
@@ -3501,6 +3590,7 @@ static void UpdateTownGrowth(Town *t)
 {
 	UpdateTownGrowthRate(t);
 
+	UnscheduleTownGrowth(t);
 	ClrBit(t->flags, TOWN_IS_GROWING);
 	SetWindowDirty(WC_TOWN_VIEW, t->index);
 
@@ -3525,6 +3615,7 @@ static void UpdateTownGrowth(Town *t)
 
 	if (HasBit(t->flags, TOWN_CUSTOM_GROWTH)) {
 		if (t->growth_rate != TOWN_GROWTH_RATE_NONE) SetBit(t->flags, TOWN_IS_GROWING);
+		ScheduleTownGrowth(t);
 		SetWindowDirty(WC_TOWN_VIEW, t->index);
 		return;
 	}
@@ -3532,6 +3623,7 @@ static void UpdateTownGrowth(Town *t)
 	if (t->fund_buildings_months == 0 && CountActiveStations(t) == 0 && !Chance16(1, 12)) return;
 
 	SetBit(t->flags, TOWN_IS_GROWING);
+	ScheduleTownGrowth(t);
 	SetWindowDirty(WC_TOWN_VIEW, t->index);
 }
 
@@ -1516,33 +1516,32 @@ static void MarkTrainAsStuck(Train *v)
 
 /**
  * Swap the two up/down flags in two ways:
- * - Swap values of \a swap_flag1 and \a swap_flag2, and
+ * - Swap values of the flags of \a a and \a b, and
  * - If going up previously (#GVF_GOINGUP_BIT set), the #GVF_GOINGDOWN_BIT is set, and vice versa.
- * @param[in,out] swap_flag1 First train flag.
- * @param[in,out] swap_flag2 Second train flag.
+ * @param a First train part.
+ * @param b Second train part.
  */
-static void SwapTrainFlags(uint16 *swap_flag1, uint16 *swap_flag2)
+static void SwapTrainFlags(Train *a, Train *b)
 {
-	uint16 flag1 = *swap_flag1;
-	uint16 flag2 = *swap_flag2;
-
-	/* Clear the flags */
-	ClrBit(*swap_flag1, GVF_GOINGUP_BIT);
-	ClrBit(*swap_flag1, GVF_GOINGDOWN_BIT);
-	ClrBit(*swap_flag2, GVF_GOINGUP_BIT);
-	ClrBit(*swap_flag2, GVF_GOINGDOWN_BIT);
+	uint16 flag1 = a->gv_flags;
+	uint16 flag2 = b->gv_flags;
+	uint16 slope_flags1 = 0;
+	uint16 slope_flags2 = 0;
 
 	/* Reverse the rail-flags (if needed) */
 	if (HasBit(flag1, GVF_GOINGUP_BIT)) {
-		SetBit(*swap_flag2, GVF_GOINGDOWN_BIT);
+		SetBit(slope_flags2, GVF_GOINGDOWN_BIT);
 	} else if (HasBit(flag1, GVF_GOINGDOWN_BIT)) {
-		SetBit(*swap_flag2, GVF_GOINGUP_BIT);
+		SetBit(slope_flags2, GVF_GOINGUP_BIT);
 	}
 	if (HasBit(flag2, GVF_GOINGUP_BIT)) {
-		SetBit(*swap_flag1, GVF_GOINGDOWN_BIT);
+		SetBit(slope_flags1, GVF_GOINGDOWN_BIT);
 	} else if (HasBit(flag2, GVF_GOINGDOWN_BIT)) {
-		SetBit(*swap_flag1, GVF_GOINGUP_BIT);
+		SetBit(slope_flags1, GVF_GOINGUP_BIT);
 	}
+
+	a->SetSlopeFlags(slope_flags1);
+	b->SetSlopeFlags(slope_flags2);
 }
 
 /**
@@ -1609,7 +1608,7 @@ void ReverseTrainSwapVeh(Train *v, int l, int r)
 		Swap(a->tile,  b->tile);
 		Swap(a->z_pos, b->z_pos);
 
-		SwapTrainFlags(&a->gv_flags, &b->gv_flags);
+		SwapTrainFlags(a, b);
 
 		UpdateStatusAfterSwap(a);
 		UpdateStatusAfterSwap(b);
@@ -1617,7 +1616,7 @@ void ReverseTrainSwapVeh(Train *v, int l, int r)
 		/* Swap GVF_GOINGUP_BIT/GVF_GOINGDOWN_BIT.
 		 * This is a little bit redundant way, a->gv_flags will
 		 * be (re)set twice, but it reduces code duplication */
-		SwapTrainFlags(&a->gv_flags, &a->gv_flags);
+		SwapTrainFlags(a, a);
 		UpdateStatusAfterSwap(a);
 	}
 }
@@ -3088,6 +3087,23 @@ static Vehicle *CheckTrainAtSignal(Vehicle *v, void *data)
 	return t;
 }
 
+/**
+ * Check whether moving within a tile can have any effect for a train part that is not the front engine.
+ * On plain rail, level crossings and stations only the front engine is acted upon when it moves
+ * within the tile, so there is no need to call #VehicleEnterTile for the other parts.
+ * @param tile The tile the part moves within.
+ * @return True if #VehicleEnterTile has to be called for the part.
+ */
+static inline bool TrainPartNeedsEnterTile(TileIndex tile)
+{
+	switch (GetTileType(tile)) {
+		case MP_RAILWAY: return IsRailDepot(tile);
+		case MP_ROAD:
+		case MP_STATION: return false;
+		default: return true;
+	}
+}
+
 /**
  * Move a vehicle chain one movement stop forwards.
  * @param v First vehicle to move.
@@ -3121,13 +3137,17 @@ bool TrainController(Train *v, Vehicle *nomove, bool reverse)
 					/* Reverse when we are at the end of the track already, do not move to the new position */
 					if (v->IsFrontEngine() && !TrainCheckIfLineEnds(v, reverse)) return false;
 
-					uint32 r = VehicleEnterTile(v, gp.new_tile, gp.x, gp.y);
-					if (HasBit(r, VETS_CANNOT_ENTER)) {
-						goto invalid_rail;
-					}
-					if (HasBit(r, VETS_ENTERED_STATION)) {
-						/* The new position is the end of the platform */
-						TrainEnterStation(v, r >> VETS_STATION_ID_OFFSET);
+					/* The parts following the front engine only move along tiles the front engine
+					 * already passed; most of those tiles do not care where on the tile they are. */
+					if (v->IsFrontEngine() || TrainPartNeedsEnterTile(gp.new_tile)) {
+						uint32 r = VehicleEnterTile(v, gp.new_tile, gp.x, gp.y);
+						if (HasBit(r, VETS_CANNOT_ENTER)) {
+							goto invalid_rail;
+						}
+						if (HasBit(r, VETS_ENTERED_STATION)) {
+							/* The new position is the end of the platform */
+							TrainEnterStation(v, r >> VETS_STATION_ID_OFFSET);
+						}
 					}
 				}
 			} else {
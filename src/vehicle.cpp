@@ -365,37 +365,132 @@ byte VehicleRandomBits()
 	return GB(Random(), 0, 8);
 }
 
-/* Size of the hash, 6 = 64 x 64, 7 = 128 x 128. Larger sizes will (in theory) reduce hash
- * lookup times at the expense of memory usage. */
-const int HASH_BITS = 7;
-const int HASH_SIZE = 1 << HASH_BITS;
-const int HASH_MASK = HASH_SIZE - 1;
-const int TOTAL_HASH_SIZE = 1 << (HASH_BITS * 2);
-const int TOTAL_HASH_MASK = TOTAL_HASH_SIZE - 1;
-
-/* Resolution of the hash, 0 = 1*1 tile, 1 = 2*2 tiles, 2 = 4*4 tiles, etc.
- * Profiling results show that 0 is fastest. */
-const int HASH_RES = 0;
-
-static Vehicle *_vehicle_tile_hash[TOTAL_HASH_SIZE];
-
-static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, void *data, VehicleFromPosProc *proc, bool find_first)
-{
-	for (int y = yl; ; y = (y + (1 << HASH_BITS)) & (HASH_MASK << HASH_BITS)) {
-		for (int x = xl; ; x = (x + 1) & HASH_MASK) {
-			Vehicle *v = _vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
-			for (; v != nullptr; v = v->hash_tile_next) {
+/* Maximum size of the tile hash, 20 = 1024 x 1024 buckets. On larger maps a bucket covers multiple tiles. */
+static const uint MAX_TILE_HASH_BITS = 20;
+
+static uint _tile_hash_res;    ///< Resolution of the tile hash, 0 = 1*1 tile, 1 = 2*2 tiles, 2 = 4*4 tiles, etc.
+static uint _tile_hash_bits_x; ///< Number of bits of the bucket X coordinate.
+static uint _tile_hash_bits_y; ///< Number of bits of the bucket Y coordinate.
+
+/** Chains of vehicles by the tile they are on; each bucket covers a square chunk of the map. */
+static std::vector<Vehicle *> _vehicle_tile_hash;
+/** Chains of only the road vehicles by the tile they are on, with the same buckets as #_vehicle_tile_hash. */
+static std::vector<RoadVehicle *> _road_vehicle_tile_hash;
+
+/**
+ * Get the bucket X coordinate in the tile hash.
+ * @param x X coordinate of a tile; coordinates outside of the map wrap around.
+ * @return The bucket X coordinate.
+ */
+static inline uint GetTileHashX(int x)
+{
+	return GB(x, _tile_hash_res, _tile_hash_bits_x);
+}
+
+/**
+ * Get the bucket Y coordinate in the tile hash.
+ * @param y Y coordinate of a tile; coordinates outside of the map wrap around.
+ * @return The bucket Y coordinate.
+ */
+static inline uint GetTileHashY(int y)
+{
+	return GB(y, _tile_hash_res, _tile_hash_bits_y);
+}
+
+/**
+ * Get the bucket of the tile hash for some bucket coordinates.
+ * @param x Bucket X coordinate.
+ * @param y Bucket Y coordinate.
+ * @return The head of the vehicle chain of the bucket.
+ */
+static inline Vehicle **GetTileHashBucket(uint x, uint y)
+{
+	return &_vehicle_tile_hash[x | (y << _tile_hash_bits_x)];
+}
+
+/**
+ * Size the tile hash for the current map and empty it.
+ * The buckets are as small as possible, so tiles far apart never share a
+ * bucket, but the number of buckets is limited on larger maps.
+ */
+static void ResetVehicleTileHash()
+{
+	_tile_hash_res = 0;
+	while (MapLogX() + MapLogY() - 2 * _tile_hash_res > MAX_TILE_HASH_BITS) _tile_hash_res++;
+	_tile_hash_bits_x = MapLogX() - _tile_hash_res;
+	_tile_hash_bits_y = MapLogY() - _tile_hash_res;
+
+	_vehicle_tile_hash.assign((size_t)1 << (_tile_hash_bits_x + _tile_hash_bits_y), nullptr);
+	_road_vehicle_tile_hash.assign(_vehicle_tile_hash.size(), nullptr);
+}
+
+/**
+ * Helper function for the functions finding vehicles near a position in a tile hash.
+ * @tparam T Type of the vehicles in the hash.
+ * @tparam Tnext Member with the next vehicle in a chain of the hash.
+ * @param hash The tile hash to search.
+ * @param x    The X location on the map
+ * @param y    The Y location on the map
+ * @param data Arbitrary data passed to proc
+ * @param proc The proc that determines whether a vehicle will be "found".
+ * @param find_first Whether to return on the first found or iterate over
+ *                   all vehicles
+ * @return the best matching or first vehicle (depending on find_first).
+ */
+template <class T, T *T::*Tnext>
+static Vehicle *VehicleFromTileHashXY(const std::vector<T *> &hash, int x, int y, void *data, VehicleFromPosProc *proc, bool find_first)
+{
+	const int COLL_DIST = 6;
+
+	/* Hash area to scan is from xl,yl to xu,yu */
+	uint xl = GetTileHashX((x - COLL_DIST) / TILE_SIZE);
+	uint xu = GetTileHashX((x + COLL_DIST) / TILE_SIZE);
+	uint yl = GetTileHashY((y - COLL_DIST) / TILE_SIZE);
+	uint yu = GetTileHashY((y + COLL_DIST) / TILE_SIZE);
+
+	const uint mask_x = (1 << _tile_hash_bits_x) - 1;
+	const uint mask_y = (1 << _tile_hash_bits_y) - 1;
+
+	for (uint hy = yl; ; hy = (hy + 1) & mask_y) {
+		for (uint hx = xl; ; hx = (hx + 1) & mask_x) {
+			T *v = hash[hx | (hy << _tile_hash_bits_x)];
+			for (; v != nullptr; v = v->*Tnext) {
 				Vehicle *a = proc(v, data);
 				if (find_first && a != nullptr) return a;
 			}
-			if (x == xu) break;
+			if (hx == xu) break;
 		}
-		if (y == yu) break;
+		if (hy == yu) break;
 	}
 
 	return nullptr;
 }
 
+/**
+ * Helper function for the functions finding vehicles on a tile in a tile hash.
+ * @tparam T Type of the vehicles in the hash.
+ * @tparam Tnext Member with the next vehicle in a chain of the hash.
+ * @param hash The tile hash to search.
+ * @param tile The location on the map
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The proc that determines whether a vehicle will be "found".
+ * @param find_first Whether to return on the first found or iterate over
+ *                   all vehicles
+ * @return the best matching or first vehicle (depending on find_first).
+ */
+template <class T, T *T::*Tnext>
+static Vehicle *VehicleFromTileHash(const std::vector<T *> &hash, TileIndex tile, void *data, VehicleFromPosProc *proc, bool find_first)
+{
+	T *v = hash[GetTileHashX(TileX(tile)) | (GetTileHashY(TileY(tile)) << _tile_hash_bits_x)];
+	for (; v != nullptr; v = v->*Tnext) {
+		if (v->tile != tile) continue;
+
+		Vehicle *a = proc(v, data);
+		if (find_first && a != nullptr) return a;
+	}
+
+	return nullptr;
+}
 
 /**
  * Helper function for FindVehicleOnPos/HasVehicleOnPos.
@@ -410,15 +505,7 @@ static Vehicle *VehicleFromTileHash(int xl, int yl, int xu, int yu, void *data,
  */
 static Vehicle *VehicleFromPosXY(int x, int y, void *data, VehicleFromPosProc *proc, bool find_first)
 {
-	const int COLL_DIST = 6;
-
-	/* Hash area to scan is from xl,yl to xu,yu */
-	int xl = GB((x - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int xu = GB((x + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS);
-	int yl = GB((y - COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
-	int yu = GB((y + COLL_DIST) / TILE_SIZE, HASH_RES, HASH_BITS) << HASH_BITS;
-
-	return VehicleFromTileHash(xl, yl, xu, yu, data, proc, find_first);
+	return VehicleFromTileHashXY<Vehicle, &Vehicle::hash_tile_next>(_vehicle_tile_hash, x, y, data, proc, find_first);
 }
 
 /**
@@ -468,18 +555,7 @@ bool HasVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc)
  */
 static Vehicle *VehicleFromPos(TileIndex tile, void *data, VehicleFromPosProc *proc, bool find_first)
 {
-	int x = GB(TileX(tile), HASH_RES, HASH_BITS);
-	int y = GB(TileY(tile), HASH_RES, HASH_BITS) << HASH_BITS;
-
-	Vehicle *v = _vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
-	for (; v != nullptr; v = v->hash_tile_next) {
-		if (v->tile != tile) continue;
-
-		Vehicle *a = proc(v, data);
-		if (find_first && a != nullptr) return a;
-	}
-
-	return nullptr;
+	return VehicleFromTileHash<Vehicle, &Vehicle::hash_tile_next>(_vehicle_tile_hash, tile, data, proc, find_first);
 }
 
 /**
@@ -515,6 +591,44 @@ bool HasVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
 	return VehicleFromPos(tile, data, proc, true) != nullptr;
 }
 
+/**
+ * Find a road vehicle near a specific location. Like #FindVehicleOnPosXY, but
+ * \a proc is only called for road vehicles, so there are fewer vehicles to check.
+ * @param x    The X location on the map
+ * @param y    The Y location on the map
+ * @param data Arbitrary data passed to proc
+ * @param proc The proc that determines whether a vehicle will be "found".
+ */
+void FindRoadVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc)
+{
+	VehicleFromTileHashXY<RoadVehicle, &RoadVehicle::hash_road_next>(_road_vehicle_tile_hash, x, y, data, proc, false);
+}
+
+/**
+ * Find a road vehicle on a specific location. Like #FindVehicleOnPos, but
+ * \a proc is only called for road vehicles, so there are fewer vehicles to check.
+ * @param tile The location on the map
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The proc that determines whether a vehicle will be "found".
+ */
+void FindRoadVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
+{
+	VehicleFromTileHash<RoadVehicle, &RoadVehicle::hash_road_next>(_road_vehicle_tile_hash, tile, data, proc, false);
+}
+
+/**
+ * Checks whether a road vehicle is on a specific location. Like #HasVehicleOnPos, but
+ * \a proc is only called for road vehicles, so there are fewer vehicles to check.
+ * @param tile The location on the map
+ * @param data Arbitrary data passed to \a proc.
+ * @param proc The \a proc that determines whether a vehicle will be "found".
+ * @return True if proc returned non-nullptr.
+ */
+bool HasRoadVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc)
+{
+	return VehicleFromTileHash<RoadVehicle, &RoadVehicle::hash_road_next>(_road_vehicle_tile_hash, tile, data, proc, true) != nullptr;
+}
+
 /**
  * Callback that returns 'real' vehicles lower or at height \c *(int*)data .
  * @param v Vehicle to examine.
@@ -609,6 +723,28 @@ CommandCost EnsureNoTrainOnTrackBits(TileIndex tile, TrackBits track_bits)
 	return CommandCost();
 }
 
+/**
+ * Move a road vehicle to the same bucket in the road vehicle tile hash as in the tile hash.
+ * @param v The road vehicle.
+ * @param old_hash The bucket of the tile hash the vehicle was in, or nullptr.
+ * @param new_hash The bucket of the tile hash the vehicle moves to, or nullptr.
+ */
+static void UpdateRoadVehicleTileHash(RoadVehicle *v, Vehicle **old_hash, Vehicle **new_hash)
+{
+	if (old_hash != nullptr) {
+		if (v->hash_road_next != nullptr) v->hash_road_next->hash_road_prev = v->hash_road_prev;
+		*v->hash_road_prev = v->hash_road_next;
+	}
+
+	if (new_hash != nullptr) {
+		RoadVehicle **bucket = &_road_vehicle_tile_hash[new_hash - _vehicle_tile_hash.data()];
+		v->hash_road_next = *bucket;
+		if (v->hash_road_next != nullptr) v->hash_road_next->hash_road_prev = &v->hash_road_next;
+		v->hash_road_prev = bucket;
+		*bucket = v;
+	}
+}
+
 static void UpdateVehicleTileHash(Vehicle *v, bool remove)
 {
 	Vehicle **old_hash = v->hash_tile_current;
@@ -617,13 +753,13 @@ static void UpdateVehicleTileHash(Vehicle *v, bool remove)
 	if (remove) {
 		new_hash = nullptr;
 	} else {
-		int x = GB(TileX(v->tile), HASH_RES, HASH_BITS);
-		int y = GB(TileY(v->tile), HASH_RES, HASH_BITS) << HASH_BITS;
-		new_hash = &_vehicle_tile_hash[(x + y) & TOTAL_HASH_MASK];
+		new_hash = GetTileHashBucket(GetTileHashX(TileX(v->tile)), GetTileHashY(TileY(v->tile)));
 	}
 
 	if (old_hash == new_hash) return;
 
+	if (v->type == VEH_ROAD) UpdateRoadVehicleTileHash(RoadVehicle::From(v), old_hash, new_hash);
+
 	/* Remove from the old position in the hash table */
 	if (old_hash != nullptr) {
 		if (v->hash_tile_next != nullptr) v->hash_tile_next->hash_tile_prev = v->hash_tile_prev;
@@ -672,7 +808,31 @@ void ResetVehicleHash()
 {
 	for (Vehicle *v : Vehicle::Iterate()) { v->hash_tile_current = nullptr; }
 	memset(_vehicle_viewport_hash, 0, sizeof(_vehicle_viewport_hash));
-	memset(_vehicle_tile_hash, 0, sizeof(_vehicle_tile_hash));
+	ResetVehicleTileHash();
+}
+
+/**
+ * Get statistics about the occupancy of the vehicle tile hash.
+ * @return The statistics.
+ */
+VehicleTileHashStats GetVehicleTileHashStats()
+{
+	VehicleTileHashStats stats = {};
+	stats.chunk_size = 1 << _tile_hash_res;
+	stats.buckets = (uint)_vehicle_tile_hash.size();
+
+	for (const Vehicle *head : _vehicle_tile_hash) {
+		if (head == nullptr) continue;
+
+		uint length = 0;
+		for (const Vehicle *v = head; v != nullptr; v = v->hash_tile_next) length++;
+
+		stats.used_buckets++;
+		stats.vehicles += length;
+		stats.longest_chain = std::max(stats.longest_chain, length);
+	}
+
+	return stats;
 }
 
 void ResetVehicleColourMap()
@@ -804,6 +964,7 @@ void Vehicle::PreDestructor()
 	if (Station::IsValidID(this->last_station_visited)) {
 		Station *st = Station::Get(this->last_station_visited);
 		st->loading_vehicles.remove(this);
+		UpdateLoadingStation(st);
 
 		HideFillingPercent(&this->fill_percent_te_id);
 		this->CancelReservation(INVALID_STATION, st);
@@ -945,7 +1106,7 @@ void CallVehicleTicks()
 
 	{
 		PerformanceMeasurer framerate(PFE_GL_ECONOMY);
-		for (Station *st : Station::Iterate()) LoadUnloadStation(st);
+		for (StationID index : _loading_stations) LoadUnloadStation(Station::Get(index));
 	}
 	PerformanceAccumulator::Reset(PFE_GL_TRAINS);
 	PerformanceAccumulator::Reset(PFE_GL_ROADVEHS);
@@ -2275,6 +2436,7 @@ void Vehicle::LeaveStation()
 	Station *st = Station::Get(this->last_station_visited);
 	this->CancelReservation(INVALID_STATION, st);
 	st->loading_vehicles.remove(this);
+	UpdateLoadingStation(st);
 
 	HideFillingPercent(&this->fill_percent_te_id);
 	trip_occupancy = CalcPercentVehicleFilled(this, nullptr);
@@ -44,6 +44,9 @@ void FindVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
 void FindVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc);
 bool HasVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
 bool HasVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc);
+void FindRoadVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
+void FindRoadVehicleOnPosXY(int x, int y, void *data, VehicleFromPosProc *proc);
+bool HasRoadVehicleOnPos(TileIndex tile, void *data, VehicleFromPosProc *proc);
 void CallVehicleTicks();
 uint8 CalcPercentVehicleFilled(const Vehicle *v, StringID *colour);
 
@@ -51,6 +54,17 @@ void VehicleLengthChanged(const Vehicle *u);
 
 byte VehicleRandomBits();
 void ResetVehicleHash();
+
+/** Occupancy of the hash of vehicles by the tile they are on. */
+struct VehicleTileHashStats {
+	uint chunk_size;    ///< Size of the square of tiles covered by a bucket.
+	uint buckets;       ///< Number of buckets.
+	uint used_buckets;  ///< Number of buckets with at least one vehicle.
+	uint vehicles;      ///< Number of vehicles in the hash.
+	uint longest_chain; ///< Largest number of vehicles in a single bucket.
+};
+
+VehicleTileHashStats GetVehicleTileHashStats();
 void ResetVehicleColourMap();
 
 byte GetBestFittingSubType(Vehicle *v_from, Vehicle *v_for, CargoID dest_cargo_type);
@@ -5,7 +5,12 @@
  * See the GNU General Public License for more details. You should have received a copy of the GNU General Public License along with OpenTTD. If not, see <http://www.gnu.org/licenses/>.
  */
 
-/** @file water_map.h Map accessors for water tiles. */
+/**
+ * @file water_map.h Map accessors for water tiles.
+ * @note What ships can pass on a tile only changes by rebuilding it with one of the Make* functions,
+ *       which all go through #SetTileType and so invalidate the water region of the tile. Functions
+ *       that change the water tracks of an existing tile must call #InvalidateWaterRegion themselves.
+ */
 
 #ifndef WATER_MAP_H
 #define WATER_MAP_H